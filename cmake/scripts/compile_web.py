@@ -31,6 +31,7 @@ def execute_cmdline(cmd, working_dir):
 def main():
 	argParser = argparse.ArgumentParser(description="Build the web based emulator using Emscripten via Ninja")
 	argParser.add_argument("--build-debug",		default=False, action="store_true",		help="Specify building the debug binaries")
+	argParser.add_argument("--simd-threads",	default=False, action="store_true",		help="Build the wasm simd128 and Web Worker variant")
 
 	args = argParser.parse_args()
 
@@ -41,11 +42,13 @@ def main():
 	cmake_cache_path	= os.path.abspath(os.path.join(cur_path, "CMakeCache.txt"))
 
 	build_debug			= args.build_debug
+	simd_threads		= args.simd_threads
 
 	log_msg(None, "")
 	log_msg("Source", source_path)
 	log_msg("Relative", source_path_rel)
 	log_msg("Debug", build_debug)
+	log_msg("SIMD threads", simd_threads)
 	log_msg("Toolchain", toolchain_path)
 	log_msg("CMake cache", cmake_cache_path)
 	log_msg(None, "")
@@ -58,7 +61,7 @@ def main():
 		log_msg("Cleaning", "Deleting current cmake cache file")
 		os.remove(cmake_cache_path)
 
-	generate_cmdline = "cmake -DCMAKE_TOOLCHAIN_FILE=\"{0}\" -DCMAKE_BUILD_TYPE={1} -DEMSCRIPTEN_GENERATE_BITCODE_STATIC_LIBRARIES=ON -GNinja {2}".format(toolchain_path, "Debug" if build_debug else "Release", source_path_rel)
+	generate_cmdline = "cmake -DCMAKE_TOOLCHAIN_FILE=\"{0}\" -DCMAKE_BUILD_TYPE={1} -DEMSCRIPTEN_GENERATE_BITCODE_STATIC_LIBRARIES=ON -DGB_WEB_SIMD_THREADS={2} -GNinja {3}".format(toolchain_path, "Debug" if build_debug else "Release", "ON" if simd_threads else "OFF", source_path_rel)
 	log_msg("CMake command", generate_cmdline)
 	res = execute_cmdline(generate_cmdline, cur_path)
 
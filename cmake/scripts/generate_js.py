@@ -2,6 +2,7 @@
 import argparse
 import os
 import shutil
+import subprocess
 import sys
 
 log_tag_width	= 20
@@ -50,11 +51,41 @@ def compile(input_file, output_file, functions):
 	log_msg("Compile", "{} -> {}".format(input_file, output_file))
 	return emscripten.Building.emcc(input_file, emcc_args, output_file)
 
+def compile_simd_threads(input_file, output_file, functions):
+	## simd128 needs the upstream LLVM backend, which no longer exposes
+	## Building.emcc, so the compiler is invoked directly.
+	EMSCRIPTEN_ROOT = os.environ.get("EMSCRIPTEN_ROOT")
+	emcc = os.path.join(EMSCRIPTEN_ROOT, "emcc") if EMSCRIPTEN_ROOT else "emcc"
+
+	exported_functions = "EXPORTED_FUNCTIONS=[%s]" % (", ".join("\"%s\"" % t for t in functions))
+
+	## Memory can't grow, the page holds views of the shared buffer the
+	## frame ring lives in. Two pool threads cover trace and capture draining.
+	emcc_args = [
+		'-O3',
+		'-msimd128',
+		'-pthread',
+		'-s', exported_functions,
+		'-s', 'EXPORTED_RUNTIME_METHODS=["HEAPU8"]',
+		'-s', 'WASM=1',
+		'-s', 'USE_PTHREADS=1',
+		'-s', 'PTHREAD_POOL_SIZE=2',
+		'-s', 'ALLOW_MEMORY_GROWTH=0',
+		'-s', 'INITIAL_MEMORY=33554432',
+		'-s', 'ENVIRONMENT=web,worker,node',
+		'-s', 'EXIT_RUNTIME=0',
+		'-s', 'DISABLE_EXCEPTION_CATCHING=1'
+		]
+
+	log_msg("Compile", "{} -> {} (simd128, threads)".format(input_file, output_file))
+	return subprocess.call([emcc] + emcc_args + [input_file, "-o", output_file])
+
 def main():
 	argParser = argparse.ArgumentParser(description="Compile emscripten byte-code into raw javascript")
 	argParser.add_argument("-i", "--input")
 	argParser.add_argument("-o", "--output")
 	argParser.add_argument("-f", "--functions")
+	argParser.add_argument("--simd-threads",	default=False, action="store_true",	help="Build the wasm simd128 and shared memory variant")
 
 	args = argParser.parse_args()
 
@@ -83,6 +114,9 @@ def main():
 		log_msg("Cleaning", "Deleting current file: {0}".format(output_file))
 		os.remove(output_file)
 
+	if args.simd_threads:
+		return compile_simd_threads(input_file, output_file, functions)
+
 	return compile(input_file, output_file, functions)
 
 if __name__ == "__main__":
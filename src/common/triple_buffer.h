@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace common
+{
+	//--------------------------------------------------------------------------
+
+	// Lock-free triple buffer between one producer and one consumer, used by
+	// the front ends to hand frames between threads. The producer fills the
+	// back item and publishes it, the consumer swaps in the newest published
+	// item when it wants one. Neither side ever waits, items the consumer
+	// didn't get to in time are replaced by newer ones.
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		inline TripleBuffer(const T& initial = T());
+
+		// Producer.
+		inline T& get_write();
+		inline void publish();
+
+		// Consumer, update returns true if a newer item was swapped in.
+		inline bool update();
+		inline const T& get_read() const;
+
+	private:
+		static const uint32_t kIndexMask		= 0x3;
+		static const uint32_t kFresh			= 0x4;	// Middle holds an item the consumer hasn't seen.
+		static const uint32_t kCacheLineSize	= 64;
+
+		T						m_items[3];
+		uint32_t				m_back;		// Producer only.
+		uint32_t				m_front;	// Consumer only.
+		uint8_t					m_pad0[kCacheLineSize];
+		std::atomic<uint32_t>	m_middle;
+		uint8_t					m_pad1[kCacheLineSize - sizeof(std::atomic<uint32_t>)];
+	};
+
+	//--------------------------------------------------------------------------
+
+	template<typename T>
+	inline TripleBuffer<T>::TripleBuffer(const T& initial)
+		: m_back(0)
+		, m_front(1)
+		, m_middle(2)
+	{
+		for(uint32_t i = 0; i < 3; i++)
+			m_items[i] = initial;
+	}
+
+	template<typename T>
+	inline T& TripleBuffer<T>::get_write()
+	{
+		return m_items[m_back];
+	}
+
+	template<typename T>
+	inline void TripleBuffer<T>::publish()
+	{
+		m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	template<typename T>
+	inline bool TripleBuffer<T>::update()
+	{
+		if((m_middle.load(std::memory_order_relaxed) & kFresh) == 0)
+			return false;
+
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+
+	template<typename T>
+	inline const T& TripleBuffer<T>::get_read() const
+	{
+		return m_items[m_front];
+	}
+
+	//--------------------------------------------------------------------------
+}
@@ -4,7 +4,7 @@ using namespace gbhw;
 
 namespace
 {
-	QString ArgValuesToString(const gbhw::Instruction& instruction, gbhw_context_t hardware)
+	QString ArgValuesToString(const gbhw::Instruction& instruction, gbhw::Address address, gbhw_context_t hardware)
 	{
 		QString res;
 
@@ -57,13 +57,13 @@ namespace
 				case gbhw::RTD::PC: argstr = QString::asprintf("0x%04x", registers->pc); break;
 				case gbhw::RTD::Imm8:
 				{
-					argstr = QString::asprintf("0x%02x", mmu->read_byte(instruction.address() + immoffset));
+					argstr = QString::asprintf("0x%02x", mmu->peek_byte(address + immoffset));
 					immoffset += 1;
 					break;
 				}
 				case gbhw::RTD::SImm8:
 				{
-					gbhw::Byte byte = mmu->read_byte(instruction.address() + immoffset);
+					gbhw::Byte byte = mmu->peek_byte(address + immoffset);
 					int32_t signedByte = 0;
 
 					if ((byte & 0x80) == 0x80)
@@ -79,7 +79,7 @@ namespace
 					gbhw::Byte opcode = instruction.opcode();
 					if (opcode == 0x18 || opcode == 0x20 || opcode == 0x28 || opcode == 0x30 || opcode == 0x38)
 					{
-						gbhw::Address targetAddress = static_cast<gbhw::Address>(static_cast<int32_t>(instruction.address() + instruction.byte_size()) + signedByte);
+						gbhw::Address targetAddress = static_cast<gbhw::Address>(static_cast<int32_t>(address + instruction.byte_size()) + signedByte);
 						argstr = QString::asprintf("0x%02x (%d) [0x%04x]", byte, signedByte, targetAddress);
 					}
 					else
@@ -91,28 +91,28 @@ namespace
 				}
 				case gbhw::RTD::Imm16:
 				{
-					argstr = QString::asprintf("0x%04x", mmu->read_word(instruction.address() + immoffset));
+					argstr = QString::asprintf("0x%04x", mmu->peek_word(address + immoffset));
 					immoffset += 2;
 					break;
 				}
 				case gbhw::RTD::Addr8:
 				{
-					gbhw::Byte imm8 = mmu->read_byte(instruction.address() + immoffset);
+					gbhw::Byte imm8 = mmu->peek_byte(address + immoffset);
 					immoffset += 2;
-					argstr = QString::asprintf("0xFF00 + 0x%02x [0x%02x]", imm8, mmu->read_byte(0xFF00 + imm8));
+					argstr = QString::asprintf("0xFF00 + 0x%02x [0x%02x]", imm8, mmu->peek_byte(0xFF00 + imm8));
 					break;
 				}
 				case gbhw::RTD::Addr16:
 				{
-					gbhw::Address imm16 = mmu->read_word(instruction.address() + immoffset);
+					gbhw::Address imm16 = mmu->peek_word(address + immoffset);
 					immoffset += 2;
-					argstr = QString::asprintf("0x%04x [0x%04x]", imm16, mmu->read_byte(imm16));
+					argstr = QString::asprintf("0x%04x [0x%04x]", imm16, mmu->peek_byte(imm16));
 					break;
 				}
-				case gbhw::RTD::AddrC: argstr = QString::asprintf("0xFF00 + 0x%02x [0x%04x]", registers->c, mmu->read_word(0xFF00 + registers->c)); break;
-				case gbhw::RTD::AddrBC: argstr = QString::asprintf("0x%04x [0x%04x]", registers->bc, mmu->read_word(registers->bc)); break;
-				case gbhw::RTD::AddrDE: argstr = QString::asprintf("0x%04x [0x%04x]", registers->de, mmu->read_word(registers->de)); break;
-				case gbhw::RTD::AddrHL: argstr = QString::asprintf("0x%04x [0x%04x]", registers->hl, mmu->read_word(registers->hl)); break;
+				case gbhw::RTD::AddrC: argstr = QString::asprintf("0xFF00 + 0x%02x [0x%04x]", registers->c, mmu->peek_word(0xFF00 + registers->c)); break;
+				case gbhw::RTD::AddrBC: argstr = QString::asprintf("0x%04x [0x%04x]", registers->bc, mmu->peek_word(registers->bc)); break;
+				case gbhw::RTD::AddrDE: argstr = QString::asprintf("0x%04x [0x%04x]", registers->de, mmu->peek_word(registers->de)); break;
+				case gbhw::RTD::AddrHL: argstr = QString::asprintf("0x%04x [0x%04x]", registers->hl, mmu->peek_word(registers->hl)); break;
 				case gbhw::RTD::FlagZ: argstr = QString::asprintf("Zero: %s", registers->is_flag_set(gbhw::RF::Zero) ? "true" : "false"); break;
 				case gbhw::RTD::FlagNZ: argstr = QString::asprintf("Not-Zero: %s", registers->is_flag_set(gbhw::RF::Zero) ? "false" : "true"); break;
 				case gbhw::RTD::FlagC: argstr = QString::asprintf("Zero: %s", registers->is_flag_set(gbhw::RF::Carry) ? "true" : "false"); break;
@@ -143,18 +143,29 @@ namespace
 		return res;
 	}
 
-	QString GenerateInstructionString(const gbhw::Instruction& instruction, gbhw_context_t hardware)
+	QString GenerateInstructionString(const gbhw::DisasmLine& line, gbhw_context_t hardware)
 	{
+		CPU* cpu;
+
+		if(gbhw_get_cpu(hardware, &cpu) != e_success)
+		{
+			return "Error";
+		}
+
+		const bool bExtended = (line.bytes[0] == 0xCB);
+		const gbhw::Instruction& instruction = cpu->get_instruction(bExtended ? line.bytes[1] : line.bytes[0], bExtended);
+
 		QString text;
-		QString args = ArgValuesToString(instruction, hardware);
+		QString args = ArgValuesToString(instruction, line.address, hardware);
+		QString label = QString::asprintf("%-24s", line.symbol ? line.symbol : "");
 
 		if (instruction.opcode() == 0xCB)
 		{
-			text = QString::asprintf("0x%04x : 0x%02x : 0x%02x : %2u/%2u : %2u : %2u : %-12s : %s", instruction.address(), instruction.opcode(), instruction.is_extended(), instruction.cycles(InstructionResult::Passed), instruction.cycles(InstructionResult::Failed), instruction.byte_size(), 0, instruction.assembly(), args.toStdString().c_str());
+			text = QString::asprintf("%s 0x%04x : 0x%02x : 0x%02x : %2u/%2u : %2u : %2u : %-12s : %s", label.toStdString().c_str(), line.address, instruction.opcode(), instruction.is_extended(), instruction.cycles(InstructionResult::Passed), instruction.cycles(InstructionResult::Failed), instruction.byte_size(), 0, instruction.assembly(), args.toStdString().c_str());
 		}
 		else
 		{
-			text = QString::asprintf("0x%04x : 0x%02x : ---- : %2u/%2u : %2u : %2u : %-12s : %s", instruction.address(), instruction.opcode(), instruction.cycles(InstructionResult::Passed), instruction.cycles(InstructionResult::Failed), instruction.byte_size(), 0, instruction.assembly(), args.toStdString().c_str());
+			text = QString::asprintf("%s 0x%04x : 0x%02x : ---- : %2u/%2u : %2u : %2u : %-12s : %s", label.toStdString().c_str(), line.address, instruction.opcode(), instruction.cycles(InstructionResult::Passed), instruction.cycles(InstructionResult::Failed), instruction.byte_size(), 0, instruction.assembly(), args.toStdString().c_str());
 		}
 
 		return text;
@@ -177,11 +188,11 @@ namespace gbd
 {
 	AssemblyWidget::AssemblyWidget(QWidget* parent)
 		: QListWidget(parent)
-		, m_hardware(nullptr)
+		, m_emulator(nullptr)
 	{
 		m_brushBreakpoint.setColor(Qt::red);
 
-		m_instructions.reserve(kInstructionDisplayWindowSize);
+		m_disasm.resize(kInstructionDisplayWindowSize);
 
 		// Create assembly widgets
 		for (int32_t i = 0; i < kInstructionDisplayWindowSize; ++i)
@@ -201,17 +212,19 @@ namespace gbd
 	{
 	}
 
-	void AssemblyWidget::SetHardware(gbhw_context_t hardware)
+	void AssemblyWidget::SetEmulator(Emulator* emulator)
 	{
-		m_hardware = hardware;
+		m_emulator = emulator;
 	}
 
 	void AssemblyWidget::UpdateView()
 	{
-		Registers* registers;
-		gbhw_get_registers(m_hardware, &registers);
+		// Disassembly reads memory, only safe while the emulation thread is parked.
+		if(!m_emulator->IsPaused())
+			return;
 
-		gbhw::Address currentPC = registers->pc;
+		gbhw_context_t hardware = m_emulator->GetHardware();
+		gbhw::Address currentPC = m_emulator->GetSnapshot().registers.pc;
 
 		QListWidgetItem* foundItem = nullptr;
 
@@ -234,16 +247,18 @@ namespace gbd
 		else
 		{
 
-			// Refresh view entirely.
-			m_instructions.clear();
+			// Refresh view entirely, lines come from the disassembly cache.
+			uint32_t count = 0;
+			m_disasm.resize(kInstructionDisplayWindowSize);
 
-			// @todo: Move disam into core properly.
-			if(gbhw_disasm(m_hardware, currentPC, m_instructions, kInstructionDisplayWindowSize) != e_success)
+			if(gbhw_disasm_lines(hardware, currentPC, m_disasm.data(), kInstructionDisplayWindowSize, &count) != e_success)
 				return;
 
-			for(int32_t i = 0; i < kInstructionDisplayWindowSize; ++i)
+			m_disasm.resize(count);
+
+			for(int32_t i = 0; i < static_cast<int32_t>(count); ++i)
 			{
-				gbhw::Address instructionAddress = m_instructions[i].address();
+				gbhw::Address instructionAddress = m_disasm[i].address;
 
 				m_lines[i]->setData(AssemblyData::Address, QVariant(instructionAddress));
 
@@ -273,9 +288,9 @@ namespace gbd
 		}
 
 		// Update all the strings in view.
-		for (int32_t i = 0; i < kInstructionDisplayWindowSize; ++i)
+		for (size_t i = 0; i < m_disasm.size(); ++i)
 		{
-			m_lines[i]->setText(GenerateInstructionString(m_instructions[i], m_hardware));
+			m_lines[i]->setText(GenerateInstructionString(m_disasm[i], hardware));
 		}
 	}
 
@@ -299,20 +314,20 @@ namespace gbd
 			{
 				item->setForeground(m_brushBreakpoint);
 				m_breakpoints.push_back(instructionaddress);
-		//		m_hardware->GetCPU().BreakpointSet(instructionaddress);
 			}
 			else
 			{
 				item->setForeground(m_brushDefault);
-				m_breakpoints.erase(std::remove(m_breakpoints.begin(), m_breakpoints.end(), instructionaddress));
-		//		m_hardware->GetCPU().BreakpointRemove(instructionaddress);
+				m_breakpoints.erase(std::remove(m_breakpoints.begin(), m_breakpoints.end(), instructionaddress), m_breakpoints.end());
 			}
+
+			m_emulator->SetBreakpoints(m_breakpoints);
 		}
 	}
 
 	void AssemblyWidget::AddBreakpoint(gbhw::Address address)
 	{
 		m_breakpoints.push_back(address);
-//		m_hardware->GetCPU().BreakpointSet(address);
+		m_emulator->SetBreakpoints(m_breakpoints);
 	}
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <QListWidget>
 
 typedef std::vector<QListWidgetItem*> InstructionItemList;
@@ -16,15 +16,15 @@ namespace gbd
 		AssemblyWidget(QWidget* parent = nullptr);
 		~AssemblyWidget();
 
-		void SetHardware(gbhw_context_t hardware);
+		void SetEmulator(Emulator* emulator);
 		void UpdateView();
 		void ToggleBreakpoint();
 
 	private:
 		void AddBreakpoint(uint16_t address);
 
-		gbhw_context_t			m_hardware;
-		gbhw::InstructionList	m_instructions;
+		Emulator*				m_emulator;
+		std::vector<gbhw::DisasmLine>	m_disasm;
 		InstructionItemList		m_lines;
 		BreakpointList			m_breakpoints;
 		QBrush					m_brushDefault;
@@ -0,0 +1,294 @@
+#include "gbd_emulator.h"
+
+#include <string.h>
+
+using namespace gbhw;
+
+namespace gbd
+{
+	namespace
+	{
+		// 70224 cycles per frame at 4.194304MHz, ~59.73Hz.
+		const std::chrono::nanoseconds kFramePeriod(16742706);
+
+		// Snapshots are only worth publishing as often as they can be shown.
+		const std::chrono::milliseconds kSnapshotPeriod(16);
+
+		// Falling further behind than this restarts the pacing clock.
+		const std::chrono::milliseconds kMaxLag(100);
+
+		const uint32_t kButtonCount = button_dpad_down + 1;
+
+		uint64_t GetFrameNumber(gbhw_context_t hardware)
+		{
+			gbhw_screen_dirty_t dirty;
+			gbhw_get_screen_dirty(hardware, &dirty);
+			return dirty.frame;
+		}
+	}
+
+	Snapshot::Snapshot()
+		: frame(0)
+		, bPaused(true)
+		, bBreakpoint(false)
+		, screen(GPU::kScreenWidth * GPU::kScreenHeight * sizeof(uint32_t))
+	{
+	}
+
+	Emulator::Emulator(gbhw_context_t hardware)
+		: m_hardware(hardware)
+		, m_command(Command::None)
+		, m_bCommandPending(false)
+		, m_bCommandResult(false)
+		, m_bPaused(true)
+		, m_bPaced(true)
+		, m_buttons(0)
+		, m_bBreakpoint(false)
+		, m_appliedButtons(0)
+	{
+		m_thread = std::thread(&Emulator::ThreadMain, this);
+	}
+
+	Emulator::~Emulator()
+	{
+		Execute(Command::Quit);
+		m_thread.join();
+	}
+
+	gbhw_context_t Emulator::GetHardware() const
+	{
+		return m_hardware;
+	}
+
+	bool Emulator::IsPaused() const
+	{
+		return m_bPaused;
+	}
+
+	bool Emulator::LoadRom(const std::string& path)
+	{
+		m_commandPath = path;
+		Execute(Command::LoadRom);
+		return m_bCommandResult;
+	}
+
+	void Emulator::Run()
+	{
+		Execute(Command::Run);
+	}
+
+	void Emulator::Pause()
+	{
+		Execute(Command::Pause);
+	}
+
+	void Emulator::StepInstruction()
+	{
+		Execute(Command::StepInstruction);
+	}
+
+	void Emulator::SetBreakpoints(const std::vector<Address>& breakpoints)
+	{
+		m_commandBreakpoints = breakpoints;
+		Execute(Command::SetBreakpoints);
+	}
+
+	void Emulator::SetPaced(bool bPaced)
+	{
+		m_bPaced = bPaced;
+	}
+
+	void Emulator::SetButtonState(gbhw_button_t button, gbhw_button_state_t state)
+	{
+		if(state == button_pressed)
+			m_buttons.fetch_or(1u << button, std::memory_order_relaxed);
+		else
+			m_buttons.fetch_and(~(1u << button), std::memory_order_relaxed);
+	}
+
+	bool Emulator::UpdateSnapshot()
+	{
+		return m_snapshots.update();
+	}
+
+	const Snapshot& Emulator::GetSnapshot() const
+	{
+		return m_snapshots.get_read();
+	}
+
+	void Emulator::Execute(Command::Type command)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_command = command;
+		m_bCommandPending.store(true, std::memory_order_release);
+		m_commandCv.notify_one();
+
+		m_doneCv.wait(lock, [this] { return m_command == Command::None; });
+	}
+
+	void Emulator::ThreadMain()
+	{
+		Clock::time_point deadline = Clock::now();
+
+		for(;;)
+		{
+			// Parked while paused, while running commands are only picked up
+			// between frames.
+			if(m_bPaused || m_bCommandPending.load(std::memory_order_acquire))
+			{
+				Command::Type command;
+
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_commandCv.wait(lock, [this] { return (m_command != Command::None) || !m_bPaused; });
+					command = m_command;
+				}
+
+				if(command != Command::None)
+				{
+					ProcessCommand(command);
+
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						m_command = Command::None;
+						m_bCommandPending.store(false, std::memory_order_relaxed);
+					}
+
+					m_doneCv.notify_all();
+
+					if(command == Command::Quit)
+						return;
+
+					deadline = Clock::now();
+					continue;
+				}
+			}
+
+			if(m_bPaced)
+			{
+				const Clock::time_point now = Clock::now();
+
+				if(now > (deadline + kMaxLag))
+					deadline = now;
+
+				std::this_thread::sleep_until(deadline);
+				deadline += std::chrono::duration_cast<Clock::duration>(kFramePeriod);
+			}
+
+			ApplyButtons();
+
+			if(!RunFrame())
+			{
+				m_bPaused = true;
+				Publish();
+			}
+			else if((Clock::now() - m_lastPublish) >= kSnapshotPeriod)
+			{
+				Publish();
+			}
+		}
+	}
+
+	void Emulator::ProcessCommand(Command::Type command)
+	{
+		switch(command)
+		{
+			case Command::LoadRom:
+				m_bPaused			= true;
+				m_bCommandResult	= gbhw_load_rom_file(m_hardware, m_commandPath.c_str()) == e_success;
+				Publish();
+				break;
+
+			case Command::Run:
+				m_bBreakpoint	= false;
+				m_bPaused		= false;
+				break;
+
+			case Command::Pause:
+				m_bPaused = true;
+				Publish();
+				break;
+
+			case Command::StepInstruction:
+				if(m_bPaused)
+				{
+					ApplyButtons();
+					gbhw_step(m_hardware, step_instruction);
+					Publish();
+				}
+				break;
+
+			case Command::SetBreakpoints:
+				gbhw_clear_breakpoints(m_hardware);
+
+				// The disassembly doesn't track banks, so breakpoints match any.
+				for(Address address : m_commandBreakpoints)
+					gbhw_add_breakpoint(m_hardware, address, -1);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	bool Emulator::RunFrame()
+	{
+		if(gbhw_step(m_hardware, step_vsync) != e_success)
+			return false;
+
+		// Breakpoints are evaluated by the hardware, which returns early when
+		// one fires. Continuing runs past the breakpoint at the current PC.
+		gbhw_break_t info;
+		gbhw_get_break(m_hardware, &info);
+
+		if(info.reason != break_none)
+		{
+			m_bBreakpoint = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	void Emulator::ApplyButtons()
+	{
+		const uint32_t buttons = m_buttons.load(std::memory_order_relaxed);
+		const uint32_t changed = buttons ^ m_appliedButtons;
+
+		for(uint32_t i = 0; i < kButtonCount; i++)
+		{
+			if(changed & (1u << i))
+				gbhw_set_button_state(m_hardware, static_cast<gbhw_button_t>(i), (buttons & (1u << i)) ? button_pressed : button_released);
+		}
+
+		m_appliedButtons = buttons;
+	}
+
+	void Emulator::Publish()
+	{
+		Snapshot& snapshot = m_snapshots.get_write();
+
+		Registers* registers	= nullptr;
+		GPU* gpu				= nullptr;
+		const uint8_t* screen	= nullptr;
+
+		gbhw_get_registers(m_hardware, &registers);
+		gbhw_get_gpu(m_hardware, &gpu);
+		gbhw_get_screen(m_hardware, &screen);
+
+		snapshot.frame			= GetFrameNumber(m_hardware);
+		snapshot.bPaused		= m_bPaused;
+		snapshot.bBreakpoint	= m_bBreakpoint;
+		snapshot.registers		= *registers;
+		snapshot.tileRam		= *gpu->get_tile_ram();
+
+		for(uint32_t i = 0; i < GPUPalette::Count; i++)
+			snapshot.palettes[i] = *gpu->get_palette(static_cast<GPUPalette::Type>(i));
+
+		memcpy(&snapshot.screen[0], screen, snapshot.screen.size());
+
+		m_snapshots.publish();
+		m_lastPublish = Clock::now();
+	}
+}
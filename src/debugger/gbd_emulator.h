@@ -0,0 +1,106 @@
+#pragma once
+
+#include <gbhw_debug.h>
+#include <triple_buffer.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gbd
+{
+	// Copy of the hardware state the widgets draw, published by the emulation
+	// thread and never modified once published.
+	struct Snapshot
+	{
+		Snapshot();
+
+		uint64_t				frame;
+		bool					bPaused;
+		bool					bBreakpoint;		// Paused by reaching a breakpoint.
+		gbhw::Registers			registers;
+		std::vector<uint8_t>	screen;
+		gbhw::GPUTileRam		tileRam;
+		gbhw::GPUPalette		palettes[gbhw::GPUPalette::Count];
+	};
+
+	// Runs the hardware on a dedicated thread, either free or paced to the
+	// Game Boy's frame rate. Snapshots reach the GUI through a lock-free
+	// triple buffer while running, at most once per display refresh.
+	//
+	// Commands return once the emulation thread has carried them out. After
+	// Pause, StepInstruction or LoadRom the thread is parked, and the context
+	// may be read directly (disassembly, memory) until the next Run.
+	class Emulator
+	{
+	public:
+		Emulator(gbhw_context_t hardware);
+		~Emulator();
+
+		gbhw_context_t GetHardware() const;
+		bool IsPaused() const;
+
+		bool LoadRom(const std::string& path);
+		void Run();
+		void Pause();
+		void StepInstruction();
+		void SetBreakpoints(const std::vector<gbhw::Address>& breakpoints);
+
+		void SetPaced(bool bPaced);
+		void SetButtonState(gbhw_button_t button, gbhw_button_state_t state);
+
+		// GUI thread, swaps in the newest snapshot if there is one.
+		bool UpdateSnapshot();
+		const Snapshot& GetSnapshot() const;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Command
+		{
+			enum Type
+			{
+				None = 0,
+				LoadRom,
+				Run,
+				Pause,
+				StepInstruction,
+				SetBreakpoints,
+				Quit
+			};
+		};
+
+		void Execute(Command::Type command);
+		void ThreadMain();
+		void ProcessCommand(Command::Type command);
+		bool RunFrame();
+		void ApplyButtons();
+		void Publish();
+
+		gbhw_context_t				m_hardware;
+		std::thread					m_thread;
+		common::TripleBuffer<Snapshot>	m_snapshots;
+
+		// Command hand-off, the GUI waits for m_command to return to None.
+		std::mutex					m_mutex;
+		std::condition_variable		m_commandCv;
+		std::condition_variable		m_doneCv;
+		Command::Type				m_command;
+		std::atomic<bool>			m_bCommandPending;
+		std::string					m_commandPath;
+		std::vector<gbhw::Address>	m_commandBreakpoints;
+		bool						m_bCommandResult;
+
+		std::atomic<bool>			m_bPaused;
+		std::atomic<bool>			m_bPaced;
+		std::atomic<uint32_t>		m_buttons;			// Bit per gbhw_button_t, set while pressed.
+
+		// Emulation thread only.
+		bool						m_bBreakpoint;
+		uint32_t					m_appliedButtons;
+		Clock::time_point			m_lastPublish;
+	};
+}
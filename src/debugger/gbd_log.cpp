@@ -34,7 +34,7 @@ namespace gbd
 	{
 		va_list args;
 		va_start(args, format);
-		vsprintf_s(m_buffer[0], format, args);
+		vsnprintf(m_buffer[0], kMaxFormattedLength, format, args);
 		va_end(args);
 
 		MessageL(type, m_buffer[0]);
@@ -42,7 +42,7 @@ namespace gbd
 
 	void Log::MessageL(LogType::Type type, const char* message)
 	{
-		sprintf_s(m_buffer[1], "gbd  - [%s] | %s", LogType::ToStr(type), message);
+		snprintf(m_buffer[1], kMaxFormattedLength, "gbd  - [%s] | %s", LogType::ToStr(type), message);
 		MessageRaw(m_buffer[1]);
 	}
 
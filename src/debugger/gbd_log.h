@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gbd_types.h"
+#include <utility>
 
 namespace gbd
 {
@@ -42,30 +42,46 @@ namespace gbd
 		m_ui.m_toolbar->addAction(m_ui.m_actionStepInstruction);
 		m_ui.m_toolbar->addAction(m_ui.m_actionToggleBreakpoint);
 
+		m_actionLimitSpeed = m_ui.m_toolbar->addAction(tr("Limit Speed"));
+		m_actionLimitSpeed->setCheckable(true);
+		m_actionLimitSpeed->setChecked(true);
+
 		QObject::connect(m_ui.m_actionOpenRomFile,			&QAction::triggered, this, &MainWindow::OnOpenRomFileTriggered);
 		QObject::connect(m_ui.m_actionContinueEmulation,	&QAction::triggered, this, &MainWindow::OnContinueEmulationTriggered);
 		QObject::connect(m_ui.m_actionPauseEmulation,		&QAction::triggered, this, &MainWindow::OnPauseEmulationTriggered);
 		QObject::connect(m_ui.m_actionStepInstruction,		&QAction::triggered, this, &MainWindow::OnStepInstructionTriggered);
 		QObject::connect(m_ui.m_actionToggleBreakpoint,		&QAction::triggered, this, &MainWindow::OnToggleBreakpointTriggered);
+		QObject::connect(m_actionLimitSpeed,				&QAction::triggered, this, &MainWindow::OnLimitSpeedTriggered);
 
 		// Create hardware.
 		gbhw_settings_t settings = {0};
 		settings.log_callback = hw_log_callback;
 		gbhw_create(&settings, &m_hardware);
 
-		m_ui.m_assembly->SetHardware(m_hardware);
+		// Emulation runs on its own thread, the widgets draw from its snapshots.
+		m_emulator = new Emulator(m_hardware);
+
+		m_ui.m_assembly->SetEmulator(m_emulator);
 
 		// Create screen window
-		m_screenWindow = new ScreenWindow(this, m_hardware);
+		m_screenWindow = new ScreenWindow(this, m_emulator);
 		m_screenWindow->show();
 
 		// Create memory window
-		m_memoryWindow = new MemoryWindow(this, m_hardware);
+		m_memoryWindow = new MemoryWindow(this, m_emulator);
 		m_memoryWindow->show();
+
+		// Picks up new snapshots at display rate.
+		QObject::connect(&m_displayTimer, &QTimer::timeout, this, &MainWindow::OnDisplayUpdate);
+		m_displayTimer.start(16);
 	}
 
 	MainWindow::~MainWindow()
 	{
+		m_displayTimer.stop();
+
+		delete m_emulator;
+		gbhw_destroy(m_hardware);
 	}
 
 	void MainWindow::OpenRomFile(const std::string& path)
@@ -73,10 +89,24 @@ namespace gbd
 		std::cout << "Opening rom file: " << path << std::endl;
 
 		// load into the emulator, then parse the contents.
-		if(gbhw_load_rom_file(m_hardware, path.c_str()) == e_success)
+		if(m_emulator->LoadRom(path))
 		{
 			std::cout << "Successfully loaded rom file" << std::endl;
+
+			// RGBDS writes symbols next to the ROM with a .sym extension.
+			const std::string symbolPath = path.substr(0, path.find_last_of('.')) + ".sym";
+
+			if(gbhw_load_symbols(m_emulator->GetHardware(), symbolPath.c_str()) == e_success)
+			{
+				std::cout << "Loaded symbols: " << symbolPath << std::endl;
+			}
+
+			m_bPaused = true;
+			m_emulator->UpdateSnapshot();
+
+			UpdateStatusLabel();
 			UpdateCPUState();
+			UpdateGPUState();
 			UpdateAssemblyState();
 			m_memoryWindow->UpdateView();
 		}
@@ -88,11 +118,7 @@ namespace gbd
 
 	void MainWindow::UpdateCPUState()
 	{
-		Registers* registers;
-		if(gbhw_get_registers(m_hardware, &registers) != e_success)
-		{
-			return;
-		}
+		const Registers* registers = &m_emulator->GetSnapshot().registers;
 
 		m_ui.reg_a_->setText(QString::asprintf("0x%02x", registers->a));
 		m_ui.reg_b_->setText(QString::asprintf("0x%02x", registers->b));
@@ -147,11 +173,7 @@ namespace gbd
 
 			UpdateStatusLabel();
 
-			//m_hardware.SetExecuteMode(gbhw::ExecuteMode::SingleVSync);
-			//m_hardware.GetCPU().BreakpointSkip();
-
-			QObject::connect(&m_hardwareTimer, &QTimer::timeout, this, &MainWindow::OnRunningUpdate);
-			m_hardwareTimer.start(10);
+			m_emulator->Run();
 		}
 	}
 
@@ -159,11 +181,12 @@ namespace gbd
 	{
 		if (m_bPaused == false)
 		{
-			m_hardwareTimer.stop();
-			QObject::disconnect(&m_hardwareTimer, &QTimer::timeout, this, &MainWindow::OnRunningUpdate);
+			m_emulator->Pause();
+			m_emulator->UpdateSnapshot();
 			m_bPaused = true;
 
 			UpdateStatusLabel();
+			UpdateGPUState();
 			UpdateCPUState();
 			UpdateAssemblyState();
 			m_memoryWindow->UpdateView();
@@ -191,7 +214,8 @@ namespace gbd
 		if(m_bPaused == true)
 		{
 			// Perform a single instruction step, ensuring we skip the current breakpoint (if we're on one).
-			gbhw_step(m_hardware, step_instruction);
+			m_emulator->StepInstruction();
+			m_emulator->UpdateSnapshot();
 
 			UpdateCPUState();
 			UpdateGPUState();
@@ -205,19 +229,27 @@ namespace gbd
 		m_ui.m_assembly->ToggleBreakpoint();
 	}
 
-	void MainWindow::OnRunningUpdate()
+	void MainWindow::OnLimitSpeedTriggered(bool checked)
+	{
+		m_emulator->SetPaced(checked);
+	}
+
+	void MainWindow::OnDisplayUpdate()
 	{
-		// @todo Be accurate about this by pulling the cycle count from the emulator.
-		if(!m_bPaused)
+		if(!m_emulator->UpdateSnapshot())
+			return;
+
+		UpdateGPUState();
+
+		// The emulation thread parks itself on a breakpoint or a failed step.
+		if(!m_bPaused && m_emulator->GetSnapshot().bPaused)
 		{
-			gbhw_step(m_hardware, step_vsync);
-			UpdateGPUState();
+			m_bPaused = true;
+
+			UpdateStatusLabel();
+			UpdateCPUState();
+			UpdateAssemblyState();
+			m_memoryWindow->UpdateView();
 		}
-// @todo: Handle breakpoints.
-//
-// 		if(m_hardware.GetCPU().IsBreakpoint())
-// 		{
-// 			PauseEmulation();
-// 		}
 	}
 } // gbd
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gbd_emulator.h"
 #include "gbd_memorywindow.h"
 #include "gbd_screenwindow.h"
 #include "ui_gbd_mainwindow.h"
@@ -37,16 +38,19 @@ namespace gbd
 		void OnPauseEmulationTriggered(bool checked);
 		void OnStepInstructionTriggered(bool checked);
 		void OnToggleBreakpointTriggered(bool checked);
+		void OnLimitSpeedTriggered(bool checked);
 
-		void OnRunningUpdate();
+		void OnDisplayUpdate();
 
 		Ui::GBDMainWindowClass	m_ui;
 		gbhw_context_t			m_hardware;
+		Emulator*				m_emulator;
 		bool					m_bPaused;
 
 		QBrush					m_brushDefault;
 
-		QTimer					m_hardwareTimer;
+		QAction*				m_actionLimitSpeed;
+		QTimer					m_displayTimer;
 
 		ScreenWindow*			m_screenWindow;
 		MemoryWindow*			m_memoryWindow;
@@ -10,9 +10,9 @@ namespace
 
 namespace gbd
 {
-	MemoryWindow::MemoryWindow(QWidget* parent, gbhw_context_t hardware)
+	MemoryWindow::MemoryWindow(QWidget* parent, Emulator* emulator)
 		: QWidget(parent, Qt::Window)
-		, m_hardware(hardware)
+		, m_emulator(emulator)
 		, m_enteredAddress(0)
 	{
 		m_ui.setupUi(this);
@@ -65,8 +65,15 @@ namespace gbd
 		//Message("Entered address [%s], at address: %d\n", str.toStdString().c_str(), address);
 		gbhw::Byte lineBytes[16];
 
+		// Memory is read from the hardware, which is only safe while the
+		// emulation thread is parked.
+		if(!m_emulator->IsPaused())
+		{
+			return;
+		}
+
 		MMU* mmu;
-		if(gbhw_get_mmu(m_hardware, &mmu) != e_success)
+		if(gbhw_get_mmu(m_emulator->GetHardware(), &mmu) != e_success)
 		{
 			return;
 		}
@@ -76,7 +83,7 @@ namespace gbd
 		{
 			for (int32_t lineByte = 0; lineByte < 16; ++lineByte)
 			{
-				lineBytes[lineByte] = mmu->read_byte(address + lineByte);
+				lineBytes[lineByte] = mmu->peek_byte(address + lineByte);
 			}
 
 			QString lineText = QString::asprintf("0x%04x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x  %02x",
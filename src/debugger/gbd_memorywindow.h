@@ -1,7 +1,7 @@
 #pragma once
 
 #include "ui_gbd_memorywindow.h"
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <vector>
 #include <QtWidgets/QWidget>
 
@@ -14,7 +14,7 @@ namespace gbd
 		Q_OBJECT
 
 	public:
-		MemoryWindow(QWidget* parent, gbhw_context_t hardware);
+		MemoryWindow(QWidget* parent, Emulator* emulator);
 		~MemoryWindow();
 
 		void UpdateView();
@@ -24,7 +24,7 @@ namespace gbd
 
 	private:
 		Ui::GBDMemoryWindowClass	m_ui;
-		gbhw_context_t				m_hardware;
+		Emulator*					m_emulator;
 		MemoryLineList				m_lines;
 		gbhw::Address				m_enteredAddress;
 	};
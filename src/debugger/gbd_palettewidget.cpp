@@ -18,7 +18,7 @@ namespace gbd
 	PaletteWidget::PaletteWidget(QWidget* parent)
 		: QWidget(parent)
 		, m_image(kImageWidth, kImageHeight, QImage::Format::Format_RGBX8888)
-		, m_hardware(nullptr)
+		, m_emulator(nullptr)
 		, m_type(GPUPalette::Count)
 		, m_focusEntryIndex(kEntries)
 		, m_focusColourIndex(kColoursPerEntry)
@@ -30,9 +30,9 @@ namespace gbd
 	{
 	}
 
-	void PaletteWidget::initialise(gbhw_context_t hardware, gbhw::GPUPalette::Type type)
+	void PaletteWidget::initialise(const Emulator* emulator, gbhw::GPUPalette::Type type)
 	{
-		m_hardware = hardware;
+		m_emulator = emulator;
 		m_type = type;
 	}
 
@@ -40,16 +40,12 @@ namespace gbd
 	{
 		QPainter painter(this);
 
-		if (m_hardware)
+		if (m_emulator)
 		{
-			GPU* gpu = nullptr;
-			if(gbhw_get_gpu(m_hardware, &gpu) != e_success)
-				return;
-
 			if(m_type == GPUPalette::Count)
 				return;
 
-			const GPUPalette* palette = gpu->get_palette(m_type);
+			const GPUPalette* palette = &m_emulator->GetSnapshot().palettes[m_type];
 
 			// Read tile index from tilemap.
 			QRgb* dest = (QRgb*)m_image.scanLine(0);
@@ -87,7 +83,7 @@ namespace gbd
 	void PaletteWidget::mouseMoveEvent(QMouseEvent* evt)
 	{
 		// Update the image
-		if (m_hardware)
+		if (m_emulator && m_type != GPUPalette::Count)
 		{
 			uint32_t colourIndex = evt->pos().x() / kBlockSize;
 			uint32_t entryIndex = evt->pos().y() / kBlockSize;
@@ -102,11 +98,7 @@ namespace gbd
 				m_focusColourIndex = colourIndex;
 
 				// Emit colour.
-				GPU* gpu = nullptr;
-				if(gbhw_get_gpu(m_hardware, &gpu) != e_success)
-					return;
-
-				const auto palette = gpu->get_palette(m_type);
+				const auto palette = &m_emulator->GetSnapshot().palettes[m_type];
 				auto& colour = palette->entries[entryIndex][colourIndex];
 
 				PaletteFocusArgs args = { (uint32_t)(colour.values[0] | (colour.values[1] << 8)),
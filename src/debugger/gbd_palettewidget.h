@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <QWidget>
 
 namespace gbd
@@ -21,7 +21,7 @@ namespace gbd
 		PaletteWidget(QWidget* parent = nullptr);
 		~PaletteWidget();
 
-		void initialise(gbhw_context_t hardware, gbhw::GPUPalette::Type type);
+		void initialise(const Emulator* emulator, gbhw::GPUPalette::Type type);
 
 	protected:
 		void paintEvent(QPaintEvent* evt);
@@ -32,7 +32,7 @@ namespace gbd
 
 	private:
 		QImage					m_image;
-		gbhw_context_t			m_hardware;
+		const Emulator*			m_emulator;
 		gbhw::GPUPalette::Type	m_type;
 
 		uint32_t				m_focusEntryIndex;
@@ -16,7 +16,7 @@ namespace gbd
 
 	ScreenWidget::ScreenWidget(QWidget* parent)
 		: QWidget(parent)
-		, m_hardware(nullptr)
+		, m_emulator(nullptr)
 		, m_image(kImageWidth, kImageHeight, QImage::Format::Format_RGBX8888)
 		, m_scaleX(2.0f)
 		, m_scaleY(2.0f)
@@ -30,20 +30,19 @@ namespace gbd
 	{
 	}
 
-	void ScreenWidget::initialise(gbhw_context_t hardware)
+	void ScreenWidget::initialise(Emulator* emulator)
 	{
-		m_hardware = hardware;
+		m_emulator = emulator;
 	}
 
 	void ScreenWidget::paintEvent(QPaintEvent* evt)
 	{
 		QPainter painter(this);
 
-		if(m_hardware)
+		if(m_emulator)
 		{
 			QRgb* dst = (QRgb*)m_image.scanLine(0);
-			const uint8_t* src = nullptr;
-			gbhw_get_screen(m_hardware, &src);
+			const uint8_t* src = &m_emulator->GetSnapshot().screen[0];
 
 			for (uint32_t y = 0; y < kImageHeight; ++y)
 			{
@@ -72,19 +71,19 @@ namespace gbd
 
 	void ScreenWidget::on_key(QKeyEvent* evt, gbhw_button_state_t state)
 	{
-		if(!m_hardware)
+		if(!m_emulator)
 			return;
 
 		switch(evt->key())
 		{
-			case Qt::Key_Left:		gbhw_set_button_state(m_hardware, button_dpad_left, state); break;
-			case Qt::Key_Right:		gbhw_set_button_state(m_hardware, button_dpad_right, state); break;
-			case Qt::Key_Up:		gbhw_set_button_state(m_hardware, button_dpad_up, state); break;
-			case Qt::Key_Down:		gbhw_set_button_state(m_hardware, button_dpad_down, state); break;
-			case Qt::Key_Return:	gbhw_set_button_state(m_hardware, button_start, state); break;
-			case Qt::Key_Backspace: gbhw_set_button_state(m_hardware, button_select, state); break;
-			case Qt::Key_Space:		gbhw_set_button_state(m_hardware, button_a, state); break;
-			case Qt::Key_B:			gbhw_set_button_state(m_hardware, button_b, state); break;
+			case Qt::Key_Left:		m_emulator->SetButtonState(button_dpad_left, state); break;
+			case Qt::Key_Right:		m_emulator->SetButtonState(button_dpad_right, state); break;
+			case Qt::Key_Up:		m_emulator->SetButtonState(button_dpad_up, state); break;
+			case Qt::Key_Down:		m_emulator->SetButtonState(button_dpad_down, state); break;
+			case Qt::Key_Return:	m_emulator->SetButtonState(button_start, state); break;
+			case Qt::Key_Backspace: m_emulator->SetButtonState(button_select, state); break;
+			case Qt::Key_Space:		m_emulator->SetButtonState(button_a, state); break;
+			case Qt::Key_B:			m_emulator->SetButtonState(button_b, state); break;
 			default: break;
 		}
 	}
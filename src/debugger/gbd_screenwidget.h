@@ -1,6 +1,6 @@
 ﻿#pragma once
 
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <QPen>
 #include <QWidget>
 
@@ -14,7 +14,7 @@ namespace gbd
 		ScreenWidget(QWidget* parent = nullptr);
 		~ScreenWidget();
 
-		void initialise(gbhw_context_t hardware);
+		void initialise(Emulator* emulator);
 
 	protected:
 		void paintEvent(QPaintEvent* evt);
@@ -24,7 +24,7 @@ namespace gbd
 	private:
 		void on_key(QKeyEvent* evt, gbhw_button_state_t state);
 
-		gbhw_context_t		m_hardware;
+		Emulator*			m_emulator;
 		QImage				m_image;
 		float				m_scaleX;
 		float				m_scaleY;
@@ -5,23 +5,23 @@ using namespace gbhw;
 
 namespace gbd
 {
-	ScreenWindow::ScreenWindow(QWidget* parent, gbhw_context_t hardware)
+	ScreenWindow::ScreenWindow(QWidget* parent, Emulator* emulator)
 		: QWidget(parent, Qt::Window)
-		, m_hardware(hardware)
+		, m_emulator(emulator)
 	{
 		m_ui.setupUi(this);
 
-		m_ui.m_screen->initialise(m_hardware);
-		m_ui.m_tileDataBank0->initialise(m_hardware, 0);
-		m_ui.m_tileDataBank1->initialise(m_hardware, 1);
+		m_ui.m_screen->initialise(m_emulator);
+		m_ui.m_tileDataBank0->initialise(m_emulator, 0);
+		m_ui.m_tileDataBank1->initialise(m_emulator, 1);
 
-		m_ui.m_tileMap0->initialise(m_hardware, 0);
-		m_ui.m_tileMap1->initialise(m_hardware, 1);
+		m_ui.m_tileMap0->initialise(m_emulator, 0);
+		m_ui.m_tileMap1->initialise(m_emulator, 1);
 		QObject::connect(m_ui.m_tileMap0, &TileMapWidget::on_focus_change, this, &ScreenWindow::on_tilemap_focus_change);
 		QObject::connect(m_ui.m_tileMap1, &TileMapWidget::on_focus_change, this, &ScreenWindow::on_tilemap_focus_change);
 
-		m_ui.m_bgPalette->initialise(m_hardware, GPUPalette::BG);
-		m_ui.m_objPalette->initialise(m_hardware, GPUPalette::Sprite);
+		m_ui.m_bgPalette->initialise(m_emulator, GPUPalette::BG);
+		m_ui.m_objPalette->initialise(m_emulator, GPUPalette::Sprite);
 		QObject::connect(m_ui.m_bgPalette, &PaletteWidget::on_focus_change, this, &ScreenWindow::on_palette_focus_change);
 		QObject::connect(m_ui.m_objPalette, &PaletteWidget::on_focus_change, this, &ScreenWindow::on_palette_focus_change);
 	}
@@ -47,14 +47,10 @@ namespace gbd
 
 	void ScreenWindow::on_tilemap_focus_change(TileMapFocusArgs args)
 	{
-		if(!m_hardware)
+		if(!m_emulator)
 			return;
 
-		GPU* gpu = nullptr;
-		if(gbhw_get_gpu(m_hardware, &gpu) != e_success)
-			return;
-
-		const GPUTileRam* ram = gpu->get_tile_ram();
+		const GPUTileRam* ram = &m_emulator->GetSnapshot().tileRam;
 		const Byte tileIndex = ram->tileMap[args.map][args.tile];
 
 		// @todo:
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gbd_emulator.h"
 #include "ui_gbd_screenwindow.h"
 #include <QtWidgets/QWidget>
 
@@ -10,7 +11,7 @@ namespace gbd
 		Q_OBJECT
 
 	public:
-		ScreenWindow(QWidget* parent, gbhw_context_t hardware);
+		ScreenWindow(QWidget* parent, Emulator* emulator);
 		~ScreenWindow();
 
 	private:
@@ -18,6 +19,6 @@ namespace gbd
 		void on_tilemap_focus_change(TileMapFocusArgs args);
 
 		Ui::GBDScreenWindowClass	m_ui;
-		gbhw_context_t				m_hardware;
+		Emulator*					m_emulator;
 	};
 }
\ No newline at end of file
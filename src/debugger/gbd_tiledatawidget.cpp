@@ -31,8 +31,10 @@ namespace gbd
 	TileDataWidget::TileDataWidget(QWidget* parent)
 		: QWidget(parent)
 		, m_image(kImageWidth, kImageHeight, QImage::Format::Format_RGBX8888)
-		, m_hardware(nullptr)
+		, m_emulator(nullptr)
 		, m_bank(0)
+		, m_bImageValid(false)
+		, m_generation(0)
 		, m_scaleX(2.0f)
 		, m_scaleY(2.0f)
 		, m_lockedTileIndex(-1)
@@ -46,49 +48,40 @@ namespace gbd
 	{
 	}
 
-	void TileDataWidget::initialise(gbhw_context_t hardware, uint32_t bank)
+	void TileDataWidget::initialise(const Emulator* emulator, uint32_t bank)
 	{
-		m_hardware = hardware;
+		m_emulator = emulator;
 		m_bank = bank;
+		m_bImageValid = false;
 	}
 
 	void TileDataWidget::paintEvent(QPaintEvent* evt)
 	{
 		QPainter painter(this);
 
-		// Update the image
-		if (m_hardware)
+		// Update the image, only redrawing tiles written since the last paint.
+		if (m_emulator)
 		{
-			GPU* gpu;
-			if(gbhw_get_gpu(m_hardware, &gpu) != e_success)
-				return;
-
-			const GPUTileRam*	ram			= gpu->get_tile_ram();
+			const GPUTileRam*	ram			= &m_emulator->GetSnapshot().tileRam;
 			const GPUTile*		tiles		= &ram->tileData[m_bank][0];
-			QRgb*				destData	= (QRgb*)m_image.scanLine(0);
-
-			// @todo: Use palettes to colour
+			const uint32_t*		generations	= &ram->tileGeneration[m_bank][0];
 
-			for(uint32_t tileIndex = 0; tileIndex < GPUTileRam::kTileDataCount; ++tileIndex)
+			if(!m_bImageValid || (ram->generation < m_generation))
 			{
-				uint32_t tileX = tileIndex % kTilesAcross;
-				uint32_t tileY = tileIndex / kTilesAcross;
-
-				// Offset to top line of tile.
-				QRgb* tileStart = destData + (tileY * kTileSize * kImageWidth) + (tileX * kTileSize);
-				const GPUTile* tile = &tiles[tileIndex];
-
-				for(uint32_t pixelY = 0; pixelY < kTileSize; ++pixelY)
+				for(uint32_t tileIndex = 0; tileIndex < GPUTileRam::kTileDataCount; ++tileIndex)
+					DrawTile(&tiles[tileIndex], tileIndex);
+			}
+			else if(ram->generation != m_generation)
+			{
+				for(uint32_t tileIndex = 0; tileIndex < GPUTileRam::kTileDataCount; ++tileIndex)
 				{
-					QRgb* tileLine = tileStart + (pixelY * kImageWidth);
-
-					for(uint32_t pixelX = 0; pixelX < kTileSize; ++pixelX)
-					{
- 						const Byte pixel = (3 - tile->pixels[pixelY][pixelX]) * 85;
- 						tileLine[pixelX] = qRgb(pixel, pixel, pixel);
-					}
+					if(generations[tileIndex] > m_generation)
+						DrawTile(&tiles[tileIndex], tileIndex);
 				}
 			}
+
+			m_bImageValid	= true;
+			m_generation	= ram->generation;
 		}
 
 		painter.scale(m_scaleX, m_scaleY);
@@ -106,6 +99,29 @@ namespace gbd
 		}
 	}
 
+	void TileDataWidget::DrawTile(const GPUTile* tile, uint32_t tileIndex)
+	{
+		const uint32_t tileX = tileIndex % kTilesAcross;
+		const uint32_t tileY = tileIndex / kTilesAcross;
+
+		// Offset to top line of tile.
+		QRgb* destData	= (QRgb*)m_image.scanLine(0);
+		QRgb* tileStart	= destData + (tileY * kTileSize * kImageWidth) + (tileX * kTileSize);
+
+		// @todo: Use palettes to colour
+
+		for(uint32_t pixelY = 0; pixelY < kTileSize; ++pixelY)
+		{
+			QRgb* tileLine = tileStart + (pixelY * kImageWidth);
+
+			for(uint32_t pixelX = 0; pixelX < kTileSize; ++pixelX)
+			{
+				const Byte pixel = (3 - tile->pixels[pixelY][pixelX]) * 85;
+				tileLine[pixelX] = qRgb(pixel, pixel, pixel);
+			}
+		}
+	}
+
 	void TileDataWidget::mousePressEvent(QMouseEvent* evt)
 	{
 		if(evt->button() != Qt::LeftButton)
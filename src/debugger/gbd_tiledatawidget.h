@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <QPen>
 #include <QWidget>
 
@@ -14,7 +14,7 @@ namespace gbd
 		TileDataWidget(QWidget* parent = nullptr);
 		~TileDataWidget();
 
-		void initialise(gbhw_context_t hardware, uint32_t bank);
+		void initialise(const Emulator* emulator, uint32_t bank);
 
 	protected:
 		void paintEvent(QPaintEvent* evt);
@@ -31,9 +31,13 @@ namespace gbd
 
 		void GetTileIndexFromMouseEvt(QMouseEvent* evt, int32_t& tileX, int32_t& tileY, int32_t& tileIndex, gbhw::Address& tileAddress);
 
+		void DrawTile(const gbhw::GPUTile* tile, uint32_t tileIndex);
+
 		QImage				m_image;
-		gbhw_context_t		m_hardware;
+		const Emulator*		m_emulator;
 		uint32_t			m_bank;
+		bool				m_bImageValid;
+		uint32_t			m_generation;		// Tile ram generation m_image was drawn from.
 		float				m_scaleX;
 		float				m_scaleY;
 		QPen				m_lockedPen;
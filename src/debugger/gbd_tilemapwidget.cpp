@@ -20,8 +20,11 @@ namespace gbd
 	TileMapWidget::TileMapWidget(QWidget* parent)
 		: QWidget(parent)
 		, m_image(kImageWidth, kImageHeight, QImage::Format::Format_RGBX8888)
-		, m_hardware(nullptr)
+		, m_emulator(nullptr)
 		, m_map(0)
+		, m_bImageValid(false)
+		, m_generation(0)
+		, m_paletteGeneration(0)
 		, m_focusIndex(kTilesAcross * kTilesDown)
 	{
 		setMouseTracking(true);
@@ -31,10 +34,11 @@ namespace gbd
 	{
 	}
 
-	void TileMapWidget::initialise(gbhw_context_t hardware, uint32_t map)
+	void TileMapWidget::initialise(const Emulator* emulator, uint32_t map)
 	{
-		m_hardware = hardware;
+		m_emulator = emulator;
 		m_map = map;
+		m_bImageValid = false;
 	}
 
 	void TileMapWidget::paintEvent(QPaintEvent* evt)
@@ -42,22 +46,15 @@ namespace gbd
 		QPainter painter(this);
 
 		// Update the image
-		if (m_hardware)
+		if (m_emulator)
 		{
-			MMU* mmu = nullptr;
-			if(gbhw_get_mmu(m_hardware, &mmu) != e_success)
-				return;
-
-			GPU* gpu = nullptr;
-			if(gbhw_get_gpu(m_hardware, &gpu) != e_success)
-				return;
-
 			// Read tile index from tilemap.
 
-			const GPUTileRam*			ram			= gpu->get_tile_ram();
+			const Snapshot&				snapshot	= m_emulator->GetSnapshot();
+			const GPUTileRam*			ram			= &snapshot.tileRam;
 			const Byte*					tileMap		= ram->tileMap[m_map];
 			const GPUAttributes*		tileAttr	= ram->tileAttr[m_map];
-			const GPUPalette*			palette		= gpu->get_palette(GPUPalette::BG);
+			const GPUPalette*			palette		= &snapshot.palettes[GPUPalette::BG];
 			QRgb*						destData	= (QRgb*)m_image.scanLine(0);
 
 			// Map 0 tiles start at 0x8800
@@ -66,13 +63,19 @@ namespace gbd
 			// overlap per-map.
 			// Address already translated to indices in storage.
 			const uint32_t				baseIndex	= m_map == 0 ? 128 : 0;
+			const uint32_t*				mapGen		= ram->mapGeneration[m_map];
 
-			for(uint32_t tileY = 0; tileY < kTilesDown; ++tileY)
+			// Entries are redrawn when they, the tile they show or the palette
+			// changed since the last paint. Anything else is still in m_image.
+			const bool bRedrawAll	= !m_bImageValid || (ram->generation < m_generation) || (palette->generation != m_paletteGeneration);
+			const bool bRedrawAny	= bRedrawAll || (ram->generation != m_generation);
+
+			for(uint32_t tileY = 0; bRedrawAny && (tileY < kTilesDown); ++tileY)
 			{
-				for(uint32_t tileX = 0; tileX < kTilesAcross; ++tileX)
+				for(uint32_t tileX = 0; tileX < kTilesAcross; ++tileX, ++tileMap, ++tileAttr, ++mapGen)
 				{
 					QRgb* tileStart = destData + (tileY * kTileSize * kImageWidth) + (tileX * kTileSize);
-					Byte tileIndex = *tileMap++;
+					Byte tileIndex = *tileMap;
 
 					// Tilemap 0 indices are signed. So convert to unsigned range
 					// as base is normalised to the -128 address, i.e 0 index is
@@ -80,10 +83,12 @@ namespace gbd
 					if(m_map == 0)
 						tileIndex ^= 0x80;
 
+					if(!bRedrawAll && (*mapGen <= m_generation) && (ram->tileGeneration[tileAttr->bank][baseIndex + tileIndex] <= m_generation))
+						continue;
+
 					//const GPUTileAttributes*	attr	= &tileAttr[baseIndex + tileIndex];
 					const GPUTile*				tile	= &ram->tileData[tileAttr->bank][baseIndex + tileIndex];
  					const GPUPaletteColour*		colours = palette->entries[tileAttr->palette];
-					tileAttr++;
 
 					for(uint32_t pixelY = 0; pixelY < kTileSize; ++pixelY)
 					{
@@ -98,6 +103,10 @@ namespace gbd
 					}
 				}
 			}
+
+			m_bImageValid		= true;
+			m_generation		= ram->generation;
+			m_paletteGeneration	= palette->generation;
 		}
 		else
 		{
@@ -110,12 +119,12 @@ namespace gbd
 
 	void TileMapWidget::mouseMoveEvent(QMouseEvent* evt)
 	{
-		if(m_hardware)
+		if(m_emulator)
 		{
 			const uint32_t tileX = evt->pos().x() / kTileSize;
 			const uint32_t tileY = evt->pos().y() / kTileSize;
 
-			if(tileX > kTilesAcross || tileY > kTilesDown)
+			if(tileX >= kTilesAcross || tileY >= kTilesDown)
 				return;
 
 			const uint32_t tileIndex = (tileY * kTilesAcross) + tileX;
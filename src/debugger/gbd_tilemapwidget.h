@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gbhw_debug.h>
+#include "gbd_emulator.h"
 #include <QWidget>
 
 namespace gbd
@@ -19,7 +19,7 @@ namespace gbd
 		TileMapWidget(QWidget* parent = nullptr);
 		~TileMapWidget();
 
-		void initialise(gbhw_context_t hardware, uint32_t map);
+		void initialise(const Emulator* emulator, uint32_t map);
 
 	protected:
 		void paintEvent(QPaintEvent* evt);
@@ -30,8 +30,11 @@ namespace gbd
 
 	private:
 		QImage				m_image;
-		gbhw_context_t		m_hardware;
+		const Emulator*		m_emulator;
 		uint32_t			m_map;
+		bool				m_bImageValid;
+		uint32_t			m_generation;			// Tile ram generation m_image was drawn from.
+		uint32_t			m_paletteGeneration;
 		uint32_t			m_focusIndex;
 	};
 }
\ No newline at end of file
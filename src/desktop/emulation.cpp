@@ -0,0 +1,207 @@
+#include "emulation.h"
+#include <string.h>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <timeapi.h>
+#endif
+
+namespace desktop
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		// 70224 cycles per frame at 4.194304MHz, ~59.73Hz.
+		const std::chrono::nanoseconds kFramePeriod(16742706);
+
+		// How far the display rate may pull emulation speed, 0.5% covers a
+		// 60Hz display without an audible or visible change in speed.
+		const double kMaxRateSkew = 0.005;
+
+		// Falling further behind than this, e.g. after the process was
+		// suspended, restarts the clock instead of running a burst of frames.
+		const std::chrono::milliseconds kMaxLag(100);
+
+		// Sleeps are only trusted to this accuracy, the rest is yielded away.
+		// Windows sleeps in whole timer ticks even at 1ms resolution.
+#ifdef WIN32
+		const std::chrono::microseconds kSleepMargin(1500);
+#else
+		const std::chrono::microseconds kSleepMargin(250);
+#endif
+
+		const uint32_t kButtonCount = button_dpad_down + 1;
+	}
+
+	//--------------------------------------------------------------------------
+
+	Emulation::Emulation(gbhw_context_t hardware, uint32_t width, uint32_t height)
+		: m_hardware(hardware)
+		, m_frames(Frame { std::vector<uint8_t>(width * height * sizeof(uint32_t)), gbhw_screen_dirty_t() })
+		, m_bRunning(false)
+		, m_bFailed(false)
+		, m_bFastForward(false)
+		, m_buttons(0)
+		, m_displayPeriod(0)
+		, m_appliedButtons(0)
+	{
+	}
+
+	Emulation::~Emulation()
+	{
+		stop();
+	}
+
+	void Emulation::start()
+	{
+		if(m_bRunning)
+			return;
+
+#ifdef WIN32
+		// Default timer resolution is ~15ms, far too coarse to pace frames.
+		timeBeginPeriod(1);
+#endif
+		m_bRunning = true;
+		m_thread = std::thread(&Emulation::run, this);
+	}
+
+	void Emulation::stop()
+	{
+		if(!m_thread.joinable())
+			return;
+
+		m_bRunning = false;
+		m_thread.join();
+
+#ifdef WIN32
+		timeEndPeriod(1);
+#endif
+	}
+
+	bool Emulation::is_running() const
+	{
+		return !m_bFailed;
+	}
+
+	void Emulation::set_button_state(gbhw_button_t button, gbhw_button_state_t state)
+	{
+		if(state == button_pressed)
+			m_buttons.fetch_or(1u << button, std::memory_order_relaxed);
+		else
+			m_buttons.fetch_and(~(1u << button), std::memory_order_relaxed);
+	}
+
+	void Emulation::set_fast_forward(bool bEnabled)
+	{
+		m_bFastForward.store(bEnabled, std::memory_order_relaxed);
+	}
+
+	void Emulation::set_display_period(double seconds)
+	{
+		m_displayPeriod.store(static_cast<int64_t>(seconds * 1e9), std::memory_order_relaxed);
+	}
+
+	bool Emulation::update_frame()
+	{
+		return m_frames.update();
+	}
+
+	const Frame& Emulation::get_frame() const
+	{
+		return m_frames.get_read();
+	}
+
+	//--------------------------------------------------------------------------
+
+	void Emulation::run()
+	{
+		Clock::time_point deadline = Clock::now();
+
+		while(m_bRunning)
+		{
+			// Frames are emulated at their deadline rather than ahead of it so
+			// input is sampled as late as possible.
+			if(!m_bFastForward.load(std::memory_order_relaxed))
+			{
+				const Clock::time_point now = Clock::now();
+
+				if(now > (deadline + kMaxLag))
+					deadline = now;
+
+				wait_until(deadline);
+				deadline += get_frame_period();
+			}
+			else
+			{
+				deadline = Clock::now();
+			}
+
+			apply_buttons();
+
+			if(gbhw_step(m_hardware, step_vsync) != e_success)
+			{
+				m_bFailed = true;
+				break;
+			}
+
+			publish_frame();
+		}
+	}
+
+	void Emulation::apply_buttons()
+	{
+		const uint32_t buttons = m_buttons.load(std::memory_order_relaxed);
+		const uint32_t changed = buttons ^ m_appliedButtons;
+
+		for(uint32_t i = 0; i < kButtonCount; i++)
+		{
+			if(changed & (1u << i))
+				gbhw_set_button_state(m_hardware, static_cast<gbhw_button_t>(i), (buttons & (1u << i)) ? button_pressed : button_released);
+		}
+
+		m_appliedButtons = buttons;
+	}
+
+	void Emulation::publish_frame()
+	{
+		Frame& frame = m_frames.get_write();
+		const uint8_t* screen = nullptr;
+
+		gbhw_get_screen(m_hardware, &screen);
+		gbhw_get_screen_dirty(m_hardware, &frame.dirty);
+		memcpy(&frame.pixels[0], screen, frame.pixels.size());
+
+		m_frames.publish();
+	}
+
+	Emulation::Clock::duration Emulation::get_frame_period() const
+	{
+		const std::chrono::nanoseconds display(m_displayPeriod.load(std::memory_order_relaxed));
+		const double skew = static_cast<double>(display.count()) / static_cast<double>(kFramePeriod.count());
+
+		if((skew >= (1.0 - kMaxRateSkew)) && (skew <= (1.0 + kMaxRateSkew)))
+			return std::chrono::duration_cast<Clock::duration>(display);
+
+		return std::chrono::duration_cast<Clock::duration>(kFramePeriod);
+	}
+
+	void Emulation::wait_until(Clock::time_point deadline) const
+	{
+		for(;;)
+		{
+			const Clock::duration remaining = deadline - Clock::now();
+
+			if(remaining <= Clock::duration::zero())
+				return;
+
+			if(remaining > kSleepMargin)
+				std::this_thread::sleep_for(remaining - kSleepMargin);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	//--------------------------------------------------------------------------
+}
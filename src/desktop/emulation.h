@@ -0,0 +1,73 @@
+#pragma once
+
+#include <gbhw.h>
+#include "triple_buffer.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace desktop
+{
+	//--------------------------------------------------------------------------
+
+	struct Frame
+	{
+		std::vector<uint8_t>	pixels;
+		gbhw_screen_dirty_t		dirty;		// dirty.frame numbers the frame, 0 before the first.
+	};
+
+	// Runs the hardware on its own thread, paced against a high resolution
+	// clock. Frames are handed to the presenting thread through a triple
+	// buffer so neither side waits on the other.
+	//
+	// The context must not be used by anything else while the thread runs.
+	class Emulation
+	{
+	public:
+		Emulation(gbhw_context_t hardware, uint32_t width, uint32_t height);
+		~Emulation();
+
+		void start();
+		void stop();
+
+		// False once the hardware failed to step.
+		bool is_running() const;
+
+		// Applied at the start of the next frame.
+		void set_button_state(gbhw_button_t button, gbhw_button_state_t state);
+
+		// Runs frames back to back without pacing.
+		void set_fast_forward(bool bEnabled);
+
+		// Measured refresh period of the display, 0 if unknown. When close
+		// enough to the Game Boy's the emulation runs at the display's rate
+		// so every refresh shows exactly one new frame.
+		void set_display_period(double seconds);
+
+		// Presenting thread, swaps in the newest frame if there is one.
+		bool update_frame();
+		const Frame& get_frame() const;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		void run();
+		void apply_buttons();
+		void publish_frame();
+		Clock::duration get_frame_period() const;
+		void wait_until(Clock::time_point deadline) const;
+
+		gbhw_context_t				m_hardware;
+		common::TripleBuffer<Frame>	m_frames;
+		std::thread					m_thread;
+		std::atomic<bool>			m_bRunning;
+		std::atomic<bool>			m_bFailed;
+		std::atomic<bool>			m_bFastForward;
+		std::atomic<uint32_t>		m_buttons;			// Bit per gbhw_button_t, set while pressed.
+		std::atomic<int64_t>		m_displayPeriod;	// Nanoseconds.
+		uint32_t					m_appliedButtons;	// Emulation thread only.
+	};
+
+	//--------------------------------------------------------------------------
+}
@@ -1,4 +1,5 @@
 #include <gbhw.h>
+#include "emulation.h"
 #include <SDL.h>
 #include <stdio.h>
 #include <type_traits>
@@ -31,6 +32,99 @@ namespace
 	{
 		log_message(msg);
 	}
+
+	inline bool is_line_dirty(const gbhw_screen_dirty_t& dirty, uint32_t line)
+	{
+		return (dirty.lines[line >> 5] & (1u << (line & 31))) != 0;
+	}
+
+	void update_dirty_lines(SDL_Texture* texture, const uint8_t* screen, uint32_t width, uint32_t height, const gbhw_screen_dirty_t& dirty)
+	{
+		// Screen data is generated as XRGB8 data packed into uint32_t.
+		const uint32_t pitch = width * sizeof(uint32_t);
+
+		if (dirty.count == height)
+		{
+			SDL_UpdateTexture(texture, nullptr, screen, pitch);
+			return;
+		}
+
+		// Upload each run of changed lines as a single rectangle.
+		uint32_t line = 0;
+
+		while (line < height)
+		{
+			if (!is_line_dirty(dirty, line))
+			{
+				line++;
+				continue;
+			}
+
+			const uint32_t first = line;
+
+			while ((line < height) && is_line_dirty(dirty, line))
+				line++;
+
+			const SDL_Rect rect = { 0, static_cast<int>(first), static_cast<int>(width), static_cast<int>(line - first) };
+			SDL_UpdateTexture(texture, &rect, screen + (first * pitch), pitch);
+		}
+	}
+
+	bool map_button(SDL_Keycode key, gbhw_button_t& button)
+	{
+		switch (key)
+		{
+			case SDLK_LEFT:			button = button_dpad_left;	return true;
+			case SDLK_RIGHT:		button = button_dpad_right;	return true;
+			case SDLK_UP:			button = button_dpad_up;	return true;
+			case SDLK_DOWN:			button = button_dpad_down;	return true;
+			case SDLK_RETURN:		button = button_start;		return true;
+			case SDLK_BACKSPACE:	button = button_select;		return true;
+			case SDLK_SPACE:		button = button_a;			return true;
+			case SDLK_b:			button = button_b;			return true;
+			default:				return false;
+		}
+	}
+
+	// Estimates the display refresh period from the time between vsynced
+	// presents. Intervals far from the estimate are missed or doubled vsyncs
+	// and are ignored, the rest are smoothed.
+	class RefreshClock
+	{
+	public:
+		RefreshClock(double period)
+			: m_period(period)
+			, m_last()
+			, m_bHasLast(false)
+		{
+		}
+
+		void presented()
+		{
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			if (m_bHasLast)
+			{
+				const double interval = std::chrono::duration<double>(now - m_last).count();
+
+				if ((interval > (m_period * 0.75)) && (interval < (m_period * 1.25)))
+					m_period += (interval - m_period) * 0.01;
+			}
+
+			m_last		= now;
+			m_bHasLast	= true;
+		}
+
+		double get_period() const
+		{
+			return m_period;
+		}
+
+	private:
+		double									m_period;
+		std::chrono::steady_clock::time_point	m_last;
+		bool									m_bHasLast;
+	};
 }
 //------------------------------------------------------------------------------
 
@@ -80,7 +174,7 @@ int main(int argc, char* args[])
 		return -1;
 	}
 
-	SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED /*| SDL_RENDERER_PRESENTVSYNC*/);
+	SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 
 	if (!renderer)
 	{
@@ -100,9 +194,25 @@ int main(int argc, char* args[])
 		return -1;
 	}
 
+	// Without vsync presents don't block, so the loop sleeps between frames
+	// and the emulation keeps its own time.
+	SDL_RendererInfo rendererInfo;
+	SDL_GetRendererInfo(renderer, &rendererInfo);
+	const bool bVsync = (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+
+	SDL_DisplayMode mode;
+	const int refreshRate = (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &mode) == 0) ? mode.refresh_rate : 0;
+	RefreshClock refresh((refreshRate > 0) ? (1.0 / refreshRate) : 0.0);
+
+	// The emulation thread owns the hardware from here on.
+	desktop::Emulation emulation(hardware, screenWidth, screenHeight);
+	emulation.start();
+
 	// Enter main-loop.
 	SDL_Event e;
 	bool bQuit = false;
+	int result = 0;
+	uint64_t lastFrame = 0;
 
 	while (!bQuit)
 	{
@@ -115,45 +225,66 @@ int main(int argc, char* args[])
 			}
 			else if ((e.type == SDL_KEYDOWN) || (e.type == SDL_KEYUP))
 			{
-				gbhw_button_state_t state = (e.type == SDL_KEYDOWN) ? button_pressed : button_released;
-
-				switch (e.key.keysym.sym)
-				{
-					case SDLK_LEFT:			gbhw_set_button_state(hardware, button_dpad_left, state); break;
-					case SDLK_RIGHT:		gbhw_set_button_state(hardware, button_dpad_right, state); break;
-					case SDLK_UP:			gbhw_set_button_state(hardware, button_dpad_up, state); break;
-					case SDLK_DOWN:			gbhw_set_button_state(hardware, button_dpad_down, state); break;
-					case SDLK_RETURN:		gbhw_set_button_state(hardware, button_start, state); break;
-					case SDLK_BACKSPACE:	gbhw_set_button_state(hardware, button_select, state); break;
-					case SDLK_SPACE:		gbhw_set_button_state(hardware, button_a, state); break;
-					case SDLK_b:			gbhw_set_button_state(hardware, button_b, state); break;
-					default: break;
-				}
+				gbhw_button_t button;
+
+				// Hold tab to fast-forward.
+				if (e.key.keysym.sym == SDLK_TAB)
+					emulation.set_fast_forward(e.type == SDL_KEYDOWN);
+				else if (map_button(e.key.keysym.sym, button))
+					emulation.set_button_state(button, (e.type == SDL_KEYDOWN) ? button_pressed : button_released);
 			}
 		}
 
-		// Tick hardware until there's a vsync.
-		if(gbhw_step(hardware, step_vsync) != e_success)
-			return -1;
+		if (!emulation.is_running())
+		{
+			result = -1;
+			break;
+		}
+
+		const bool bNewFrame = emulation.update_frame();
 
-		// @todo: Rate limit according to screen refresh.
+		if (bNewFrame)
+		{
+			const desktop::Frame& frame = emulation.get_frame();
 
-		const uint8_t* screen = nullptr;
-		if (gbhw_get_screen(hardware, &screen) != e_success)
-			return -1;
+			// Dirty lines are relative to the previous frame, after skipped
+			// frames the whole screen is uploaded.
+			if (frame.dirty.frame == (lastFrame + 1))
+				update_dirty_lines(texture, &frame.pixels[0], screenWidth, screenHeight, frame.dirty);
+			else
+				SDL_UpdateTexture(texture, nullptr, &frame.pixels[0], screenWidth * sizeof(uint32_t));
 
-		// Screen data is generated as XRGB8 data packed into uint32_t.
-		SDL_UpdateTexture(texture, nullptr, screen, screenWidth * sizeof(uint32_t));
-		SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-		SDL_RenderPresent(renderer);
+			lastFrame = frame.dirty.frame;
+		}
+
+		if (bVsync)
+		{
+			SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+			SDL_RenderPresent(renderer);
+
+			refresh.presented();
+			emulation.set_display_period(refresh.get_period());
+		}
+		else if (bNewFrame)
+		{
+			SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+			SDL_RenderPresent(renderer);
+		}
+		else
+		{
+			SDL_Delay(1);
+		}
 	}
 
+	emulation.stop();
+
 	SDL_DestroyTexture(texture);
 	SDL_DestroyRenderer(renderer);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
 
-	return 0;
+	gbhw_destroy(hardware);
+	return result;
 }
 
 //------------------------------------------------------------------------------
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Standalone driver linked in place of libFuzzer. Replays the inputs given on
+// the command line, or generates random ones when none are supplied, and
+// reports executions per second so the cost of a target can be tracked.
+//------------------------------------------------------------------------------
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace
+{
+	using Input = std::vector<uint8_t>;
+
+	void print_usage()
+	{
+		printf("Measures fuzz target throughput.\n");
+		printf("\tUsage: EXE [-runs=N] [-seconds=N] [-max_len=N] [-seed=N] [INPUT ...]\n");
+		printf("\n");
+		printf("Inputs are replayed in order, repeating until the run or time limit is reached.\n");
+		printf("Without inputs random data up to max_len bytes is generated.\n");
+	}
+
+	bool read_input(const char* path, Input& input)
+	{
+		FILE* file = fopen(path, "rb");
+
+		if(!file)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		const long length = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		input.resize(length > 0 ? length : 0);
+		const bool bRead = input.empty() || (fread(&input[0], 1, input.size(), file) == input.size());
+
+		fclose(file);
+		return bRead;
+	}
+
+	inline uint64_t xorshift(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	uint64_t maxRuns = 0;
+	double maxSeconds = 0.0;
+	size_t maxLength = 65536;
+	uint64_t seed = 0x9E3779B97F4A7C15ull;
+	std::vector<Input> inputs;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strncmp(args[i], "-runs=", 6) == 0)
+			maxRuns = strtoull(args[i] + 6, nullptr, 10);
+		else if(strncmp(args[i], "-seconds=", 9) == 0)
+			maxSeconds = atof(args[i] + 9);
+		else if(strncmp(args[i], "-max_len=", 9) == 0)
+			maxLength = strtoull(args[i] + 9, nullptr, 10);
+		else if(strncmp(args[i], "-seed=", 6) == 0)
+			seed = strtoull(args[i] + 6, nullptr, 10) | 1;
+		else if(args[i][0] == '-')
+		{
+			print_usage();
+			return -1;
+		}
+		else
+		{
+			Input input;
+
+			if(!read_input(args[i], input))
+			{
+				printf("Failed to read input '%s'\n", args[i]);
+				return -1;
+			}
+
+			inputs.push_back(input);
+		}
+	}
+
+	// Replay each input once by default, or run random data for 10 seconds.
+	if(maxRuns == 0 && maxSeconds <= 0.0)
+	{
+		if(inputs.empty())
+			maxSeconds = 10.0;
+		else
+			maxRuns = inputs.size();
+	}
+
+	LLVMFuzzerInitialize(&argc, &args);
+
+	Input random;
+	uint64_t runs = 0;
+	uint64_t bytes = 0;
+	double elapsed = 0.0;
+	const auto start = std::chrono::steady_clock::now();
+
+	while(((maxRuns == 0) || (runs < maxRuns)) && ((maxSeconds <= 0.0) || (elapsed < maxSeconds)))
+	{
+		const Input* input = nullptr;
+
+		if(inputs.empty())
+		{
+			random.resize(xorshift(seed) % (maxLength + 1));
+
+			for(auto& byte : random)
+				byte = static_cast<uint8_t>(xorshift(seed));
+
+			input = &random;
+		}
+		else
+		{
+			input = &inputs[runs % inputs.size()];
+		}
+
+		LLVMFuzzerTestOneInput(input->empty() ? nullptr : &(*input)[0], input->size());
+
+		runs++;
+		bytes += input->size();
+
+		// Sampling the clock every run would dominate small targets.
+		if((runs & 0xF) == 0 || (maxSeconds <= 0.0))
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("Executed %llu inputs (%llu bytes) in %.2f s\n", static_cast<unsigned long long>(runs), static_cast<unsigned long long>(bytes), elapsed);
+	printf("exec/s: %.1f\n", elapsed > 0.0 ? runs / elapsed : 0.0);
+	return 0;
+}
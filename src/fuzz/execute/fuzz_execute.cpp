@@ -0,0 +1,43 @@
+#include <gbhw.h>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+// Runs an arbitrary ROM image for a fixed number of frames through the public
+// API, catching crashes and hangs anywhere in the CPU, MMU, GPU or timer.
+//------------------------------------------------------------------------------
+
+namespace
+{
+	static const uint32_t kFrames = 8;
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if(size > UINT32_MAX)
+		return 0;
+
+	gbhw_settings_t settings	= {0};
+	settings.log_level			= l_disabled;
+
+	gbhw_context_t ctx = nullptr;
+
+	if(gbhw_create(&settings, &ctx) != e_success)
+		return 0;
+
+	if(gbhw_load_rom_memory(ctx, data, static_cast<uint32_t>(size)) == e_success)
+	{
+		for(uint32_t i = 0; i < kFrames; i++)
+		{
+			if(gbhw_step(ctx, step_vsync) != e_success)
+				break;
+		}
+	}
+
+	gbhw_destroy(ctx);
+	return 0;
+}
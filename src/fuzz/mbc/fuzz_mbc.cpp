@@ -0,0 +1,98 @@
+#include "cpu.h"
+#include "gpu.h"
+#include "log.h"
+#include "mmu.h"
+#include "perf.h"
+#include "rom.h"
+#include "serial.h"
+#include "timer.h"
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+// Drives the memory bank controllers through the MMU with a sequence of writes.
+//
+// Input layout:
+//	byte 0		- Cartridge type, unsupported values exercise the fallback.
+//	byte 1		- ROM size class, 2 << (n % 9) banks.
+//	byte 2..	- (address low, address high, value) write triples.
+//
+// The first byte of every ROM bank holds its own index, so after each write the
+// bank mapped at 0x4000 is checked against the bank the MMU reports.
+//------------------------------------------------------------------------------
+
+namespace
+{
+	static const uint32_t kBankSize			= 16384;
+	static const uint32_t kRomSizeClasses	= 9;	// 2 -> 512 banks.
+
+	struct Hardware
+	{
+		CPU				cpu;
+		GPU				gpu;
+		MMU				mmu;
+		Rom				rom;
+		Timer			timer;
+		Serial			serial;
+		PerfCounters	perf;
+		Breakpoints		breakpoints;
+		Disassembly		disassembly;
+		uint32_t		bankMask;
+
+		Hardware(uint32_t bankCount)
+		{
+			cpu.initialise(&mmu, &perf, &breakpoints);
+			gpu.initialise(&cpu, &mmu, &perf);
+			mmu.initialise(&cpu, &gpu, &rom, &timer, &serial, &perf, &breakpoints, &disassembly);
+			timer.initialise(&cpu, &mmu);
+			serial.initialise(&cpu, &mmu);
+
+			Buffer image(bankCount * kBankSize, 0);
+
+			for(uint32_t i = 0; i < bankCount; i++)
+				image[i * kBankSize] = static_cast<Byte>(i);
+
+			rom.load(image.data(), static_cast<uint32_t>(image.size()));
+			bankMask = bankCount - 1;
+		}
+	};
+
+	// ROMs are expensive to build, keep one set of hardware per size class.
+	Hardware* g_hardware[kRomSizeClasses] = { nullptr };
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	Log::instance().initialise(l_disabled, nullptr, nullptr);
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if(size < 2)
+		return 0;
+
+	const uint32_t sizeClass = data[1] % kRomSizeClasses;
+
+	if(!g_hardware[sizeClass])
+		g_hardware[sizeClass] = new Hardware(2u << sizeClass);
+
+	Hardware& hw = *g_hardware[sizeClass];
+	hw.mmu.reset(static_cast<CartridgeType::Type>(data[0]));
+
+	for(size_t i = 2; (i + 2) < size; i += 3)
+	{
+		const Address address = static_cast<Address>(data[i] | (data[i + 1] << 8));
+		hw.mmu.write_byte(address, data[i + 2]);
+
+		const Byte expected = static_cast<Byte>(hw.mmu.get_rom_bank() & hw.bankMask);
+
+		if(hw.mmu.read_byte(0x4000) != expected)
+			__builtin_trap();
+
+		volatile Byte sink = hw.mmu.read_byte(0xA000);
+		(void)sink;
+	}
+
+	return 0;
+}
@@ -0,0 +1,49 @@
+#include "log.h"
+#include "rom.h"
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+// Loads arbitrary bytes as a ROM image, then touches both ends of every bank
+// any cartridge controller could select.
+//------------------------------------------------------------------------------
+
+namespace
+{
+	static const uint32_t kBankSize		= 16384;
+	static const uint32_t kMaxBankIndex	= 512;
+
+	Rom* g_rom = nullptr;
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	Log::instance().initialise(l_disabled, nullptr, nullptr);
+	g_rom = new Rom();
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if(size > UINT32_MAX)
+		return 0;
+
+	if(!g_rom->load(data, static_cast<uint32_t>(size)))
+		return 0;
+
+	volatile uint8_t sink = static_cast<uint8_t>(g_rom->get_cartridge_type());
+
+	for(uint32_t i = 0; i < kMaxBankIndex; i++)
+	{
+		const uint8_t* bank = g_rom->get_bank(i);
+
+		if(!bank)
+			__builtin_trap();	// A loaded ROM must always provide a bank.
+
+		sink ^= bank[0];
+		sink ^= bank[kBankSize - 1];
+	}
+
+	(void)sink;
+	return 0;
+}
@@ -4,6 +4,7 @@
 
 #include <gbhw.h>
 #include <cpu.h>
+#include <disassembly.h>
 #include <gpu.h>
 #include <mmu.h>
 #include <registers.h>
@@ -21,6 +22,16 @@ HWPublicAPI gbhw_errorcode_t gbhw_get_mmu(gbhw_context_t ctx, gbhw::MMU** mmu);
 HWPublicAPI gbhw_errorcode_t gbhw_get_registers(gbhw_context_t ctx, gbhw::Registers** registers);
 HWPublicAPI gbhw_errorcode_t gbhw_disasm(gbhw_context_t ctx, gbhw::Address address, gbhw::InstructionList& instructions, int32_t instructionCount);
 
+// Lines from the disassembly cache, starting at the instruction containing
+// address in the banks currently mapped. Symbols stay valid until the next
+// gbhw_load_symbols.
+HWPublicAPI gbhw_errorcode_t gbhw_disasm_lines(gbhw_context_t ctx, gbhw::Address address, gbhw::DisasmLine* lines, uint32_t count, uint32_t* written);
+HWPublicAPI gbhw_errorcode_t gbhw_disasm_find(gbhw_context_t ctx, gbhw::Address address, gbhw::Address* start);
+
+// Replaces the symbols with those in an RGBDS .sym file.
+HWPublicAPI gbhw_errorcode_t gbhw_load_symbols(gbhw_context_t ctx, const char* path);
+HWPublicAPI gbhw_errorcode_t gbhw_find_symbol(gbhw_context_t ctx, gbhw::Address address, const char** name);
+
 /*----------------------------------------------------------------------------*/
 
 #ifdef __cplusplus
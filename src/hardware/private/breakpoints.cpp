@@ -0,0 +1,171 @@
+#include "breakpoints.h"
+#include <algorithm>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	Breakpoints::Breakpoints()
+		: m_any(65536 / 64, 0)
+		, m_breakpointCount(0)
+		, m_nextWatchId(1)
+		, m_bResuming(false)
+		, m_resumePC(0)
+		, m_bTriggered(false)
+	{
+		memset(m_pages, 0, sizeof(m_pages));
+		memset(&m_triggered, 0, sizeof(m_triggered));
+	}
+
+	void Breakpoints::add_breakpoint(Address address, int32_t bank)
+	{
+		if(!is_set(address, bank))
+		{
+			set(address, bank, true);
+			m_breakpointCount++;
+		}
+	}
+
+	void Breakpoints::remove_breakpoint(Address address, int32_t bank)
+	{
+		if(is_set(address, bank))
+		{
+			set(address, bank, false);
+			m_breakpointCount--;
+		}
+	}
+
+	uint32_t Breakpoints::add_watchpoint(Address first, Address last, gbhw_watch_type_t type)
+	{
+		Watchpoint watch;
+		watch.id	= m_nextWatchId++;
+		watch.first	= first;
+		watch.last	= last;
+		watch.type	= type;
+
+		m_watchpoints.push_back(watch);
+		update_pages();
+		return watch.id;
+	}
+
+	bool Breakpoints::remove_watchpoint(uint32_t id)
+	{
+		for(auto it = m_watchpoints.begin(); it != m_watchpoints.end(); ++it)
+		{
+			if(it->id == id)
+			{
+				m_watchpoints.erase(it);
+				update_pages();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void Breakpoints::clear()
+	{
+		std::fill(m_any.begin(), m_any.end(), 0);
+		m_banked.clear();
+		m_breakpointCount = 0;
+
+		m_watchpoints.clear();
+		update_pages();
+
+		reset_triggered();
+	}
+
+	//--------------------------------------------------------------------------
+
+	bool Breakpoints::is_set(Address address, int32_t bank) const
+	{
+		if((bank < 0) || (address < kBankedFirst) || (address > kBankedLast))
+			return test(m_any, address);
+
+		const uint32_t index = static_cast<uint32_t>(bank);
+
+		if((index >= m_banked.size()) || m_banked[index].empty())
+			return false;
+
+		return test(m_banked[index], address - kBankedFirst);
+	}
+
+	void Breakpoints::set(Address address, int32_t bank, bool bEnabled)
+	{
+		Bitmap* bitmap = &m_any;
+		uint32_t bit = address;
+
+		// Only the switchable window is banked, the bank is ignored elsewhere.
+		if((bank >= 0) && (address >= kBankedFirst) && (address <= kBankedLast))
+		{
+			const uint32_t index = static_cast<uint32_t>(bank);
+
+			if(index >= m_banked.size())
+				m_banked.resize(index + 1);
+
+			if(m_banked[index].empty())
+				m_banked[index].resize(kBankedSize / 64, 0);
+
+			bitmap	= &m_banked[index];
+			bit		= address - kBankedFirst;
+		}
+
+		if(bEnabled)
+			(*bitmap)[bit >> 6] |= (1ull << (bit & 63));
+		else
+			(*bitmap)[bit >> 6] &= ~(1ull << (bit & 63));
+	}
+
+	void Breakpoints::update_pages()
+	{
+		memset(m_pages, 0, sizeof(m_pages));
+
+		for(const Watchpoint& watch : m_watchpoints)
+		{
+			for(uint32_t page = (watch.first >> kPageShift); page <= (watch.last >> kPageShift); page++)
+				m_pages[page] |= static_cast<uint8_t>(watch.type);
+		}
+	}
+
+	void Breakpoints::check_watch(Address address, Byte value, gbhw_watch_type_t type)
+	{
+		for(const Watchpoint& watch : m_watchpoints)
+		{
+			if((watch.type & type) && (address >= watch.first) && (address <= watch.last))
+			{
+				// Keep the first hit, later accesses by the same instruction
+				// don't replace it.
+				if(!m_bTriggered)
+				{
+					m_bTriggered		= true;
+					m_triggered.reason	= (type == watch_read) ? break_read : break_write;
+					m_triggered.address	= address;
+					m_triggered.bank	= 0;
+					m_triggered.value	= value;
+				}
+
+				return;
+			}
+		}
+	}
+
+	void Breakpoints::check_watch_block(Address first, const Byte* values, uint32_t size, gbhw_watch_type_t type)
+	{
+		const uint32_t end = std::min<uint32_t>(first + size, 0x10000);
+
+		for(uint32_t address = first; address < end; )
+		{
+			const uint32_t pageEnd = std::min(((address >> kPageShift) + 1) << kPageShift, end);
+
+			if(m_pages[address >> kPageShift] & type)
+			{
+				for(uint32_t i = address; i < pageEnd; i++)
+					check_watch(static_cast<Address>(i), values ? values[i - first] : 0xFF, type);
+			}
+
+			address = pageEnd;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "gbhw.h"
+#include "types.h"
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	using BreakInfo = gbhw_break_t;
+
+	// Breakpoints and watchpoints evaluated as the hardware runs, so stepping
+	// to one costs a bit test per instruction or memory access rather than a
+	// round trip through the API for every instruction.
+	//
+	// Execution breakpoints are a bitmap over the address space, plus a bitmap
+	// of the switchable ROM window per bank for breakpoints that only apply
+	// while that bank is mapped. Watch ranges are filtered by 256 byte page
+	// before the ranges themselves are searched.
+	class Breakpoints
+	{
+	public:
+		Breakpoints();
+
+		void add_breakpoint(Address address, int32_t bank);
+		void remove_breakpoint(Address address, int32_t bank);
+
+		uint32_t add_watchpoint(Address first, Address last, gbhw_watch_type_t type);
+		bool remove_watchpoint(uint32_t id);
+
+		void clear();
+
+		// Execution won't stop on a breakpoint at pc before it has run an
+		// instruction, so stepping resumes from the breakpoint last hit.
+		inline void resume(Address pc);
+		inline void reset_triggered();
+		inline bool is_triggered() const;
+		inline const BreakInfo& get_triggered() const;
+
+		// Hot paths. check_execute returns true if execution should stop before
+		// pc, watch hits complete the access and are reported by is_triggered.
+		inline bool check_execute(Address pc, uint32_t bank);
+		inline void check_read(Address address, Byte value);
+		inline void check_write(Address address, Byte value);
+
+		// Bulk accesses made by DMA. values holds the bytes read or written
+		// from first on, null if they read as open bus. Only pages a watch of
+		// the type touches are searched.
+		inline void check_read_block(Address first, const Byte* values, uint32_t size);
+		inline void check_write_block(Address first, const Byte* values, uint32_t size);
+
+	private:
+		struct Watchpoint
+		{
+			uint32_t			id;
+			Address				first;
+			Address				last;
+			gbhw_watch_type_t	type;
+		};
+
+		using Bitmap = std::vector<uint64_t>;
+
+		static const Address	kBankedFirst	= 0x4000;	// Switchable ROM window.
+		static const Address	kBankedLast		= 0x7FFF;
+		static const uint32_t	kBankedSize		= 0x4000;
+		static const uint32_t	kPageShift		= 8;
+
+		static inline bool test(const Bitmap& bitmap, uint32_t index);
+		bool is_set(Address address, int32_t bank) const;
+		void set(Address address, int32_t bank, bool bEnabled);
+		void update_pages();
+		void check_watch(Address address, Byte value, gbhw_watch_type_t type);
+		void check_watch_block(Address first, const Byte* values, uint32_t size, gbhw_watch_type_t type);
+
+		Bitmap					m_any;				// Any bank, over the whole address space.
+		std::vector<Bitmap>		m_banked;			// Per ROM bank, over the switchable window.
+		uint32_t				m_breakpointCount;
+
+		std::vector<Watchpoint>	m_watchpoints;
+		uint8_t					m_pages[256];		// gbhw_watch_type_t bits of the watches touching each page.
+		uint32_t				m_nextWatchId;
+
+		bool					m_bResuming;
+		Address					m_resumePC;
+		bool					m_bTriggered;
+		BreakInfo				m_triggered;
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline void Breakpoints::resume(Address pc)
+	{
+		m_bResuming	= true;
+		m_resumePC	= pc;
+		reset_triggered();
+	}
+
+	inline void Breakpoints::reset_triggered()
+	{
+		m_bTriggered		= false;
+		m_triggered.reason	= break_none;
+	}
+
+	inline bool Breakpoints::is_triggered() const
+	{
+		return m_bTriggered;
+	}
+
+	inline const BreakInfo& Breakpoints::get_triggered() const
+	{
+		return m_triggered;
+	}
+
+	inline bool Breakpoints::test(const Bitmap& bitmap, uint32_t index)
+	{
+		return (bitmap[index >> 6] & (1ull << (index & 63))) != 0;
+	}
+
+	inline bool Breakpoints::check_execute(Address pc, uint32_t bank)
+	{
+		if(m_breakpointCount == 0)
+			return false;
+
+		if(m_bResuming)
+		{
+			m_bResuming = false;
+
+			if(pc == m_resumePC)
+				return false;
+		}
+
+		bool bHit = test(m_any, pc);
+
+		if(!bHit && (pc >= kBankedFirst) && (pc <= kBankedLast) && (bank < m_banked.size()) && !m_banked[bank].empty())
+			bHit = test(m_banked[bank], pc - kBankedFirst);
+
+		if(!bHit)
+			return false;
+
+		m_bTriggered		= true;
+		m_triggered.reason	= break_execute;
+		m_triggered.address	= pc;
+		m_triggered.bank	= static_cast<uint16_t>(bank);
+		m_triggered.value	= 0;
+		return true;
+	}
+
+	inline void Breakpoints::check_read(Address address, Byte value)
+	{
+		if(m_pages[address >> kPageShift] & watch_read)
+			check_watch(address, value, watch_read);
+	}
+
+	inline void Breakpoints::check_write(Address address, Byte value)
+	{
+		if(m_pages[address >> kPageShift] & watch_write)
+			check_watch(address, value, watch_write);
+	}
+
+	inline void Breakpoints::check_read_block(Address first, const Byte* values, uint32_t size)
+	{
+		if(!m_watchpoints.empty())
+			check_watch_block(first, values, size, watch_read);
+	}
+
+	inline void Breakpoints::check_write_block(Address first, const Byte* values, uint32_t size)
+	{
+		if(!m_watchpoints.empty())
+			check_watch_block(first, values, size, watch_write);
+	}
+
+	//--------------------------------------------------------------------------
+}
@@ -0,0 +1,401 @@
+#include "capture.h"
+#include "log.h"
+#include <chrono>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		static const char kCaptureMagic[4] = { 'G', 'B', 'V', 'C' };
+
+		// Runs shorter than this are cheaper to store as literals.
+		static const uint32_t kMinRepeat = 3;
+
+		// Every token covers at least one pixel, at most a 3 byte varint plus a
+		// 4 byte value per pixel.
+		static const uint32_t kMaxPayloadSize = kCapturePixels * 7;
+
+		inline void put_uint32(Buffer& buffer, uint32_t value)
+		{
+			for(uint32_t i = 0; i < 4; i++)
+				buffer.push_back(static_cast<Byte>(value >> (i * 8)));
+		}
+
+		inline Byte* put_uint32(Byte* out, uint32_t value)
+		{
+			memcpy(out, &value, sizeof(value));
+			return out + sizeof(value);
+		}
+
+		inline Byte* put_varint(Byte* out, uint64_t value)
+		{
+			while(value >= 0x80)
+			{
+				*out++ = static_cast<Byte>(value | 0x80);
+				value >>= 7;
+			}
+
+			*out++ = static_cast<Byte>(value);
+			return out;
+		}
+
+		inline Byte* put_token(Byte* out, uint32_t count, CaptureRun::Type run)
+		{
+			return put_varint(out, (static_cast<uint64_t>(count) << 2) | run);
+		}
+
+		inline const Byte* get_varint(const Byte* in, const Byte* end, uint64_t& value)
+		{
+			value = 0;
+
+			for(uint32_t shift = 0; (in < end) && (shift < 64); shift += 7)
+			{
+				const Byte byte = *in++;
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+				if((byte & 0x80) == 0)
+					return in;
+			}
+
+			return nullptr;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// CaptureWriter
+	//--------------------------------------------------------------------------
+
+	CaptureWriter::CaptureWriter()
+		: m_queue(kQueueSize)
+		, m_bRunning(false)
+		, m_bWait(false)
+		, m_file(nullptr)
+		, m_frameNumber(1)
+		, m_lastNumber(0)
+		, m_encoded(0)
+		, m_dropped(0)
+	{
+	}
+
+	CaptureWriter::~CaptureWriter()
+	{
+		close();
+	}
+
+	bool CaptureWriter::open(const char* path, bool bWait)
+	{
+		close();
+
+		m_file = fopen(path, "wb");
+
+		if(!m_file)
+		{
+			log_error("Failed to open capture file '%s'\n", path);
+			return false;
+		}
+
+		m_buffer.clear();
+		m_buffer.reserve(kFlushSize + kMaxPayloadSize);
+		m_payload.resize(kMaxPayloadSize);
+		m_previous.assign(kCapturePixels, 0);
+
+		for(char c : kCaptureMagic)
+			m_buffer.push_back(static_cast<Byte>(c));
+
+		put_uint32(m_buffer, kCaptureVersion);
+		put_uint32(m_buffer, kCaptureWidth);
+		put_uint32(m_buffer, kCaptureHeight);
+
+		m_bWait			= bWait;
+		m_frameNumber	= 1;
+		m_lastNumber	= 0;
+		m_encoded		= 0;
+		m_dropped		= 0;
+
+		m_bRunning = true;
+		m_thread = std::thread(&CaptureWriter::drain, this);
+		return true;
+	}
+
+	void CaptureWriter::close()
+	{
+		if(!m_file)
+			return;
+
+		m_bRunning = false;
+
+		if(m_thread.joinable())
+			m_thread.join();
+
+		flush();
+		fclose(m_file);
+		m_file = nullptr;
+
+		if(m_dropped > 0)
+			log_warning("Capture dropped %" PRIu64 " of %" PRIu64 " frames\n", m_dropped, m_frameNumber - 1);
+	}
+
+	void CaptureWriter::drain()
+	{
+		while(true)
+		{
+			// As with tracing, sample the flag first so committed frames are
+			// always written out on close.
+			const bool bRunning = m_bRunning;
+			CaptureFrame* frame = m_queue.acquire_read();
+
+			if(frame)
+			{
+				encode(*frame);
+				m_queue.commit_read();
+
+				if(m_buffer.size() >= kFlushSize)
+					flush();
+			}
+			else if(bRunning)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	void CaptureWriter::encode(const CaptureFrame& frame)
+	{
+		const bool bKeyFrame = (m_encoded % kKeyFrameInterval) == 0;
+
+		if(bKeyFrame)
+			memset(&m_previous[0], 0, kCapturePixels * sizeof(uint32_t));
+
+		// XOR in place, m_previous becomes the delta and is restored from the
+		// frame once encoded.
+		uint32_t* delta = &m_previous[0];
+
+		for(uint32_t i = 0; i < kCapturePixels; i++)
+			delta[i] ^= frame.pixels[i];
+
+		Byte* out = &m_payload[0];
+		uint32_t i = 0;
+
+		while(i < kCapturePixels)
+		{
+			const uint32_t value = delta[i];
+			uint32_t end = i + 1;
+
+			while((end < kCapturePixels) && (delta[end] == value))
+				end++;
+
+			if(value == 0)
+			{
+				out = put_token(out, end - i, CaptureRun::Zero);
+				i = end;
+			}
+			else if((end - i) >= kMinRepeat)
+			{
+				out = put_token(out, end - i, CaptureRun::Repeat);
+				out = put_uint32(out, value);
+				i = end;
+			}
+			else
+			{
+				// Gather literals up to the next unchanged pixel or worthwhile repeat.
+				end = i + 1;
+
+				while((end < kCapturePixels) && (delta[end] != 0) &&
+					  !(((end + 2) < kCapturePixels) && (delta[end] == delta[end + 1]) && (delta[end] == delta[end + 2])))
+				{
+					end++;
+				}
+
+				out = put_token(out, end - i, CaptureRun::Literal);
+
+				for(; i < end; i++)
+					out = put_uint32(out, delta[i]);
+			}
+		}
+
+		const uint32_t payloadSize = static_cast<uint32_t>(out - &m_payload[0]);
+
+		// Frame header, bounded by a flag byte and two 10 byte varints.
+		const size_t offset = m_buffer.size();
+		m_buffer.resize(offset + 21 + payloadSize);
+
+		Byte* header = &m_buffer[offset];
+		*header++ = bKeyFrame ? CaptureFlags::KeyFrame : 0;
+		header = put_varint(header, frame.number - m_lastNumber);
+		header = put_varint(header, payloadSize);
+		memcpy(header, &m_payload[0], payloadSize);
+		m_buffer.resize((header + payloadSize) - &m_buffer[0]);
+
+		memcpy(&m_previous[0], frame.pixels, kCapturePixels * sizeof(uint32_t));
+		m_lastNumber = frame.number;
+		m_encoded++;
+	}
+
+	void CaptureWriter::flush()
+	{
+		if(!m_buffer.empty())
+		{
+			fwrite(&m_buffer[0], 1, m_buffer.size(), m_file);
+			m_buffer.clear();
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// CaptureReader
+	//--------------------------------------------------------------------------
+
+	CaptureReader::CaptureReader()
+		: m_file(nullptr)
+		, m_number(0)
+	{
+	}
+
+	CaptureReader::~CaptureReader()
+	{
+		close();
+	}
+
+	bool CaptureReader::open(const char* path)
+	{
+		close();
+
+		m_file = fopen(path, "rb");
+
+		if(!m_file)
+			return false;
+
+		char magic[4];
+		uint32_t header[3];
+
+		if((fread(magic, 1, sizeof(magic), m_file) != sizeof(magic)) || (memcmp(magic, kCaptureMagic, sizeof(magic)) != 0) ||
+		   (fread(header, sizeof(uint32_t), 3, m_file) != 3) || (header[0] != kCaptureVersion) ||
+		   (header[1] != kCaptureWidth) || (header[2] != kCaptureHeight))
+		{
+			close();
+			return false;
+		}
+
+		m_previous.assign(kCapturePixels, 0);
+		m_number = 0;
+		return true;
+	}
+
+	void CaptureReader::close()
+	{
+		if(m_file)
+		{
+			fclose(m_file);
+			m_file = nullptr;
+		}
+	}
+
+	bool CaptureReader::read(uint64_t& number, uint32_t* pixels)
+	{
+		if(!m_file)
+			return false;
+
+		const int flags = fgetc(m_file);
+		uint64_t delta = 0;
+		uint64_t payloadSize = 0;
+
+		if((flags == EOF) || !read_varint(delta) || !read_varint(payloadSize) || (payloadSize > kMaxPayloadSize))
+			return false;
+
+		m_payload.resize(static_cast<size_t>(payloadSize));
+
+		if((payloadSize > 0) && (fread(&m_payload[0], 1, m_payload.size(), m_file) != m_payload.size()))
+			return false;
+
+		if(flags & CaptureFlags::KeyFrame)
+			memset(&m_previous[0], 0, kCapturePixels * sizeof(uint32_t));
+
+		const Byte* in = m_payload.data();
+		const Byte* end = in + m_payload.size();
+		uint32_t* out = &m_previous[0];
+		uint32_t i = 0;
+
+		while(i < kCapturePixels)
+		{
+			uint64_t token = 0;
+			in = get_varint(in, end, token);
+
+			const uint64_t count = token >> 2;
+
+			if(!in || (count == 0) || (count > (kCapturePixels - i)))
+				return false;
+
+			switch(token & 0x3)
+			{
+				case CaptureRun::Zero:
+				{
+					i += static_cast<uint32_t>(count);
+					break;
+				}
+				case CaptureRun::Repeat:
+				{
+					uint32_t value;
+
+					if((end - in) < 4)
+						return false;
+
+					memcpy(&value, in, sizeof(value));
+					in += sizeof(value);
+
+					for(uint64_t n = 0; n < count; n++)
+						out[i++] ^= value;
+
+					break;
+				}
+				case CaptureRun::Literal:
+				{
+					if(static_cast<uint64_t>(end - in) < (count * 4))
+						return false;
+
+					for(uint64_t n = 0; n < count; n++, in += 4)
+					{
+						uint32_t value;
+						memcpy(&value, in, sizeof(value));
+						out[i++] ^= value;
+					}
+
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+
+		m_number += delta;
+		number = m_number;
+		memcpy(pixels, &m_previous[0], kCapturePixels * sizeof(uint32_t));
+		return true;
+	}
+
+	bool CaptureReader::read_varint(uint64_t& value)
+	{
+		value = 0;
+
+		for(uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			const int byte = fgetc(m_file);
+
+			if(byte == EOF)
+				return false;
+
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+			if((byte & 0x80) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	//--------------------------------------------------------------------------
+}
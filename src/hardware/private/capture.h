@@ -0,0 +1,156 @@
+#pragma once
+
+#include "spsc_queue.h"
+#include "types.h"
+#include <atomic>
+#include <thread>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Capture file layout:
+	//
+	// Header	- "GBVC", uint32 version, uint32 width, uint32 height.
+	// Frame	- uint8 flags (CaptureFlags), varint frame number delta, varint
+	//			  payload size, payload.
+	//
+	// The payload XORs each 32-bit pixel with the previous frame, or with zero
+	// for key frames, and run-length encodes the result as a sequence of
+	// varint tokens (count << 2 | CaptureRun) until every pixel is covered:
+	//
+	// Zero		- count unchanged pixels.
+	// Repeat	- count pixels sharing the following uint32 XOR value.
+	// Literal	- count uint32 XOR values follow.
+	struct CaptureFlags
+	{
+		enum Type
+		{
+			KeyFrame	= 0x01
+		};
+	};
+
+	struct CaptureRun
+	{
+		enum Type
+		{
+			Zero		= 0,
+			Repeat		= 1,
+			Literal		= 2
+		};
+	};
+
+	static const uint32_t kCaptureVersion	= 1;
+	static const uint32_t kCaptureWidth		= 160;
+	static const uint32_t kCaptureHeight	= 144;
+	static const uint32_t kCapturePixels	= kCaptureWidth * kCaptureHeight;
+
+	struct CaptureFrame
+	{
+		uint64_t	number;						// Frames since capture started, gaps are dropped frames.
+		uint32_t	pixels[kCapturePixels];
+	};
+
+	//--------------------------------------------------------------------------
+
+	// Frames are copied on the emulation thread into a small lock-free ring and
+	// compressed and written by a background thread. A full ring drops the
+	// frame rather than stalling emulation, the gap is visible in the stream,
+	// unless the writer was opened to wait for the background thread instead.
+	class CaptureWriter
+	{
+	public:
+		CaptureWriter();
+		~CaptureWriter();
+
+		bool open(const char* path, bool bWait);
+		void close();
+
+		// Returns a frame to fill or null if the ring is full, in which case
+		// the frame is counted as dropped. Never null when waiting.
+		inline CaptureFrame* acquire();
+		inline void commit();
+
+		inline uint64_t get_dropped() const;
+
+	private:
+		void drain();
+		void encode(const CaptureFrame& frame);
+		void flush();
+
+		static const uint32_t	kQueueSize			= 8;
+		static const uint32_t	kFlushSize			= 256 * 1024;
+		static const uint32_t	kKeyFrameInterval	= 600;		// Lets a damaged stream recover and a reader seek.
+
+		SPSCQueue<CaptureFrame>	m_queue;
+		std::thread				m_thread;
+		std::atomic<bool>		m_bRunning;
+		bool					m_bWait;
+		FILE*					m_file;
+		Buffer					m_buffer;
+		Buffer					m_payload;
+		std::vector<uint32_t>	m_previous;
+		uint64_t				m_frameNumber;		// Next frame number to hand out, starting at 1.
+		uint64_t				m_lastNumber;		// Number of the last encoded frame.
+		uint64_t				m_encoded;
+		uint64_t				m_dropped;
+	};
+
+	//--------------------------------------------------------------------------
+
+	class CaptureReader
+	{
+	public:
+		CaptureReader();
+		~CaptureReader();
+
+		bool open(const char* path);
+		void close();
+
+		// Decodes the next frame into pixels, kCapturePixels entries.
+		bool read(uint64_t& number, uint32_t* pixels);
+
+	private:
+		bool read_varint(uint64_t& value);
+
+		FILE*					m_file;
+		Buffer					m_payload;
+		std::vector<uint32_t>	m_previous;
+		uint64_t				m_number;
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline CaptureFrame* CaptureWriter::acquire()
+	{
+		CaptureFrame* frame = m_queue.acquire_write();
+
+		while(!frame && m_bWait)
+		{
+			std::this_thread::yield();
+			frame = m_queue.acquire_write();
+		}
+
+		if(!frame)
+		{
+			m_dropped++;
+			m_frameNumber++;
+			return nullptr;
+		}
+
+		frame->number = m_frameNumber++;
+		return frame;
+	}
+
+	inline void CaptureWriter::commit()
+	{
+		m_queue.commit_write();
+	}
+
+	inline uint64_t CaptureWriter::get_dropped() const
+	{
+		return m_dropped;
+	}
+
+	//--------------------------------------------------------------------------
+}
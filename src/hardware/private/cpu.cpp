@@ -1,7 +1,10 @@
 #include "cpu.h"
+#include "breakpoints.h"
 #include "instructions.h"
 #include "instructions_extended.h"
 #include "log.h"
+#include "mmu.h"
+#include "trace.h"
 
 namespace gbhw
 {
@@ -59,13 +62,23 @@ namespace gbhw
 	//--------------------------------------------------------------------------
 
 	CPU::CPU()
-		: m_bBugCheck(false)
+		: m_mmu(nullptr)
+		, m_perf(nullptr)
+		, m_breakpoints(nullptr)
+		, m_trace(nullptr)
+		, m_traceCallback(nullptr)
+		, m_traceUserdata(nullptr)
+		, m_bTracing(false)
+		, m_bBugCheck(false)
 		, m_bStopped(false)
 		, m_bHalted(false)
+		, m_bHaltBug(false)
 		, m_speed(0)
 		, m_currentOpcode(0)
 		, m_currentOpcodeExt(0)
 		, m_instructionCycles(0)
+		, m_cycles(0)
+		, m_clock(0)
 	{
 	}
 
@@ -73,13 +86,30 @@ namespace gbhw
 	{
 	}
 
-	void CPU::initialise(MMU* mmu)
+	void CPU::initialise(MMU* mmu, PerfCounters* perf, Breakpoints* breakpoints)
 	{
 		m_mmu = mmu;
+		m_perf = perf;
+		m_breakpoints = breakpoints;
 
 		load_instructions();
 	}
 
+	void CPU::fork(const CPU& parent)
+	{
+		m_registers			= parent.m_registers;
+		m_bBugCheck			= parent.m_bBugCheck;
+		m_bStopped			= parent.m_bStopped;
+		m_bHalted			= parent.m_bHalted;
+		m_bHaltBug			= parent.m_bHaltBug;
+		m_speed				= parent.m_speed;
+		m_currentOpcode		= parent.m_currentOpcode;
+		m_currentOpcodeExt	= parent.m_currentOpcodeExt;
+		m_instructionCycles	= parent.m_instructionCycles;
+		m_cycles			= parent.m_cycles;
+		m_clock				= parent.m_clock;
+	}
+
 	uint16_t CPU::update(uint16_t maxcycles)
 	{
 		uint16_t cycles = 0;
@@ -90,14 +120,30 @@ namespace gbhw
 		while(cycles < maxcycles)
 		{
 			// Check for interrupts before executing an instruction.
-			handle_interrupts();
+			if(m_mmu->get_pending_interrupts())
+				handle_interrupts();
+
+			if(m_breakpoints->check_execute(m_registers.pc, m_mmu->get_rom_bank()))
+				break;
+
+			if(m_bTracing)
+				trace_instruction();
 
 			// Run the next instruction.
 			m_currentOpcode = immediate_byte();
 
+			if(m_bHaltBug)
+			{
+				m_registers.pc--;
+				m_bHaltBug = false;
+			}
+
 			Instruction& instruction = m_instructions[m_currentOpcode];
 			InstructionFunction& func = instruction.function();
 
+			// STOP may switch speed, it still runs at the old one.
+			const Byte speed = m_speed;
+
 			Byte instCycles = instruction.cycles((this->*func)());
 
 			if(m_bBugCheck)
@@ -115,14 +161,39 @@ namespace gbhw
 
 			m_instructionCycles += instCycles;
 
+			m_perf->instructions++;
+			m_perf->opcodes[m_currentOpcode]++;
+			m_perf->cycles += m_instructionCycles;
+			m_cycles += m_instructionCycles;
+			m_clock += static_cast<uint64_t>(m_instructionCycles) << (kClockShift - speed);
+
 			// Update cycles
 			cycles += m_instructionCycles;
 			m_instructionCycles = 0;
+
+			if(m_breakpoints->is_triggered())
+				break;
 		}
 
 		return cycles;
 	}
 
+	uint16_t CPU::update_halted(uint16_t cycles)
+	{
+		// Any pending interrupt wakes the CPU, servicing it only if ime is set.
+		handle_interrupts();
+
+		if(!m_bHalted)
+			return update(1);
+
+		m_perf->cycles += cycles;
+		m_perf->halted_cycles += cycles;
+		m_cycles += cycles;
+		m_clock += static_cast<uint64_t>(cycles) << (kClockShift - m_speed);
+
+		return cycles;
+	}
+
 	void CPU::update_stalled()
 	{
 		handle_interrupts();
@@ -130,58 +201,76 @@ namespace gbhw
 
 	void CPU::generate_interrupt(HWInterrupts::Type interrupt)
 	{
-		m_mmu->write_byte(HWRegs::IF, m_mmu->read_byte(HWRegs::IF) | static_cast<Byte>(interrupt));
+		m_mmu->write_io(HWRegs::IF, m_mmu->read_io(HWRegs::IF) | static_cast<Byte>(interrupt));
 	}
 
 	void CPU::handle_interrupts()
 	{
-		Byte regif = m_mmu->read_byte(HWRegs::IF);
-		Byte regie = m_mmu->read_byte(HWRegs::IE);
+		const Byte pending = m_mmu->get_pending_interrupts();
 
-		if(regif == 0)
+		if(pending == 0)
 		{
 			return;
 		}
 
-		handle_interrupt(HWInterrupts::VBlank, HWInterruptRoutines::VBlank, regif, regie);
-		handle_interrupt(HWInterrupts::Stat,   HWInterruptRoutines::Stat,   regif, regie);
-		handle_interrupt(HWInterrupts::Timer,  HWInterruptRoutines::Timer,  regif, regie);
-		handle_interrupt(HWInterrupts::Serial, HWInterruptRoutines::Serial, regif, regie);
-		handle_interrupt(HWInterrupts::Button, HWInterruptRoutines::Button, regif, regie);
-	}
+		if((pending & HWInterrupts::Button) && m_bStopped)
+		{
+			log_debug("Button interrupt handled whilst stopped, resuming\n");
+			m_bStopped = false;
+		}
 
-	void CPU::handle_interrupt(HWInterrupts::Type interrupt, HWInterruptRoutines::Type routine, Byte regif, Byte regie)
-	{
-		Byte inter = static_cast<Byte>(interrupt);
+		// Resume hardware execution regardless of ime.
+		if(m_bHalted)
+		{
+			log_debug("Interrupt has resumed the hardware\n");
+			m_bHalted = false;
+		}
 
-		if((regif & inter) && (regie & inter))
+		if(!m_registers.ime)
 		{
-			if(m_registers.ime)
-			{
-				if (HWInterrupts::Timer == interrupt)
-				{
-					log_debug("Handling timer interrupt\n");
-				}
-
-				m_mmu->write_byte(HWRegs::IF, regif & ~(inter));		// Remove flag, indicating handled.
-				m_registers.ime = false;								// Disable interrupts.
-				stack_push(m_registers.pc);								// Push current instruction onto the stack.
-				m_registers.pc = static_cast<Word>(routine);			// Jump to interrupt routine.
-			}
+			return;
+		}
 
-			if ((interrupt == HWInterrupts::Button) && m_bStopped)
-			{
-				log_debug("Button interrupt handled whilst stopped, resuming\n");
-				m_bStopped = false;
-			}
+		// Lowest bit has the highest priority, routines are 8 bytes apart in
+		// the same order.
+		uint32_t index = 0;
 
-			// Resume hardware execution regardless of ime.
-			if (m_bHalted)
-			{
-				log_debug("Interrupt has resumed the hardware\n");
-				m_bHalted = false;
-			}
-		}
+		while((pending & (1 << index)) == 0)
+			index++;
+
+		const Byte inter = static_cast<Byte>(1 << index);
+
+		m_perf->interrupts[index]++;
+
+		m_mmu->write_io(HWRegs::IF, m_mmu->read_io(HWRegs::IF) & ~inter);			// Remove flag, indicating handled.
+		m_registers.ime = false;													// Disable interrupts.
+		stack_push(m_registers.pc);													// Push current instruction onto the stack.
+		m_registers.pc = static_cast<Word>(HWInterruptRoutines::VBlank + (index * 8));	// Jump to interrupt routine.
+	}
+
+	void CPU::trace_instruction()
+	{
+		TraceRecord local;
+		TraceRecord* record = m_trace ? m_trace->acquire() : &local;
+		const Address pc = m_registers.pc;
+
+		record->cycle	= m_cycles;
+		record->pc		= pc;
+		record->af		= m_registers.af;
+		record->bc		= m_registers.bc;
+		record->de		= m_registers.de;
+		record->hl		= m_registers.hl;
+		record->sp		= m_registers.sp;
+		record->bank	= static_cast<Word>(m_mmu->get_rom_bank());
+
+		for(Address i = 0; i < 4; i++)
+			record->mem[i] = m_mmu->peek_byte(pc + i);
+
+		if(m_traceCallback)
+			m_traceCallback(m_traceUserdata, record);
+
+		if(m_trace)
+			m_trace->commit();
 	}
 
 	void CPU::load_instructions()
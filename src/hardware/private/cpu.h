@@ -1,12 +1,15 @@
 #pragma once
 
 #include "log.h"
+#include "perf.h"
 #include "registers.h"
 
 namespace gbhw
 {
 	class CPU;
 	class MMU;
+	class Breakpoints;
+	class TraceWriter;
 
 	//--------------------------------------------------------------------------
 	// Instruction
@@ -70,24 +73,36 @@ namespace gbhw
 		CPU();
 		virtual ~CPU();
 
-		void initialise(MMU* mmu);
+		void initialise(MMU* mmu, PerfCounters* perf, Breakpoints* breakpoints);
+		void fork(const CPU& parent);		// Execution state only, tracing isn't carried over.
+
+		// The master clock runs at the double speed CPU rate, single speed CPU
+		// cycles and every GPU cycle take two ticks.
+		static const uint32_t kClockShift = 1;
 
 		uint16_t update(uint16_t maxcycles);
+		uint16_t update_halted(uint16_t cycles);
 		void update_stalled();
 
 		void generate_interrupt(HWInterrupts::Type interrupt);
 
+		inline void set_trace(TraceWriter* trace);
+		inline void set_trace_callback(gbhw_trace_callback_t callback, void* userdata);
+
 		inline bool is_stalled() const;
+		inline bool is_halted() const;
 		inline bool is_bugchecked() const;
 		inline Byte get_speed() const;
+		inline uint64_t get_cycles() const;
+		inline uint64_t get_clock() const;
 		inline Registers* get_registers();
-		inline Instruction get_instruction(Byte opcode, bool bExtended) const;
+		inline const Instruction& get_instruction(Byte opcode, bool bExtended) const;
 
 	protected:
 		void handle_interrupts();
-		void handle_interrupt(HWInterrupts::Type interrupt, HWInterruptRoutines::Type routine, Byte regif, Byte regie);
 
 		void load_instructions();
+		void trace_instruction();
 		InstructionResult::Enum instruction_not_implemented();
 		InstructionResult::Enum instruction_not_implemented_ext();
 
@@ -294,16 +309,25 @@ namespace gbhw
 		static const uint32_t kInstructionCount = 256;
 
 		MMU*					m_mmu;
+		PerfCounters*			m_perf;
+		Breakpoints*			m_breakpoints;
+		TraceWriter*			m_trace;
+		gbhw_trace_callback_t	m_traceCallback;
+		void*					m_traceUserdata;
+		bool					m_bTracing;				// Either a writer or callback is set.
 		Registers				m_registers;
 
 		bool					m_bBugCheck;
 		bool					m_bStopped;
 		bool					m_bHalted;
+		bool					m_bHaltBug;				// Next opcode fetch doesn't advance pc.
 		Byte					m_speed;
 
 		Byte					m_currentOpcode;
 		Byte					m_currentOpcodeExt;
 		uint16_t				m_instructionCycles;	// Normal or extended.
+		uint64_t				m_cycles;				// Total cycles executed since creation, at the current speed.
+		uint64_t				m_clock;				// Master clock ticks since creation, see kClockShift.
 
 		Instruction				m_instructions[kInstructionCount];
 		Instruction				m_instructionsExt[kInstructionCount];
@@ -60,9 +60,27 @@ namespace gbhw
 	// Helpers
 	//--------------------------------------------------------------------------
 
+	inline void CPU::set_trace(TraceWriter* trace)
+	{
+		m_trace = trace;
+		m_bTracing = m_trace || m_traceCallback;
+	}
+
+	inline void CPU::set_trace_callback(gbhw_trace_callback_t callback, void* userdata)
+	{
+		m_traceCallback = callback;
+		m_traceUserdata = userdata;
+		m_bTracing = m_trace || m_traceCallback;
+	}
+
 	inline bool CPU::is_stalled() const
 	{
-		return m_bStopped || m_bHalted;
+		return m_bStopped;
+	}
+
+	inline bool CPU::is_halted() const
+	{
+		return m_bHalted;
 	}
 
 	inline bool CPU::is_bugchecked() const
@@ -75,12 +93,22 @@ namespace gbhw
 		return m_speed;
 	}
 
+	inline uint64_t CPU::get_cycles() const
+	{
+		return m_cycles;
+	}
+
+	inline uint64_t CPU::get_clock() const
+	{
+		return m_clock;
+	}
+
 	inline Registers* CPU::get_registers()
 	{
 		return &m_registers;
 	}
 
-	inline Instruction CPU::get_instruction(Byte opcode, bool bExtended) const
+	inline const Instruction& CPU::get_instruction(Byte opcode, bool bExtended) const
 	{
 		return bExtended ? m_instructionsExt[opcode] : m_instructions[opcode];
 	}
@@ -206,23 +234,37 @@ namespace gbhw
 
 	inline InstructionResult::Enum CPU::inst_halt()
 	{
-		//log_debug("Halting CPU until interrupt is generated\n");
-		//m_bHalted = true;
+		const Byte pending = m_mmu->get_pending_interrupts();
+
+		// With interrupts disabled and one already pending the CPU doesn't
+		// halt, and the byte following HALT is read twice.
+		if(!m_registers.ime && pending)
+		{
+			m_bHaltBug = true;
+			return InstructionResult::Passed;
+		}
+
+		log_debug("Halting CPU until interrupt is generated\n");
+		m_bHalted = true;
 		return InstructionResult::Passed;
 	}
 
 	inline InstructionResult::Enum CPU::inst_stop()
 	{
-		// Prepare speed switch is low bit of Key1.
+		// STOP is followed by a padding byte.
+		immediate_byte();
+
+		// Prepare speed switch is low bit of Key1, only CGB can switch.
 		Byte val = m_mmu->read_io(HWRegs::Key1);
-		if(val & 0x01)
+		if(m_mmu->is_colour() && (val & 0x01))
 		{
 			// Toggle speed.
 			m_speed ^= 1;
 
-			// Write current speed back to top bit of Key1.
+			// Write current speed back to top bit of Key1, the switch clears
+			// the prepare bit.
 			val = (val & 0x7E) | (m_speed << 7);
-			m_mmu->write_byte(HWRegs::Key1, m_speed);
+			m_mmu->write_io(HWRegs::Key1, val);
 		}
 
 		return InstructionResult::Passed;
@@ -986,6 +1028,7 @@ namespace gbhw
 	inline InstructionResult::Enum CPU::inst_ext()
 	{
 		m_currentOpcodeExt = immediate_byte();
+		m_perf->opcodes_extended[m_currentOpcodeExt]++;
 
 		Instruction& extendedInstruction = m_instructionsExt[m_currentOpcodeExt];
 		InstructionFunction& func = extendedInstruction.function();
@@ -0,0 +1,303 @@
+#include "disassembly.h"
+#include "cpu.h"
+#include "mmu.h"
+#include "rom.h"
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		struct RamRegion
+		{
+			Address		base;
+			uint32_t	size;
+		};
+
+		// Each region is swept from its own base, echo RAM mirrors work RAM.
+		const RamRegion kRamRegions[] =
+		{
+			{ 0x8000, 0x2000 },		// Video RAM
+			{ 0xA000, 0x2000 },		// External RAM
+			{ 0xC000, 0x2000 },		// Working RAM
+			{ 0xE000, 0x1E00 },		// Echo of working RAM
+			{ 0xFE00, 0x0100 },		// OAM and unusable
+			{ 0xFF00, 0x0080 },		// IO
+			{ 0xFF80, 0x0080 }		// Zero-page RAM
+		};
+
+		const Address kBankedFirst	= 0x4000;
+		const Address kWorkingRam	= 0xC000;
+		const Address kEchoRam		= 0xE000;
+	}
+
+	//--------------------------------------------------------------------------
+
+	Disassembly::Disassembly()
+		: m_mmu(nullptr)
+		, m_rom(nullptr)
+		, m_bankCount(0)
+		, m_bStopping(false)
+	{
+		memset(m_ramBack, 0, sizeof(m_ramBack));
+		memset(m_ramDirty, 1, sizeof(m_ramDirty));
+	}
+
+	Disassembly::~Disassembly()
+	{
+		stop_thread();
+	}
+
+	void Disassembly::initialise(const CPU* cpu, const MMU* mmu, Rom* rom)
+	{
+		m_mmu = mmu;
+		m_rom = rom;
+
+		// Unimplemented opcodes have no size, step over them a byte at a time.
+		for(uint32_t i = 0; i < 256; i++)
+		{
+			m_sizes[i]		= std::max<Byte>(1, cpu->get_instruction(static_cast<Byte>(i), false).byte_size());
+			m_sizesExt[i]	= std::max<Byte>(2, cpu->get_instruction(static_cast<Byte>(i), true).byte_size());
+		}
+	}
+
+	void Disassembly::reset()
+	{
+		stop_thread();
+
+		m_banks.reset();
+		m_bankCount = 0;
+		memset(m_ramDirty, 1, sizeof(m_ramDirty));
+	}
+
+	void Disassembly::invalidate(Address first, uint32_t size)
+	{
+		for(uint32_t page = (first >> kPageShift); page <= ((first + size - 1) >> kPageShift); page++)
+			m_ramDirty[page] = true;
+	}
+
+	Address Disassembly::find(Address address)
+	{
+		if(address >= kRamBase)
+		{
+			build_ram();
+			return address - m_ramBack[address - kRamBase];
+		}
+
+		const uint32_t bank = (address < kBankedFirst) ? 0 : m_mmu->get_rom_bank();
+		const uint8_t* back = get_bank_index(bank);
+
+		if(!back)
+			return address;
+
+		return address - back[address & (Rom::kBankSize - 1)];
+	}
+
+	uint32_t Disassembly::get_lines(Address address, DisasmLine* lines, uint32_t count)
+	{
+		uint32_t start = find(address);
+		uint32_t written = 0;
+
+		// Lines follow on from each other rather than from the index, so an
+		// instruction spanning two regions doesn't repeat.
+		while((written < count) && (start <= 0xFFFF))
+		{
+			DisasmLine& line	= lines[written++];
+			const Address pc	= static_cast<Address>(start);
+			const Byte opcode	= m_mmu->peek_byte(pc);
+
+			line.address	= pc;
+			line.bank		= ((pc >= kBankedFirst) && (pc < kRamBase)) ? static_cast<uint16_t>(m_mmu->get_rom_bank()) : 0;
+			line.size		= (opcode == 0xCB) ? m_sizesExt[m_mmu->peek_byte(static_cast<Address>(pc + 1))] : m_sizes[opcode];
+			line.symbol		= find_symbol(pc);
+
+			for(Byte i = 0; i < 3; i++)
+				line.bytes[i] = (i < line.size) ? m_mmu->peek_byte(static_cast<Address>(pc + i)) : 0;
+
+			start += line.size;
+		}
+
+		return written;
+	}
+
+	bool Disassembly::load_symbols(const char* path)
+	{
+		FILE* file = fopen(path, "r");
+
+		if(!file)
+			return false;
+
+		m_symbols.clear();
+
+		// RGBDS symbol files hold one "BB:AAAA Name" per line, both hex, with
+		// ';' starting a comment.
+		char line[512];
+
+		while(fgets(line, sizeof(line), file))
+		{
+			unsigned int bank = 0;
+			unsigned int address = 0;
+			char name[256];
+
+			if(line[0] == ';')
+				continue;
+
+			if(sscanf(line, "%x:%x %255s", &bank, &address, name) != 3)
+				continue;
+
+			if(address > 0xFFFF)
+				continue;
+
+			// Keep the first name given to an address.
+			m_symbols.insert(std::make_pair(get_symbol_key(bank, static_cast<Address>(address)), std::string(name)));
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	const char* Disassembly::find_symbol(Address address) const
+	{
+		if(m_symbols.empty())
+			return nullptr;
+
+		const uint32_t bank = ((address >= kBankedFirst) && (address < kRamBase)) ? m_mmu->get_rom_bank() : 0;
+		const auto it = m_symbols.find(get_symbol_key(bank, address));
+
+		return (it != m_symbols.end()) ? it->second.c_str() : nullptr;
+	}
+
+	//--------------------------------------------------------------------------
+
+	const uint8_t* Disassembly::get_bank_index(uint32_t bank)
+	{
+		if(!m_banks)
+		{
+			m_bankCount = m_rom->get_bank_count();
+
+			if(m_bankCount == 0)
+				return nullptr;
+
+			m_banks.reset(new BankIndex[m_bankCount]);
+
+			for(uint32_t i = 0; i < m_bankCount; i++)
+				m_banks[i].state = BankState::Empty;
+		}
+
+		// Bank numbers wrap in the same way Rom::get_bank wraps them.
+		BankIndex& index = m_banks[bank & (m_bankCount - 1)];
+
+		if(index.state.load(std::memory_order_acquire) != BankState::Ready)
+		{
+			if(!build_bank(bank & (m_bankCount - 1)))
+			{
+				// The background thread is part way through this bank.
+				while(index.state.load(std::memory_order_acquire) != BankState::Ready)
+					std::this_thread::yield();
+			}
+
+			start_thread();
+		}
+
+		return index.back.data();
+	}
+
+	bool Disassembly::build_bank(uint32_t bank)
+	{
+		BankIndex& index = m_banks[bank];
+		uint32_t expected = BankState::Empty;
+
+		if(!index.state.compare_exchange_strong(expected, BankState::Building, std::memory_order_acq_rel))
+			return expected == BankState::Ready;
+
+		index.back.resize(Rom::kBankSize);
+		decode(m_rom->get_bank(bank), Rom::kBankSize, index.back.data());
+
+		index.state.store(BankState::Ready, std::memory_order_release);
+		return true;
+	}
+
+	void Disassembly::build_ram()
+	{
+		bool bWorkingRamDirty = false;
+
+		for(uint32_t page = (kWorkingRam >> kPageShift); page < (kEchoRam >> kPageShift); page++)
+			bWorkingRamDirty |= m_ramDirty[page];
+
+		Byte data[0x2000];
+
+		for(const RamRegion& region : kRamRegions)
+		{
+			bool bDirty = (region.base == kEchoRam) && bWorkingRamDirty;
+
+			for(uint32_t page = (region.base >> kPageShift); page <= ((region.base + region.size - 1) >> kPageShift); page++)
+				bDirty |= m_ramDirty[page];
+
+			if(!bDirty)
+				continue;
+
+			for(uint32_t i = 0; i < region.size; i++)
+				data[i] = m_mmu->peek_byte(static_cast<Address>(region.base + i));
+
+			decode(data, region.size, &m_ramBack[region.base - kRamBase]);
+		}
+
+		memset(&m_ramDirty[kRamBase >> kPageShift], 0, kRamSize >> kPageShift);
+	}
+
+	void Disassembly::decode(const uint8_t* data, uint32_t size, uint8_t* back) const
+	{
+		uint32_t offset = 0;
+
+		while(offset < size)
+		{
+			const Byte opcode = data[offset];
+			Byte length = m_sizes[opcode];
+
+			if((opcode == 0xCB) && ((offset + 1) < size))
+				length = m_sizesExt[data[offset + 1]];
+
+			for(Byte i = 0; (i < length) && ((offset + i) < size); i++)
+				back[offset + i] = i;
+
+			offset += length;
+		}
+	}
+
+	void Disassembly::start_thread()
+	{
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+		if(!m_thread.joinable())
+		{
+			m_bStopping = false;
+			m_thread = std::thread(&Disassembly::thread_main, this);
+		}
+#endif
+	}
+
+	void Disassembly::stop_thread()
+	{
+		if(m_thread.joinable())
+		{
+			m_bStopping = true;
+			m_thread.join();
+		}
+	}
+
+	void Disassembly::thread_main()
+	{
+		for(uint32_t bank = 0; (bank < m_bankCount) && !m_bStopping; bank++)
+			build_bank(bank);
+	}
+
+	uint32_t Disassembly::get_symbol_key(uint32_t bank, Address address) const
+	{
+		if((address < kBankedFirst) || (address >= kRamBase))
+			bank = 0;
+
+		return (bank << 16) | address;
+	}
+
+	//--------------------------------------------------------------------------
+}
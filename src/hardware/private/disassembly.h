@@ -0,0 +1,115 @@
+#pragma once
+
+#include "types.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace gbhw
+{
+	class CPU;
+	class MMU;
+	class Rom;
+
+	//--------------------------------------------------------------------------
+
+	// Decoded instruction from the disassembly cache. Opcode details are looked
+	// up through CPU::get_instruction rather than copied into every line.
+	struct DisasmLine
+	{
+		Address			address;
+		uint16_t		bank;		// ROM bank for 0x0000-0x7FFF, 0 elsewhere.
+		Byte			size;
+		Byte			bytes[3];	// bytes[0] is the opcode, 0xCB prefixed opcodes follow it.
+		const char*		symbol;		// Label at address, null if there is none.
+	};
+
+	// Persistent linear-sweep disassembly, indexed so the instruction
+	// containing any address is found with a single lookup.
+	//
+	// ROM never changes once loaded, each bank is indexed once. The first query
+	// indexes the bank it needs and starts a background thread on the rest.
+	// RAM that may hold code (VRAM, external, work and zero-page RAM) is indexed
+	// per region and reindexed on the next query after a write to it.
+	//
+	// Symbols are imported from RGBDS .sym files. Symbols in the switchable
+	// ROM window are matched by bank, elsewhere the bank is ignored.
+	class Disassembly
+	{
+	public:
+		Disassembly();
+		~Disassembly();
+
+		void initialise(const CPU* cpu, const MMU* mmu, Rom* rom);
+
+		// Drops every index, the ROM is about to change.
+		void reset();
+
+		// MMU write hook, kept to a single store.
+		inline void invalidate(Address address);
+		void invalidate(Address first, uint32_t size);
+
+		// Start of the instruction containing address, in the banks mapped now.
+		Address find(Address address);
+		uint32_t get_lines(Address address, DisasmLine* lines, uint32_t count);
+
+		bool load_symbols(const char* path);
+		const char* find_symbol(Address address) const;
+
+	private:
+		struct BankState
+		{
+			enum Type
+			{
+				Empty = 0,
+				Building,
+				Ready
+			};
+		};
+
+		// Offset back from each byte to the start of its instruction.
+		struct BankIndex
+		{
+			std::atomic<uint32_t>	state;
+			Buffer					back;
+		};
+
+		static const uint32_t	kRamBase	= 0x8000;
+		static const uint32_t	kRamSize	= 0x8000;
+		static const uint32_t	kPageShift	= 8;
+
+		const uint8_t* get_bank_index(uint32_t bank);
+		bool build_bank(uint32_t bank);
+		void build_ram();
+		void decode(const uint8_t* data, uint32_t size, uint8_t* back) const;
+		void start_thread();
+		void stop_thread();
+		void thread_main();
+		uint32_t get_symbol_key(uint32_t bank, Address address) const;
+
+		const MMU*							m_mmu;
+		Rom*								m_rom;
+		Byte								m_sizes[256];
+		Byte								m_sizesExt[256];
+
+		std::unique_ptr<BankIndex[]>		m_banks;
+		uint32_t							m_bankCount;
+		std::thread							m_thread;
+		std::atomic<bool>					m_bStopping;
+
+		Byte								m_ramBack[kRamSize];
+		bool								m_ramDirty[256];	// Per 256 byte page of the whole address space.
+
+		std::unordered_map<uint32_t, std::string>	m_symbols;
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline void Disassembly::invalidate(Address address)
+	{
+		m_ramDirty[address >> kPageShift] = true;
+	}
+
+	//--------------------------------------------------------------------------
+}
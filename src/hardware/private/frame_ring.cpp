@@ -0,0 +1,135 @@
+#include "frame_ring.h"
+#include "log.h"
+#include <atomic>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		static_assert(sizeof(gbhw_frame_t) == 64,		"Frame header must stay one cache line");
+		static_assert(sizeof(gbhw_frame_ring_t) == 64,	"Ring header must stay one cache line");
+		static_assert(sizeof(gbhw_frame_t::dirty_lines) == sizeof(gbhw_screen_dirty_t::lines), "Dirty lines must match");
+		static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "Ring fields are accessed atomically in place");
+
+		// The ring may be shared with another process, so fields are accessed
+		// atomically in place rather than declared as std::atomic in the C API.
+		inline std::atomic<uint64_t>& atomic_ref(const uint64_t& value)
+		{
+			return *reinterpret_cast<std::atomic<uint64_t>*>(const_cast<uint64_t*>(&value));
+		}
+	}
+
+	//--------------------------------------------------------------------------
+
+	FrameRing::FrameRing()
+		: m_ring(nullptr)
+		, m_current(nullptr)
+		, m_sequence(0)
+	{
+	}
+
+	uint32_t FrameRing::get_size(uint32_t count, uint32_t width, uint32_t height)
+	{
+		const uint32_t slotSize = sizeof(gbhw_frame_t) + (width * height * 4);
+		return sizeof(gbhw_frame_ring_t) + (slotSize * count);
+	}
+
+	bool FrameRing::attach(void* memory, uint32_t size, uint32_t count, uint32_t width, uint32_t height)
+	{
+		detach();
+
+		// Two slots minimum, otherwise every frame overwrites the one a reader
+		// is most likely looking at.
+		if(!memory || count < 2 || size < get_size(count, width, height))
+		{
+			log_error("Frame ring memory is too small for %u frames\n", count);
+			return false;
+		}
+
+		memset(memory, 0, get_size(count, width, height));
+
+		m_ring				= static_cast<gbhw_frame_ring_t*>(memory);
+		m_ring->magic		= kMagic;
+		m_ring->version		= kVersion;
+		m_ring->count		= count;
+		m_ring->slot_size	= sizeof(gbhw_frame_t) + (width * height * 4);
+		m_ring->width		= width;
+		m_ring->height		= height;
+		m_ring->stride		= width * 4;
+		m_sequence			= 0;
+
+		std::atomic_thread_fence(std::memory_order_release);
+		return true;
+	}
+
+	void FrameRing::detach()
+	{
+		// A frame in flight is left with an odd fence, readers never accept it.
+		m_ring		= nullptr;
+		m_current	= nullptr;
+	}
+
+	uint8_t* FrameRing::begin_frame()
+	{
+		m_current = get_slot(++m_sequence);
+
+		// Seqlock write, mark the slot as in flight before touching the pixels.
+		std::atomic<uint64_t>& fence = atomic_ref(m_current->fence);
+		fence.store(fence.load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		atomic_ref(m_current->sequence).store(m_sequence, std::memory_order_relaxed);
+
+		return reinterpret_cast<uint8_t*>(m_current) + sizeof(gbhw_frame_t);
+	}
+
+	void FrameRing::end_frame(const gbhw_screen_dirty_t& dirty)
+	{
+		if(!m_current)
+			return;
+
+		m_current->dirty_count = dirty.count;
+		memcpy(m_current->dirty_lines, dirty.lines, sizeof(m_current->dirty_lines));
+
+		std::atomic<uint64_t>& fence = atomic_ref(m_current->fence);
+		fence.store(fence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		atomic_ref(m_ring->latest).store(m_sequence, std::memory_order_release);
+
+		m_current = nullptr;
+	}
+
+	bool FrameRing::acquire(const gbhw_frame_ring_t* ring, const gbhw_frame_t** frame, const uint8_t** pixels, uint64_t* fence)
+	{
+		if(ring->magic != kMagic || ring->version != kVersion || ring->count == 0)
+			return false;
+
+		const uint64_t latest = atomic_ref(ring->latest).load(std::memory_order_acquire);
+
+		if(latest == 0)
+			return false;
+
+		const uint8_t* slotBase = reinterpret_cast<const uint8_t*>(ring) + sizeof(gbhw_frame_ring_t);
+		const gbhw_frame_t* slot = reinterpret_cast<const gbhw_frame_t*>(slotBase + ((latest - 1) % ring->count) * ring->slot_size);
+
+		const uint64_t value = atomic_ref(slot->fence).load(std::memory_order_acquire);
+
+		// Odd is in flight, a different sequence means the writer lapped us.
+		if((value & 1) || (atomic_ref(slot->sequence).load(std::memory_order_relaxed) != latest))
+			return false;
+
+		*frame	= slot;
+		*pixels	= reinterpret_cast<const uint8_t*>(slot) + sizeof(gbhw_frame_t);
+		*fence	= value;
+		return true;
+	}
+
+	bool FrameRing::validate(const gbhw_frame_t* frame, uint64_t fence)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return atomic_ref(frame->fence).load(std::memory_order_relaxed) == fence;
+	}
+
+	//--------------------------------------------------------------------------
+}
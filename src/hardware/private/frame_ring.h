@@ -0,0 +1,56 @@
+#pragma once
+
+#include "gbhw.h"
+#include "types.h"
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Writer side of a gbhw_frame_ring_t, see gbhw.h for the layout and the
+	// protocol readers follow. Owned by the GPU, which asks for a slot when it
+	// starts a frame and publishes it on entering v-blank.
+	class FrameRing
+	{
+	public:
+		FrameRing();
+
+		static uint32_t get_size(uint32_t count, uint32_t width, uint32_t height);
+
+		bool attach(void* memory, uint32_t size, uint32_t count, uint32_t width, uint32_t height);
+		void detach();
+		inline bool is_attached() const;
+
+		uint8_t* begin_frame();
+		void end_frame(const gbhw_screen_dirty_t& dirty);
+
+		// Reader side.
+		static bool acquire(const gbhw_frame_ring_t* ring, const gbhw_frame_t** frame, const uint8_t** pixels, uint64_t* fence);
+		static bool validate(const gbhw_frame_t* frame, uint64_t fence);
+
+	private:
+		static const uint32_t	kMagic		= 0x52464247;	// 'GBFR'
+		static const uint32_t	kVersion	= 1;
+
+		inline gbhw_frame_t* get_slot(uint64_t sequence) const;
+
+		gbhw_frame_ring_t*		m_ring;
+		gbhw_frame_t*			m_current;		// Slot being rendered, null between frames.
+		uint64_t				m_sequence;		// Last sequence handed out.
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline bool FrameRing::is_attached() const
+	{
+		return m_ring != nullptr;
+	}
+
+	inline gbhw_frame_t* FrameRing::get_slot(uint64_t sequence) const
+	{
+		uint8_t* slotBase = reinterpret_cast<uint8_t*>(m_ring) + sizeof(gbhw_frame_ring_t);
+		return reinterpret_cast<gbhw_frame_t*>(slotBase + ((sequence - 1) % m_ring->count) * m_ring->slot_size);
+	}
+
+	//--------------------------------------------------------------------------
+}
@@ -0,0 +1,603 @@
+#include "framebuffer.h"
+#include "gbhw.h"
+#include "simd.h"
+
+#if HWSimdX86
+#include <immintrin.h>
+#elif HWSimdWasm
+#include <wasm_simd128.h>
+#endif
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		static const Byte kIndexMask = IndexedPixel::Count - 1;
+
+		void expand_indexed_scalar(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+		{
+			for(uint32_t i = 0; i < count; i++)
+				pixels[i] = palette[indexed[i] & kIndexMask];
+		}
+
+#if HWSimdX86 || HWSimdWasm
+		// The vector paths look up each byte of a pixel separately with pshufb,
+		// which indexes 16 entries at a time, so the palette is split into one
+		// 64 byte table per channel.
+		struct ChannelTables
+		{
+			ChannelTables(const uint32_t* palette)
+			{
+				const Byte* bytes = reinterpret_cast<const Byte*>(palette);
+
+				for(uint32_t i = 0; i < IndexedPixel::Count; i++)
+				{
+					for(uint32_t c = 0; c < 4; c++)
+						channels[c][i] = bytes[(i * 4) + c];
+				}
+			}
+
+			Byte channels[4][IndexedPixel::Count];
+		};
+#endif
+
+#if HWSimdX86
+
+		// Indices are split into four 16 entry blocks. XOR with the block base
+		// brings indices within the block to 0-15, then a saturating add of 0x70
+		// leaves those intact and sets the high bit of the rest, which pshufb
+		// turns into zeros. OR-ing the four lookups gives the full 64 entry one.
+		HWTargetSSSE3 void expand_indexed_ssse3(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+		{
+			const ChannelTables tables(palette);
+
+			__m128i table[4][4];
+
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				for(uint32_t b = 0; b < 4; b++)
+					table[c][b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables.channels[c][b * 16]));
+			}
+
+			const __m128i mask = _mm_set1_epi8(kIndexMask);
+			const __m128i bias = _mm_set1_epi8(0x70);
+
+			uint32_t i = 0;
+
+			for(; (i + 16) <= count; i += 16)
+			{
+				const __m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indexed + i)), mask);
+
+				__m128i select[4];
+
+				for(uint32_t b = 0; b < 4; b++)
+					select[b] = _mm_adds_epu8(_mm_xor_si128(v, _mm_set1_epi8(static_cast<char>(b * 16))), bias);
+
+				__m128i channel[4];
+
+				for(uint32_t c = 0; c < 4; c++)
+				{
+					channel[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(table[c][0], select[0]), _mm_shuffle_epi8(table[c][1], select[1])),
+											  _mm_or_si128(_mm_shuffle_epi8(table[c][2], select[2]), _mm_shuffle_epi8(table[c][3], select[3])));
+				}
+
+				// Interleave the channels back into pixels.
+				const __m128i lo01 = _mm_unpacklo_epi8(channel[0], channel[1]);
+				const __m128i hi01 = _mm_unpackhi_epi8(channel[0], channel[1]);
+				const __m128i lo23 = _mm_unpacklo_epi8(channel[2], channel[3]);
+				const __m128i hi23 = _mm_unpackhi_epi8(channel[2], channel[3]);
+
+				__m128i* out = reinterpret_cast<__m128i*>(pixels + i);
+				_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo01, lo23));
+				_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo01, lo23));
+				_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi01, hi23));
+				_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi01, hi23));
+			}
+
+			expand_indexed_scalar(indexed + i, palette, count - i, pixels + i);
+		}
+
+		// As the SSSE3 path on 32 pixels at a time, pshufb and the unpacks work
+		// within 128-bit lanes so the lanes are put back in order on store.
+		HWTargetAVX2 void expand_indexed_avx2(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+		{
+			const ChannelTables tables(palette);
+
+			__m256i table[4][4];
+
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				for(uint32_t b = 0; b < 4; b++)
+					table[c][b] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&tables.channels[c][b * 16])));
+			}
+
+			const __m256i mask = _mm256_set1_epi8(kIndexMask);
+			const __m256i bias = _mm256_set1_epi8(0x70);
+
+			uint32_t i = 0;
+
+			for(; (i + 32) <= count; i += 32)
+			{
+				const __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indexed + i)), mask);
+
+				__m256i select[4];
+
+				for(uint32_t b = 0; b < 4; b++)
+					select[b] = _mm256_adds_epu8(_mm256_xor_si256(v, _mm256_set1_epi8(static_cast<char>(b * 16))), bias);
+
+				__m256i channel[4];
+
+				for(uint32_t c = 0; c < 4; c++)
+				{
+					channel[c] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(table[c][0], select[0]), _mm256_shuffle_epi8(table[c][1], select[1])),
+												 _mm256_or_si256(_mm256_shuffle_epi8(table[c][2], select[2]), _mm256_shuffle_epi8(table[c][3], select[3])));
+				}
+
+				const __m256i lo01 = _mm256_unpacklo_epi8(channel[0], channel[1]);
+				const __m256i hi01 = _mm256_unpackhi_epi8(channel[0], channel[1]);
+				const __m256i lo23 = _mm256_unpacklo_epi8(channel[2], channel[3]);
+				const __m256i hi23 = _mm256_unpackhi_epi8(channel[2], channel[3]);
+
+				// Each holds 4 pixels from the low lane and the matching 4 from the high lane.
+				const __m256i p0 = _mm256_unpacklo_epi16(lo01, lo23);	// 0-3,   16-19
+				const __m256i p1 = _mm256_unpackhi_epi16(lo01, lo23);	// 4-7,   20-23
+				const __m256i p2 = _mm256_unpacklo_epi16(hi01, hi23);	// 8-11,  24-27
+				const __m256i p3 = _mm256_unpackhi_epi16(hi01, hi23);	// 12-15, 28-31
+
+				__m256i* out = reinterpret_cast<__m256i*>(pixels + i);
+				_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+				_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+				_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+				_mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+			}
+
+			expand_indexed_scalar(indexed + i, palette, count - i, pixels + i);
+		}
+#elif HWSimdWasm
+		// Swizzle zeroes lanes with an index of 16 or more, so the XOR with the
+		// block base is enough to select one block without the SSSE3 bias.
+		void expand_indexed_simd128(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+		{
+			const ChannelTables tables(palette);
+
+			v128_t table[4][4];
+
+			for(uint32_t c = 0; c < 4; c++)
+			{
+				for(uint32_t b = 0; b < 4; b++)
+					table[c][b] = wasm_v128_load(&tables.channels[c][b * 16]);
+			}
+
+			const v128_t mask = wasm_i8x16_splat(kIndexMask);
+
+			uint32_t i = 0;
+
+			for(; (i + 16) <= count; i += 16)
+			{
+				const v128_t v = wasm_v128_and(wasm_v128_load(indexed + i), mask);
+
+				v128_t select[4];
+
+				for(uint32_t b = 0; b < 4; b++)
+					select[b] = wasm_v128_xor(v, wasm_i8x16_splat(static_cast<int8_t>(b * 16)));
+
+				v128_t channel[4];
+
+				for(uint32_t c = 0; c < 4; c++)
+				{
+					channel[c] = wasm_v128_or(wasm_v128_or(wasm_i8x16_swizzle(table[c][0], select[0]), wasm_i8x16_swizzle(table[c][1], select[1])),
+											  wasm_v128_or(wasm_i8x16_swizzle(table[c][2], select[2]), wasm_i8x16_swizzle(table[c][3], select[3])));
+				}
+
+				const v128_t lo01 = wasm_i8x16_shuffle(channel[0], channel[1], 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+				const v128_t hi01 = wasm_i8x16_shuffle(channel[0], channel[1], 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+				const v128_t lo23 = wasm_i8x16_shuffle(channel[2], channel[3], 0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+				const v128_t hi23 = wasm_i8x16_shuffle(channel[2], channel[3], 8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+
+				uint32_t* out = pixels + i;
+				wasm_v128_store(out + 0, wasm_i16x8_shuffle(lo01, lo23, 0, 8, 1, 9, 2, 10, 3, 11));
+				wasm_v128_store(out + 4, wasm_i16x8_shuffle(lo01, lo23, 4, 12, 5, 13, 6, 14, 7, 15));
+				wasm_v128_store(out + 8, wasm_i16x8_shuffle(hi01, hi23, 0, 8, 1, 9, 2, 10, 3, 11));
+				wasm_v128_store(out + 12, wasm_i16x8_shuffle(hi01, hi23, 4, 12, 5, 13, 6, 14, 7, 15));
+			}
+
+			expand_indexed_scalar(indexed + i, palette, count - i, pixels + i);
+		}
+#endif
+
+		//----------------------------------------------------------------------
+		// Nearest neighbour, each source row is widened into the first output
+		// row which is then copied to the rest.
+		//----------------------------------------------------------------------
+
+		typedef void(*WidenRowFunc)(const uint32_t* pixels, uint32_t width, uint32_t* output);
+
+		template<uint32_t Factor>
+		void widen_row_scalar(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			for(uint32_t x = 0; x < width; x++)
+			{
+				for(uint32_t i = 0; i < Factor; i++)
+					*output++ = pixels[x];
+			}
+		}
+
+#if HWSimdX86
+		HWTargetSSE2 void widen_row_2x_sse2(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 0), _mm_unpacklo_epi32(v, v));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi32(v, v));
+			}
+
+			widen_row_scalar<2>(pixels + x, width - x, output);
+		}
+
+		HWTargetSSE2 void widen_row_3x_sse2(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 12)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 0), _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+			}
+
+			widen_row_scalar<3>(pixels + x, width - x, output);
+		}
+
+		HWTargetSSE2 void widen_row_4x_sse2(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 16)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 0), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 0, 0)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 12), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+			}
+
+			widen_row_scalar<4>(pixels + x, width - x, output);
+		}
+
+		// AVX2 permutes cross lanes, each output vector selects its pixels from
+		// 8 source pixels with one permute.
+		template<uint32_t Factor>
+		HWTargetAVX2 void widen_row_avx2(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			__m256i select[Factor];
+
+			for(uint32_t i = 0; i < Factor; i++)
+			{
+				const int base = i * 8;
+				select[i] = _mm256_setr_epi32((base + 0) / Factor, (base + 1) / Factor, (base + 2) / Factor, (base + 3) / Factor,
+											  (base + 4) / Factor, (base + 5) / Factor, (base + 6) / Factor, (base + 7) / Factor);
+			}
+
+			uint32_t x = 0;
+
+			for(; (x + 8) <= width; x += 8, output += 8 * Factor)
+			{
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x));
+
+				for(uint32_t i = 0; i < Factor; i++)
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + (i * 8)), _mm256_permutevar8x32_epi32(v, select[i]));
+			}
+
+			widen_row_scalar<Factor>(pixels + x, width - x, output);
+		}
+#elif HWSimdWasm
+		void widen_row_2x_simd128(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 8)
+			{
+				const v128_t v = wasm_v128_load(pixels + x);
+				wasm_v128_store(output + 0, wasm_i32x4_shuffle(v, v, 0, 0, 1, 1));
+				wasm_v128_store(output + 4, wasm_i32x4_shuffle(v, v, 2, 2, 3, 3));
+			}
+
+			widen_row_scalar<2>(pixels + x, width - x, output);
+		}
+
+		void widen_row_3x_simd128(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 12)
+			{
+				const v128_t v = wasm_v128_load(pixels + x);
+				wasm_v128_store(output + 0, wasm_i32x4_shuffle(v, v, 0, 0, 0, 1));
+				wasm_v128_store(output + 4, wasm_i32x4_shuffle(v, v, 1, 1, 2, 2));
+				wasm_v128_store(output + 8, wasm_i32x4_shuffle(v, v, 2, 3, 3, 3));
+			}
+
+			widen_row_scalar<3>(pixels + x, width - x, output);
+		}
+
+		void widen_row_4x_simd128(const uint32_t* pixels, uint32_t width, uint32_t* output)
+		{
+			uint32_t x = 0;
+
+			for(; (x + 4) <= width; x += 4, output += 16)
+			{
+				const v128_t v = wasm_v128_load(pixels + x);
+				wasm_v128_store(output + 0, wasm_i32x4_shuffle(v, v, 0, 0, 0, 0));
+				wasm_v128_store(output + 4, wasm_i32x4_shuffle(v, v, 1, 1, 1, 1));
+				wasm_v128_store(output + 8, wasm_i32x4_shuffle(v, v, 2, 2, 2, 2));
+				wasm_v128_store(output + 12, wasm_i32x4_shuffle(v, v, 3, 3, 3, 3));
+			}
+
+			widen_row_scalar<4>(pixels + x, width - x, output);
+		}
+#endif
+
+		WidenRowFunc get_widen_row(uint32_t factor)
+		{
+#if HWSimdX86
+			const simd::Level::Type level = simd::get_level();
+
+			if(level >= simd::Level::AVX2)
+				return (factor == 2) ? widen_row_avx2<2> : ((factor == 3) ? widen_row_avx2<3> : widen_row_avx2<4>);
+
+			if(level >= simd::Level::SSE2)
+				return (factor == 2) ? widen_row_2x_sse2 : ((factor == 3) ? widen_row_3x_sse2 : widen_row_4x_sse2);
+#elif HWSimdWasm
+			if(simd::get_level() == simd::Level::Simd128)
+				return (factor == 2) ? widen_row_2x_simd128 : ((factor == 3) ? widen_row_3x_simd128 : widen_row_4x_simd128);
+#endif
+			return (factor == 2) ? widen_row_scalar<2> : ((factor == 3) ? widen_row_scalar<3> : widen_row_scalar<4>);
+		}
+
+		void scale_nearest(const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t factor, uint32_t* output, uint32_t pitch)
+		{
+			const WidenRowFunc widen_row = get_widen_row(factor);
+
+			for(uint32_t y = 0; y < height; y++)
+			{
+				uint32_t* row = output + (y * factor * pitch);
+				widen_row(pixels + (y * width), width, row);
+
+				for(uint32_t i = 1; i < factor; i++)
+					memcpy(row + (i * pitch), row, width * factor * sizeof(uint32_t));
+			}
+		}
+
+		//----------------------------------------------------------------------
+		// Scale2x/EPX, each pixel P becomes a 2x2 block, a corner takes the
+		// colour of the two neighbours it touches when they match and the
+		// opposite pair doesn't. Edges repeat the border pixels.
+		//
+		//	  A			E0 E1
+		//	C P B	->	E2 E3
+		//	  D
+		//----------------------------------------------------------------------
+
+		void scale2x_row_scalar(const uint32_t* up, const uint32_t* row, const uint32_t* down, uint32_t width, uint32_t begin, uint32_t end, uint32_t* out0, uint32_t* out1)
+		{
+			for(uint32_t x = begin; x < end; x++)
+			{
+				const uint32_t p = row[x];
+				const uint32_t a = up[x];
+				const uint32_t b = row[(x + 1) < width ? (x + 1) : x];
+				const uint32_t c = row[x > 0 ? (x - 1) : x];
+				const uint32_t d = down[x];
+
+				out0[(x * 2) + 0] = ((c == a) && (c != d) && (a != b)) ? a : p;
+				out0[(x * 2) + 1] = ((a == b) && (a != c) && (b != d)) ? b : p;
+				out1[(x * 2) + 0] = ((d == c) && (d != b) && (c != a)) ? c : p;
+				out1[(x * 2) + 1] = ((b == d) && (b != a) && (d != c)) ? d : p;
+			}
+		}
+
+#if HWSimdX86
+		// Interior pixels in blocks, the neighbour loads at x - 1 and x + 1 stay
+		// within the row so only the first and last pixels need the scalar path.
+		HWTargetSSE2 uint32_t scale2x_row_sse2(const uint32_t* up, const uint32_t* row, const uint32_t* down, uint32_t width, uint32_t* out0, uint32_t* out1)
+		{
+			uint32_t x = 1;
+
+			for(; (x + 5) <= width; x += 4)
+			{
+				const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 1));
+				const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 1));
+				const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+
+				const __m128i ca = _mm_cmpeq_epi32(c, a);
+				const __m128i cd = _mm_cmpeq_epi32(c, d);
+				const __m128i ab = _mm_cmpeq_epi32(a, b);
+				const __m128i bd = _mm_cmpeq_epi32(b, d);
+
+				const __m128i m0 = _mm_andnot_si128(ab, _mm_andnot_si128(cd, ca));
+				const __m128i m1 = _mm_andnot_si128(bd, _mm_andnot_si128(ca, ab));
+				const __m128i m2 = _mm_andnot_si128(ca, _mm_andnot_si128(bd, cd));
+				const __m128i m3 = _mm_andnot_si128(cd, _mm_andnot_si128(ab, bd));
+
+				const __m128i e0 = _mm_or_si128(_mm_and_si128(m0, a), _mm_andnot_si128(m0, p));
+				const __m128i e1 = _mm_or_si128(_mm_and_si128(m1, b), _mm_andnot_si128(m1, p));
+				const __m128i e2 = _mm_or_si128(_mm_and_si128(m2, c), _mm_andnot_si128(m2, p));
+				const __m128i e3 = _mm_or_si128(_mm_and_si128(m3, d), _mm_andnot_si128(m3, p));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out0 + (x * 2) + 0), _mm_unpacklo_epi32(e0, e1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out0 + (x * 2) + 4), _mm_unpackhi_epi32(e0, e1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out1 + (x * 2) + 0), _mm_unpacklo_epi32(e2, e3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out1 + (x * 2) + 4), _mm_unpackhi_epi32(e2, e3));
+			}
+
+			return x;
+		}
+
+		HWTargetAVX2 uint32_t scale2x_row_avx2(const uint32_t* up, const uint32_t* row, const uint32_t* down, uint32_t width, uint32_t* out0, uint32_t* out1)
+		{
+			uint32_t x = 1;
+
+			for(; (x + 9) <= width; x += 8)
+			{
+				const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + x));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 1));
+				const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x - 1));
+				const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + x));
+
+				const __m256i ca = _mm256_cmpeq_epi32(c, a);
+				const __m256i cd = _mm256_cmpeq_epi32(c, d);
+				const __m256i ab = _mm256_cmpeq_epi32(a, b);
+				const __m256i bd = _mm256_cmpeq_epi32(b, d);
+
+				const __m256i m0 = _mm256_andnot_si256(ab, _mm256_andnot_si256(cd, ca));
+				const __m256i m1 = _mm256_andnot_si256(bd, _mm256_andnot_si256(ca, ab));
+				const __m256i m2 = _mm256_andnot_si256(ca, _mm256_andnot_si256(bd, cd));
+				const __m256i m3 = _mm256_andnot_si256(cd, _mm256_andnot_si256(ab, bd));
+
+				const __m256i e0 = _mm256_blendv_epi8(p, a, m0);
+				const __m256i e1 = _mm256_blendv_epi8(p, b, m1);
+				const __m256i e2 = _mm256_blendv_epi8(p, c, m2);
+				const __m256i e3 = _mm256_blendv_epi8(p, d, m3);
+
+				// Unpacks work within lanes, swap the middle halves back into order.
+				const __m256i lo01 = _mm256_unpacklo_epi32(e0, e1);
+				const __m256i hi01 = _mm256_unpackhi_epi32(e0, e1);
+				const __m256i lo23 = _mm256_unpacklo_epi32(e2, e3);
+				const __m256i hi23 = _mm256_unpackhi_epi32(e2, e3);
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out0 + (x * 2) + 0), _mm256_permute2x128_si256(lo01, hi01, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out0 + (x * 2) + 8), _mm256_permute2x128_si256(lo01, hi01, 0x31));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out1 + (x * 2) + 0), _mm256_permute2x128_si256(lo23, hi23, 0x20));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out1 + (x * 2) + 8), _mm256_permute2x128_si256(lo23, hi23, 0x31));
+			}
+
+			return x;
+		}
+#elif HWSimdWasm
+		uint32_t scale2x_row_simd128(const uint32_t* up, const uint32_t* row, const uint32_t* down, uint32_t width, uint32_t* out0, uint32_t* out1)
+		{
+			uint32_t x = 1;
+
+			for(; (x + 5) <= width; x += 4)
+			{
+				const v128_t p = wasm_v128_load(row + x);
+				const v128_t a = wasm_v128_load(up + x);
+				const v128_t b = wasm_v128_load(row + x + 1);
+				const v128_t c = wasm_v128_load(row + x - 1);
+				const v128_t d = wasm_v128_load(down + x);
+
+				const v128_t ca = wasm_i32x4_eq(c, a);
+				const v128_t cd = wasm_i32x4_eq(c, d);
+				const v128_t ab = wasm_i32x4_eq(a, b);
+				const v128_t bd = wasm_i32x4_eq(b, d);
+
+				// wasm andnot clears the bits of its second operand.
+				const v128_t m0 = wasm_v128_andnot(wasm_v128_andnot(ca, cd), ab);
+				const v128_t m1 = wasm_v128_andnot(wasm_v128_andnot(ab, ca), bd);
+				const v128_t m2 = wasm_v128_andnot(wasm_v128_andnot(cd, bd), ca);
+				const v128_t m3 = wasm_v128_andnot(wasm_v128_andnot(bd, ab), cd);
+
+				const v128_t e0 = wasm_v128_bitselect(a, p, m0);
+				const v128_t e1 = wasm_v128_bitselect(b, p, m1);
+				const v128_t e2 = wasm_v128_bitselect(c, p, m2);
+				const v128_t e3 = wasm_v128_bitselect(d, p, m3);
+
+				wasm_v128_store(out0 + (x * 2) + 0, wasm_i32x4_shuffle(e0, e1, 0, 4, 1, 5));
+				wasm_v128_store(out0 + (x * 2) + 4, wasm_i32x4_shuffle(e0, e1, 2, 6, 3, 7));
+				wasm_v128_store(out1 + (x * 2) + 0, wasm_i32x4_shuffle(e2, e3, 0, 4, 1, 5));
+				wasm_v128_store(out1 + (x * 2) + 4, wasm_i32x4_shuffle(e2, e3, 2, 6, 3, 7));
+			}
+
+			return x;
+		}
+#endif
+
+		void scale_2x(const uint32_t* pixels, uint32_t width, uint32_t height, uint32_t* output, uint32_t pitch)
+		{
+			const simd::Level::Type level = simd::get_level();
+
+			for(uint32_t y = 0; y < height; y++)
+			{
+				const uint32_t* row		= pixels + (y * width);
+				const uint32_t* up		= (y > 0) ? (row - width) : row;
+				const uint32_t* down	= ((y + 1) < height) ? (row + width) : row;
+				uint32_t* out0			= output + (y * 2 * pitch);
+				uint32_t* out1			= out0 + pitch;
+				uint32_t x				= 0;
+
+#if HWSimdX86
+				if(level >= simd::Level::SSE2 && width > 2)
+				{
+					scale2x_row_scalar(up, row, down, width, 0, 1, out0, out1);
+					x = (level >= simd::Level::AVX2) ? scale2x_row_avx2(up, row, down, width, out0, out1) : scale2x_row_sse2(up, row, down, width, out0, out1);
+				}
+#elif HWSimdWasm
+				if(level == simd::Level::Simd128 && width > 2)
+				{
+					scale2x_row_scalar(up, row, down, width, 0, 1, out0, out1);
+					x = scale2x_row_simd128(up, row, down, width, out0, out1);
+				}
+#else
+				(void)level;
+#endif
+				scale2x_row_scalar(up, row, down, width, x, width, out0, out1);
+			}
+		}
+	}
+
+	//--------------------------------------------------------------------------
+
+	void expand_indexed(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+	{
+#if HWSimdX86
+		switch(simd::get_level())
+		{
+			case simd::Level::AVX2:		expand_indexed_avx2(indexed, palette, count, pixels);	return;
+			case simd::Level::SSSE3:	expand_indexed_ssse3(indexed, palette, count, pixels);	return;
+			default:					break;
+		}
+#elif HWSimdWasm
+		if(simd::get_level() == simd::Level::Simd128)
+		{
+			expand_indexed_simd128(indexed, palette, count, pixels);
+			return;
+		}
+#endif
+		expand_indexed_scalar(indexed, palette, count, pixels);
+	}
+
+	//--------------------------------------------------------------------------
+
+	static_assert((static_cast<int>(Scaler::Nearest2x) == scaler_nearest_2x) && (static_cast<int>(Scaler::Nearest3x) == scaler_nearest_3x) &&
+				  (static_cast<int>(Scaler::Nearest4x) == scaler_nearest_4x) && (static_cast<int>(Scaler::Scale2x) == scaler_scale2x), "Scalers must match the public API");
+
+	uint32_t Scaler::get_factor(Type scaler)
+	{
+		switch(scaler)
+		{
+			case Nearest2x:	return 2;
+			case Nearest3x:	return 3;
+			case Nearest4x:	return 4;
+			case Scale2x:	return 2;
+			default:		return 0;
+		}
+	}
+
+	void scale(const uint32_t* pixels, uint32_t width, uint32_t height, Scaler::Type scaler, uint32_t* output, uint32_t pitch)
+	{
+		if(scaler == Scaler::Scale2x)
+			scale_2x(pixels, width, height, output, pitch);
+		else
+			scale_nearest(pixels, width, height, Scaler::get_factor(scaler), output, pitch);
+	}
+
+	//--------------------------------------------------------------------------
+}
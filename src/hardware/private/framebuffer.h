@@ -0,0 +1,50 @@
+#pragma once
+
+#include "types.h"
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Indexed pixels, one byte each:
+	//
+	// Bits 0-1	- Colour within the palette.
+	// Bits 2-4	- Palette number.
+	// Bit  5	- Set for sprite palettes, clear for background.
+	struct IndexedPixel
+	{
+		enum Type
+		{
+			ColourMask		= 0x03,
+			PaletteShift	= 2,
+			Sprite			= 0x20,
+			Count			= 64	// Distinct values, the size of an expansion palette.
+		};
+	};
+
+	// Converts indexed pixels to 32-bit pixels through a 64 entry palette, uses
+	// the widest vector path the CPU supports.
+	void expand_indexed(const Byte* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels);
+
+	//--------------------------------------------------------------------------
+
+	struct Scaler
+	{
+		enum Type
+		{
+			Nearest2x = 0,
+			Nearest3x,
+			Nearest4x,
+			Scale2x,		// EPX edge smoothing, output is 2x.
+			Count
+		};
+
+		static uint32_t get_factor(Type scaler);
+	};
+
+	// Scales a 32-bit image, pitch is the distance between output rows in
+	// pixels and at least width * Scaler::get_factor(scaler).
+	void scale(const uint32_t* pixels, uint32_t width, uint32_t height, Scaler::Type scaler, uint32_t* output, uint32_t pitch);
+
+	//--------------------------------------------------------------------------
+}
@@ -1,11 +1,19 @@
 #include "gbhw.h"
 #include "gbhw_debug.h"
+#include "breakpoints.h"
+#include "capture.h"
 #include "cpu.h"
+#include "disassembly.h"
 #include "gpu.h"
 #include "log.h"
 #include "mmu.h"
+#include "netplay.h"
+#include "perf.h"
 #include "rom.h"
+#include "serial.h"
 #include "timer.h"
+#include "trace.h"
+#include "worker_pool.h"
 
 using namespace gbhw;
 
@@ -13,13 +21,92 @@ extern "C"
 {
 	typedef struct gbhw_context
 	{
-		CPU		cpu;
-		GPU		gpu;
-		MMU		mmu;
-		Rom		rom;
-		Timer	timer;
+		CPU				cpu;
+		GPU				gpu;
+		MMU				mmu;
+		Rom				rom;
+		Timer			timer;
+		Serial			serial;
+		PerfCounters	perf;
+		Breakpoints		breakpoints;
+		Disassembly		disassembly;
+		TraceWriter*	trace;
+		CaptureWriter*	capture;
+		gbhw_batch_t	batch;			// Owning batch, null unless created by one.
 	} gbhw_context, *gbhw_context_t;
 
+	// Contexts are a single allocation, each worker steps a fixed slice of it.
+	typedef struct gbhw_batch
+	{
+		gbhw_context*	contexts;
+		uint32_t		count;
+		WorkerPool		pool;
+	} gbhw_batch, *gbhw_batch_t;
+
+	typedef struct gbhw_netplay
+	{
+		Netplay			netplay;
+	} gbhw_netplay, *gbhw_netplay_t;
+
+	typedef struct gbhw_loopback
+	{
+		LoopbackLink	link;
+	} gbhw_loopback, *gbhw_loopback_t;
+
+	namespace
+	{
+		void initialise_context(gbhw_context_t res)
+		{
+			res->trace = nullptr;
+			res->capture = nullptr;
+			res->batch = nullptr;
+			res->cpu.initialise(&res->mmu, &res->perf, &res->breakpoints);
+			res->gpu.initialise(&res->cpu, &res->mmu, &res->perf);
+			res->mmu.initialise(&res->cpu, &res->gpu, &res->rom, &res->timer, &res->serial, &res->perf, &res->breakpoints, &res->disassembly);
+			res->timer.initialise(&res->cpu, &res->mmu);
+			res->serial.initialise(&res->cpu, &res->mmu);
+			res->disassembly.initialise(&res->cpu, &res->mmu, &res->rom);
+		}
+
+		void copy_context(gbhw_context_t dst, gbhw_context_t src)
+		{
+			// Only a different ROM needs indexing again, the disassembly may be
+			// reading the current one in the background.
+			if(!dst->rom.is_same_data(src->rom))
+			{
+				dst->disassembly.reset();
+				dst->rom = src->rom;
+			}
+			else
+			{
+				dst->disassembly.invalidate(0x8000, 0x8000);
+			}
+
+			// Components are wired to their own context, only state is taken on.
+			dst->cpu.fork(src->cpu);
+			dst->gpu.copy_state(src->gpu);
+			dst->mmu.fork(src->mmu);
+			dst->timer.fork(src->timer);
+			dst->serial.fork(src->serial);
+		}
+
+		void fork_context(gbhw_context_t res, gbhw_context_t parent)
+		{
+			copy_context(res, parent);
+			res->gpu.copy_screen(parent->gpu);
+			res->perf			= parent->perf;
+			res->breakpoints	= parent->breakpoints;
+		}
+
+		void load_rom(gbhw_context_t ctx, gbhw_settings_t* settings)
+		{
+			if(settings->rom_path)
+				gbhw_load_rom_file(ctx, settings->rom_path);
+			else if(settings->rom)
+				gbhw_load_rom_memory(ctx, settings->rom, settings->rom_size);
+		}
+	}
+
 	HWPublicAPI gbhw_errorcode_t gbhw_create(gbhw_settings_t* settings, gbhw_context_t* ctx)
 	{
 		if(!settings || !ctx)
@@ -29,18 +116,11 @@ extern "C"
 		Log::instance().initialise(settings->log_level, settings->log_callback, settings->log_userdata);
 
 		// Initialise components.
-		gbhw_context_t res = new gbhw_context;
-		res->cpu.initialise(&res->mmu);
-		res->gpu.initialise(&res->cpu, &res->mmu);
-		res->mmu.initialise(&res->cpu, &res->gpu, &res->rom);
-		res->timer.initialise(&res->cpu, &res->mmu);
-		*ctx = res;
+		*ctx = new gbhw_context;
+		initialise_context(*ctx);
 
 		// Attempt to load ROM.
-		if(settings->rom_path)
-			gbhw_load_rom_file(*ctx, settings->rom_path);
-		else if(settings->rom)
-			gbhw_load_rom_memory(*ctx, settings->rom, settings->rom_size);
+		load_rom(*ctx, settings);
 
 		return e_success;
 	}
@@ -50,9 +130,206 @@ extern "C"
 		if(!ctx)
 			return;
 
+		gbhw_trace_stop(ctx);
+		gbhw_capture_stop(ctx);
 		delete ctx;
 	}
 
+	HWPublicAPI gbhw_errorcode_t gbhw_fork(gbhw_context_t ctx, gbhw_context_t* child)
+	{
+		if(!ctx || !child)
+			return e_invalidparam;
+
+		*child = new gbhw_context;
+		initialise_context(*child);
+		fork_context(*child, ctx);
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_copy_state(gbhw_context_t dst, gbhw_context_t src)
+	{
+		if(!dst || !src)
+			return e_invalidparam;
+
+		if(dst != src)
+			copy_context(dst, src);
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_batch_create(gbhw_settings_t* settings, gbhw_batch_settings_t* batchSettings, gbhw_batch_t* batch)
+	{
+		if(!settings || !batchSettings || !batch || (batchSettings->count == 0))
+			return e_invalidparam;
+
+		Log::instance().initialise(settings->log_level, settings->log_callback, settings->log_userdata);
+
+		// The ROM is loaded once, every other context is a fork of the first.
+		gbhw_batch_t res = new gbhw_batch;
+		res->contexts	= new gbhw_context[batchSettings->count];
+		res->count		= batchSettings->count;
+
+		initialise_context(&res->contexts[0]);
+		load_rom(&res->contexts[0], settings);
+
+		for(uint32_t i = 1; i < res->count; i++)
+		{
+			initialise_context(&res->contexts[i]);
+			fork_context(&res->contexts[i], &res->contexts[0]);
+		}
+
+		for(uint32_t i = 0; i < res->count; i++)
+			res->contexts[i].batch = res;
+
+		res->pool.initialise(batchSettings->threads, batchSettings->pin_threads != 0);
+		*batch = res;
+
+		return e_success;
+	}
+
+	HWPublicAPI void gbhw_batch_destroy(gbhw_batch_t batch)
+	{
+		if(!batch)
+			return;
+
+		for(uint32_t i = 0; i < batch->count; i++)
+		{
+			gbhw_trace_stop(&batch->contexts[i]);
+			gbhw_capture_stop(&batch->contexts[i]);
+		}
+
+		delete[] batch->contexts;
+		delete batch;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_batch_get_context(gbhw_batch_t batch, uint32_t index, gbhw_context_t* ctx)
+	{
+		if(!batch || !ctx || (index >= batch->count))
+			return e_invalidparam;
+
+		*ctx = &batch->contexts[index];
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_batch_step(gbhw_batch_t batch, gbhw_step_mode_t mode, gbhw_errorcode_t* results, const uint8_t** screens)
+	{
+		if(!batch)
+			return e_invalidparam;
+
+		const uint32_t workers = batch->pool.get_worker_count();
+
+		batch->pool.run([&](uint32_t worker)
+		{
+			const uint32_t first	= static_cast<uint32_t>((static_cast<uint64_t>(batch->count) * worker) / workers);
+			const uint32_t last		= static_cast<uint32_t>((static_cast<uint64_t>(batch->count) * (worker + 1)) / workers);
+
+			for(uint32_t i = first; i < last; i++)
+			{
+				gbhw_context_t ctx = &batch->contexts[i];
+				const gbhw_errorcode_t result = gbhw_step(ctx, mode);
+
+				if(results)
+					results[i] = result;
+
+				if(screens)
+					screens[i] = ctx->gpu.get_screen_data();
+			}
+		});
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_serial_connect(gbhw_context_t a, gbhw_context_t b)
+	{
+		if(!a || !b || (a == b))
+			return e_invalidparam;
+
+		// A worker may step both, waiting on a transfer it has yet to run.
+		if(a->batch && (a->batch == b->batch))
+			return e_invalidparam;
+
+		Serial::connect(a->serial, b->serial);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_serial_disconnect(gbhw_context_t ctx)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		ctx->serial.disconnect();
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_netplay_create(gbhw_context_t ctx, gbhw_netplay_settings_t* settings, gbhw_netplay_t* netplay)
+	{
+		if(!ctx || !settings || !netplay)
+			return e_invalidparam;
+
+		gbhw_netplay_t res = new gbhw_netplay;
+
+		if(!res->netplay.initialise(ctx, *settings))
+		{
+			delete res;
+			return e_invalidparam;
+		}
+
+		*netplay = res;
+		return e_success;
+	}
+
+	HWPublicAPI void gbhw_netplay_destroy(gbhw_netplay_t netplay)
+	{
+		delete netplay;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_netplay_advance(gbhw_netplay_t netplay, uint8_t buttons, uint32_t* advanced)
+	{
+		if(!netplay)
+			return e_invalidparam;
+
+		const bool bAdvanced = netplay->netplay.advance(buttons);
+
+		if(advanced)
+			*advanced = bAdvanced ? 1 : 0;
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_netplay_get_stats(gbhw_netplay_t netplay, gbhw_netplay_stats_t* stats)
+	{
+		if(!netplay || !stats)
+			return e_invalidparam;
+
+		*stats = netplay->netplay.get_stats();
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_loopback_create(uint32_t latency_ms, uint32_t loss_percent, gbhw_loopback_t* loopback)
+	{
+		if(!loopback)
+			return e_invalidparam;
+
+		*loopback = new gbhw_loopback;
+		(*loopback)->link.initialise(latency_ms, loss_percent);
+		return e_success;
+	}
+
+	HWPublicAPI void gbhw_loopback_destroy(gbhw_loopback_t loopback)
+	{
+		delete loopback;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_loopback_get_transport(gbhw_loopback_t loopback, uint32_t side, gbhw_netplay_transport_t* transport)
+	{
+		if(!loopback || (side > 1) || !transport)
+			return e_invalidparam;
+
+		loopback->link.get_transport(side, *transport);
+		return e_success;
+	}
+
 	HWPublicAPI gbhw_errorcode_t gbhw_load_rom_file(gbhw_context_t ctx, const char* path)
 	{
 		if(!ctx || !path)
@@ -78,10 +355,21 @@ extern "C"
 		if(!ctx || !memory || !length)
 			return e_invalidparam;
 
-		ctx->rom.load(memory, length);
+		// The MMU maps the current ROM until it is reset, a rejected image must
+		// leave it loaded.
+		Rom rom;
+
+		if(!rom.load(memory, length))
+			return e_failed;
+
+		// The disassembly indexes ROM banks in the background.
+		ctx->disassembly.reset();
+		ctx->rom = rom;
 
 		// Reset the mmu with rom cartridge type
 		ctx->mmu.reset(ctx->rom.get_cartridge_type());
+		ctx->timer.reset();
+		ctx->serial.reset(ctx->rom.get_hardware_type() == HardwareType::GameboyColour);
 
 		// @todo: Reset a whole bunch of other stuff too.
 
@@ -99,6 +387,76 @@ extern "C"
 		return e_success;
 	}
 
+	HWPublicAPI gbhw_errorcode_t gbhw_get_screen_dirty(gbhw_context_t ctx, gbhw_screen_dirty_t* dirty)
+	{
+		if(!ctx || !dirty)
+			return e_invalidparam;
+
+		*dirty = ctx->gpu.get_screen_dirty();
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_set_screen_format(gbhw_context_t ctx, gbhw_screen_format_t format)
+	{
+		if(!ctx || (format != format_rgb && format != format_indexed))
+			return e_invalidparam;
+
+		ctx->gpu.set_indexed(format == format_indexed);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_set_headless(gbhw_context_t ctx, uint32_t headless)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		ctx->gpu.set_headless(headless != 0);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_get_screen_indexed(gbhw_context_t ctx, const uint8_t** screen, const uint32_t** palette)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		if(screen)
+			*screen = ctx->gpu.get_indexed_data();
+
+		if(palette)
+			*palette = ctx->gpu.get_frame_palette();
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_expand_indexed(const uint8_t* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels)
+	{
+		if(!indexed || !palette || !pixels)
+			return e_invalidparam;
+
+		expand_indexed(indexed, palette, count, pixels);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_get_scaler_factor(gbhw_scaler_t scaler, uint32_t* factor)
+	{
+		if(!factor || (scaler < scaler_nearest_2x) || (scaler > scaler_scale2x))
+			return e_invalidparam;
+
+		*factor = Scaler::get_factor(static_cast<Scaler::Type>(scaler));
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_scale_screen(const uint8_t* screen, uint32_t width, uint32_t height, gbhw_scaler_t scaler, uint8_t* output, uint32_t pitch)
+	{
+		uint32_t factor = 0;
+
+		if(!screen || !output || (gbhw_get_scaler_factor(scaler, &factor) != e_success) || (pitch < (width * factor)))
+			return e_invalidparam;
+
+		scale(reinterpret_cast<const uint32_t*>(screen), width, height, static_cast<Scaler::Type>(scaler), reinterpret_cast<uint32_t*>(output), pitch);
+		return e_success;
+	}
+
 	HWPublicAPI gbhw_errorcode_t gbhw_get_screen_resolution(gbhw_context_t ctx, uint32_t* width, uint32_t* height)
 	{
 		if(!ctx)
@@ -113,23 +471,62 @@ extern "C"
 		return e_success;
 	}
 
+	static void capture_frame(gbhw_context_t ctx)
+	{
+		static_assert(kCapturePixels == (GPU::kScreenWidth * GPU::kScreenHeight), "Capture frames must match the screen");
+
+		CaptureFrame* frame = ctx->capture->acquire();
+
+		if(!frame)
+			return;
+
+		if(ctx->gpu.is_indexed())
+			expand_indexed(ctx->gpu.get_indexed_data(), ctx->gpu.get_frame_palette(), kCapturePixels, frame->pixels);
+		else
+			memcpy(frame->pixels, ctx->gpu.get_screen_data(), sizeof(frame->pixels));
+
+		ctx->capture->commit();
+	}
+
+	static uint16_t get_halt_cycles(gbhw_context_t ctx)
+	{
+		// Halted, the CPU only resumes on an interrupt, so skip straight to the
+		// next component that can raise one. The GPU runs at single speed.
+		static const uint32_t kMinCycles = 4;
+		static const uint32_t kMaxCycles = 0xFFFF;
+
+		// The serial port counts in master clock ticks and may need to meet
+		// the context it is connected to.
+		const uint64_t serialTicks = ctx->serial.get_ticks_to_event(ctx->cpu.get_clock()) >> (CPU::kClockShift - ctx->cpu.get_speed());
+
+		uint32_t cycles = std::min(ctx->timer.get_cycles_to_interrupt(), ctx->gpu.get_cycles_to_event() << ctx->cpu.get_speed());
+		cycles = static_cast<uint32_t>(std::min<uint64_t>(cycles, serialTicks));
+		cycles = std::max(cycles, kMinCycles);
+		cycles = std::min(cycles, kMaxCycles);
+
+		return static_cast<uint16_t>(cycles);
+	}
+
 	HWPublicAPI gbhw_errorcode_t gbhw_step(gbhw_context_t ctx, gbhw_step_mode_t mode)
 	{
 		if(!ctx)
 			return e_invalidparam;
 
 		// single cycle.
-		uint16_t cpucycles = 0;
+		uint32_t gpucycles = 0;
 		uint16_t maxcycles = 1;
+		uint32_t framecycles = 0;
 		bool bLoop = false;
 
+		ctx->breakpoints.resume(ctx->cpu.get_registers()->pc);
+
  		if (mode == step_vsync)
  		{
  			maxcycles = 1;
  			bLoop = true;
  		}
 
-		// Just updates interrupts when stop or halt is called.
+		// Just updates interrupts when stop is called.
 		if (ctx->cpu.is_stalled())
 		{
 			ctx->cpu.update_stalled();
@@ -138,18 +535,43 @@ extern "C"
 		{
 			do
 			{
-				cpucycles = ctx->cpu.update(maxcycles);
-				ctx->timer.update(cpucycles);
+				const uint64_t clock = ctx->cpu.get_clock();
+
+				if (ctx->cpu.is_halted())
+					ctx->cpu.update_halted(get_halt_cycles(ctx));
+				else
+					ctx->cpu.update(maxcycles);
 
-				cpucycles >>= ctx->cpu.get_speed();
+				// The timer counts CPU cycles and speeds up with the CPU, the GPU
+				// and H-Blank DMA take their cycles from the master clock.
+				ctx->timer.update(ctx->cpu.get_cycles());
+				ctx->serial.update(ctx->cpu.get_clock());
 
-				ctx->mmu.update(cpucycles);
-				ctx->gpu.update(cpucycles);
+				gpucycles = static_cast<uint32_t>((ctx->cpu.get_clock() >> CPU::kClockShift) - (clock >> CPU::kClockShift));
+				ctx->gpu.update(gpucycles);
 
 				if(ctx->cpu.is_bugchecked())
 					return e_failed;
 
-				if (ctx->cpu.is_stalled() || ctx->gpu.reset_vblank_notify())
+				if (ctx->cpu.is_stalled())
+					break;
+
+				if (ctx->breakpoints.is_triggered())
+					break;
+
+				if (ctx->gpu.reset_vblank_notify())
+				{
+					if (ctx->capture && !ctx->gpu.is_headless_frame())
+						capture_frame(ctx);
+
+					break;
+				}
+
+				// Never run longer than a frame, there is no vblank while the
+				// display is switched off.
+				framecycles += gpucycles;
+
+				if (framecycles >= GPU::kFrameCycles)
 					break;
 
 			} while (bLoop);
@@ -167,6 +589,217 @@ extern "C"
 		return e_success;
 	}
 
+	HWPublicAPI gbhw_errorcode_t gbhw_get_perf_counters(gbhw_context_t ctx, gbhw_perf_counters_t* counters)
+	{
+		if(!ctx || !counters)
+			return e_invalidparam;
+
+		*counters = ctx->perf;
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_reset_perf_counters(gbhw_context_t ctx)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		ctx->perf.reset();
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_trace_start(gbhw_context_t ctx, const char* path)
+	{
+		if(!ctx || !path)
+			return e_invalidparam;
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+		// Tracing drains on a background thread.
+		return e_failed;
+#else
+		gbhw_trace_stop(ctx);
+
+		TraceWriter* trace = new TraceWriter;
+
+		if(!trace->open(path))
+		{
+			delete trace;
+			return e_failed;
+		}
+
+		ctx->trace = trace;
+		ctx->cpu.set_trace(trace);
+		return e_success;
+#endif
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_trace_stop(gbhw_context_t ctx)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		if(ctx->trace)
+		{
+			ctx->cpu.set_trace(nullptr);
+			delete ctx->trace;
+			ctx->trace = nullptr;
+		}
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_trace_set_callback(gbhw_context_t ctx, gbhw_trace_callback_t callback, void* userdata)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		ctx->cpu.set_trace_callback(callback, userdata);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_capture_start(gbhw_context_t ctx, const char* path, gbhw_capture_mode_t mode)
+	{
+		if(!ctx || !path)
+			return e_invalidparam;
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+		// Frames are compressed on a background thread.
+		return e_failed;
+#else
+		gbhw_capture_stop(ctx);
+
+		CaptureWriter* capture = new CaptureWriter;
+
+		if(!capture->open(path, mode == capture_wait))
+		{
+			delete capture;
+			return e_failed;
+		}
+
+		ctx->capture = capture;
+		return e_success;
+#endif
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_capture_stop(gbhw_context_t ctx)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		if(ctx->capture)
+		{
+			delete ctx->capture;
+			ctx->capture = nullptr;
+		}
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_capture_get_dropped(gbhw_context_t ctx, uint64_t* dropped)
+	{
+		if(!ctx || !dropped)
+			return e_invalidparam;
+
+		*dropped = ctx->capture ? ctx->capture->get_dropped() : 0;
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_get_frame_ring_size(uint32_t count, uint32_t* size)
+	{
+		if(count < 2 || !size)
+			return e_invalidparam;
+
+		*size = FrameRing::get_size(count, GPU::kScreenWidth, GPU::kScreenHeight);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_set_frame_ring(gbhw_context_t ctx, void* memory, uint32_t size, uint32_t count)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		return ctx->gpu.set_frame_ring(memory, size, count) ? e_success : e_invalidparam;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_frame_ring_acquire(const gbhw_frame_ring_t* ring, const gbhw_frame_t** frame, const uint8_t** pixels, uint64_t* fence)
+	{
+		if(!ring || !frame || !pixels || !fence)
+			return e_invalidparam;
+
+		return FrameRing::acquire(ring, frame, pixels, fence) ? e_success : e_failed;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_frame_ring_validate(const gbhw_frame_t* frame, uint64_t fence)
+	{
+		if(!frame)
+			return e_invalidparam;
+
+		return FrameRing::validate(frame, fence) ? e_success : e_failed;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_read_memory(gbhw_context_t ctx, uint16_t address, uint8_t* buffer, uint32_t length)
+	{
+		if(!ctx || !buffer)
+			return e_invalidparam;
+
+		for(uint32_t i = 0; i < length; i++)
+			buffer[i] = ctx->mmu.peek_byte(static_cast<Address>(address + i));
+
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_add_breakpoint(gbhw_context_t ctx, uint16_t address, int32_t bank)
+	{
+		if(!ctx || (bank < -1))
+			return e_invalidparam;
+
+		ctx->breakpoints.add_breakpoint(address, bank);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_remove_breakpoint(gbhw_context_t ctx, uint16_t address, int32_t bank)
+	{
+		if(!ctx || (bank < -1))
+			return e_invalidparam;
+
+		ctx->breakpoints.remove_breakpoint(address, bank);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_add_watchpoint(gbhw_context_t ctx, uint16_t first, uint16_t last, gbhw_watch_type_t type, uint32_t* id)
+	{
+		if(!ctx || !id || (first > last) || (type < watch_read) || (type > watch_access))
+			return e_invalidparam;
+
+		*id = ctx->breakpoints.add_watchpoint(first, last, type);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_remove_watchpoint(gbhw_context_t ctx, uint32_t id)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		return ctx->breakpoints.remove_watchpoint(id) ? e_success : e_invalidparam;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_clear_breakpoints(gbhw_context_t ctx)
+	{
+		if(!ctx)
+			return e_invalidparam;
+
+		ctx->breakpoints.clear();
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_get_break(gbhw_context_t ctx, gbhw_break_t* info)
+	{
+		if(!ctx || !info)
+			return e_invalidparam;
+
+		*info = ctx->breakpoints.get_triggered();
+		return e_success;
+	}
+
 #ifdef EMSCRIPTEN
 
 	static void gbhw_log_callback_web(void* userdata, gbhw_log_level_t level, const char* msg)
@@ -255,51 +888,61 @@ extern "C"
 
 	HWPublicAPI gbhw_errorcode_t gbhw_disasm(gbhw_context_t ctx, gbhw::Address address, gbhw::InstructionList& instructions, int32_t instructionCount)
 	{
-		if(!ctx)
+		if(!ctx || instructionCount < 0)
 			return e_invalidparam;
 
-		MMU& mmu = ctx->mmu;
-		CPU& cpu = ctx->cpu;
-
-		const uint8_t* instructionAddress = mmu.get_memory_ptr_from_addr(address);
-		const uint8_t* baseInstruction = mmu.get_memory_ptr_from_addr(0);
-		int32_t instructionsProcessed = 0;
+		std::vector<DisasmLine> lines(instructionCount);
+		const uint32_t count = ctx->disassembly.get_lines(address, lines.data(), instructionCount);
 
-		while (true)
+		for(uint32_t i = 0; i < count; i++)
 		{
-			Byte opcode = *instructionAddress;
-			Instruction instruction;
+			const DisasmLine& line = lines[i];
+			const bool bExtended = (line.bytes[0] == 0xCB);
 
-			if (opcode == 0xCB)
-			{
-				Byte extended = *(instructionAddress + 1);
-				instruction = cpu.get_instruction(extended, true);
-			}
-			else
-			{
-				instruction = cpu.get_instruction(opcode, false);
-			}
+			Instruction instruction = ctx->cpu.get_instruction(bExtended ? line.bytes[1] : line.bytes[0], bExtended);
+			instruction.set(line.address);
+			instructions.push_back(instruction);
+		}
 
-			instruction.set(address);
+		return e_success;
+	}
 
-			const uint8_t* oldInstructionAddress = instructionAddress;
-			instructionAddress += instruction.byte_size();
-			address += instruction.byte_size();
+	HWPublicAPI gbhw_errorcode_t gbhw_disasm_lines(gbhw_context_t ctx, gbhw::Address address, gbhw::DisasmLine* lines, uint32_t count, uint32_t* written)
+	{
+		if(!ctx || (!lines && count))
+			return e_invalidparam;
 
-			if (instructionAddress == oldInstructionAddress)
-			{
-				instructionAddress++; // W\A - XX instructions should be parsed as 1 byte to prevent this.
-			}
+		const uint32_t res = ctx->disassembly.get_lines(address, lines, count);
 
-			instructions.push_back(instruction);
-			instructionsProcessed++;
+		if(written)
+			*written = res;
 
-			if (instructionsProcessed >= instructionCount)
-			{
-				break;
-			}
-		}
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_disasm_find(gbhw_context_t ctx, gbhw::Address address, gbhw::Address* start)
+	{
+		if(!ctx || !start)
+			return e_invalidparam;
+
+		*start = ctx->disassembly.find(address);
+		return e_success;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_load_symbols(gbhw_context_t ctx, const char* path)
+	{
+		if(!ctx || !path)
+			return e_invalidparam;
+
+		return ctx->disassembly.load_symbols(path) ? e_success : e_failed;
+	}
+
+	HWPublicAPI gbhw_errorcode_t gbhw_find_symbol(gbhw_context_t ctx, gbhw::Address address, const char** name)
+	{
+		if(!ctx || !name)
+			return e_invalidparam;
 
+		*name = ctx->disassembly.find_symbol(address);
 		return e_success;
 	}
 
@@ -28,6 +28,7 @@ namespace gbhw
 	{
 		// Set to white.
 		memset(entries, 0xFF, sizeof(GPUPaletteColour) * 8 * 4);
+		generation = 0;
 	}
 
 	//--------------------------------------------------------------------------
@@ -38,32 +39,100 @@ namespace gbhw
 		memset(tileData, 0, sizeof(GPUTile) * kTileDataBankCount * kTileDataCount);
 		memset(tileMap,  0, sizeof(Byte) * kTileMapCount * kTileMapSize);
 		memset(tileAttr, 0, sizeof(GPUAttributes) * kTileMapCount * kTileMapSize);
+
+		generation = 0;
+		memset(tileGeneration, 0, sizeof(tileGeneration));
+		memset(mapGeneration, 0, sizeof(mapGeneration));
 	}
 
 	//--------------------------------------------------------------------------
 
 	GPU::GPU()
-		: m_screenData(nullptr)
+		: m_cpu(nullptr)
+		, m_mmu(nullptr)
+		, m_perf(nullptr)
+		, m_screenData(nullptr)
+		, m_screenBuffer(nullptr)
+		, m_bRingFrame(false)
+		, m_bHeadless(false)
+		, m_bHeadlessFrame(false)
+		, m_bIndexed(false)
+		, m_indexData(nullptr)
 	{
 		m_mode				= Mode::ScanlineOAM;
 		m_modeCycles		= 0;
 		m_bVBlankNotify		= false;
 		m_scanLineSprites.reserve(10);
 		memset(m_scanLinePriority, 0, sizeof(bool) * kScreenWidth);
+		memset(m_framePalette, 0xFF, sizeof(m_framePalette));
+		memset(m_lineHash, 0, sizeof(m_lineHash));
+		memset(&m_dirty, 0, sizeof(m_dirty));
+		memset(&m_frameDirty, 0, sizeof(m_frameDirty));
 	}
 
 	GPU::~GPU()
 	{
-		if(m_screenData)
-			delete[] m_screenData;
+		if(m_screenBuffer)
+			delete[] m_screenBuffer;
+
+		if(m_indexData)
+			delete[] m_indexData;
 	}
 
-	void GPU::initialise(CPU* cpu, MMU* mmu)
+	void GPU::initialise(CPU* cpu, MMU* mmu, PerfCounters* perf)
 	{
 		m_cpu = cpu;
 		m_mmu = mmu;
+		m_perf = perf;
 
-		m_screenData = new GPUPixel[kScreenWidth * kScreenHeight];
+		m_screenBuffer = new GPUPixel[kScreenWidth * kScreenHeight];
+		m_screenData = m_screenBuffer;
+
+		m_indexData = new Byte[kScreenWidth * kScreenHeight];
+		memset(m_indexData, 0, kScreenWidth * kScreenHeight);
+	}
+
+	void GPU::copy_state(const GPU& source)
+	{
+		m_mode				= source.m_mode;
+		m_modeCycles		= source.m_modeCycles;
+		m_bVBlankNotify		= source.m_bVBlankNotify;
+		m_lcdc				= source.m_lcdc;
+		m_currentScanLine	= source.m_currentScanLine;
+		m_windowPosY		= source.m_windowPosY;
+		m_windowReadY		= source.m_windowReadY;
+
+		// Generations only move forward, a viewer that drew this GPU's tiles
+		// must see every copied tile and colour as changed.
+		const uint32_t generation = std::max(m_tileRam.generation, source.m_tileRam.generation) + 1;
+
+		m_tileRam				= source.m_tileRam;
+		m_tileRam.generation	= generation;
+		std::fill(&m_tileRam.tileGeneration[0][0], &m_tileRam.tileGeneration[0][0] + (GPUTileRam::kTileDataBankCount * GPUTileRam::kTileDataCount), generation);
+		std::fill(&m_tileRam.mapGeneration[0][0], &m_tileRam.mapGeneration[0][0] + (GPUTileRam::kTileMapCount * GPUTileRam::kTileMapSize), generation);
+
+		memcpy(m_spriteData, source.m_spriteData, sizeof(m_spriteData));
+
+		for(uint32_t i = 0; i < GPUPalette::Count; i++)
+		{
+			const uint32_t paletteGeneration = std::max(m_palette[i].generation, source.m_palette[i].generation) + 1;
+
+			m_palette[i]			= source.m_palette[i];
+			m_palette[i].generation	= paletteGeneration;
+		}
+	}
+
+	void GPU::copy_screen(const GPU& source)
+	{
+		m_bIndexed			= source.m_bIndexed;
+		m_dirty				= source.m_dirty;
+		m_frameDirty		= source.m_frameDirty;
+
+		// The frame in progress continues in this GPU's own buffer.
+		memcpy(m_screenBuffer, source.m_screenData, sizeof(GPUPixel) * kScreenWidth * kScreenHeight);
+		memcpy(m_indexData, source.m_indexData, kScreenWidth * kScreenHeight);
+		memcpy(m_framePalette, source.m_framePalette, sizeof(m_framePalette));
+		memcpy(m_lineHash, source.m_lineHash, sizeof(m_lineHash));
 	}
 
 	void GPU::update(uint32_t cycles)
@@ -145,6 +214,8 @@ namespace gbhw
 						scan_line(ly);
 						m_modeCycles -= kScanlineReadOAMCycles;
 						m_mode = Mode::HBlank;
+
+						m_mmu->update_hblank();
 					}
 					break;
 				}
@@ -161,15 +232,13 @@ namespace gbhw
 						{
 							// ly = 144 -> 153 indicates v-blank period.
 							m_mode = Mode::VBlank;
-							m_bVBlankNotify = true;
+							end_frame();
 						}
 						else
 						{
 							// Start new scanline.
 							m_mode = Mode::ScanlineOAM;
 						}
-
-						// @todo: HBlank DMA for GBC?
 					}
 					break;
 				}
@@ -198,6 +267,31 @@ namespace gbhw
 		m_mmu->write_io(HWRegs::Stat, stat);
 	}
 
+	uint32_t GPU::get_cycles_to_event() const
+	{
+		if((m_mmu->read_io(HWRegs::LCDC) & 0x80) == 0)
+			return kFrameCycles;
+
+		const Byte statMode = m_mmu->read_io(HWRegs::Stat) & HWLCDCStatus::ModeMask;
+		HWLCDCStatus::Type mode;
+		uint32_t modeEnd;
+
+		// Thresholds match the comparisons in update, HBlank ends after rather
+		// than on its cycle count.
+		switch(m_mode)
+		{
+			case Mode::ScanlineOAM:		mode = HWLCDCStatus::ModeOAM;		modeEnd = kScanlineReadOAMCycles;	break;
+			case Mode::ScanlineVRAM:	mode = HWLCDCStatus::ModeOAMVRam;	modeEnd = kScanlineReadVRAMCycles;	break;
+			case Mode::HBlank:			mode = HWLCDCStatus::ModeHBlank;	modeEnd = kHBlankCycles + 1;		break;
+			default:					mode = HWLCDCStatus::ModeVBlank;	modeEnd = kHBlankCycles;			break;
+		}
+
+		if((statMode != mode) || (m_modeCycles >= modeEnd))
+			return 0;
+
+		return modeEnd - m_modeCycles;
+	}
+
 	void GPU::set_lcdc(Byte val)
 	{
 		// Display is toggled, reset scanline.
@@ -220,6 +314,47 @@ namespace gbhw
 		return reinterpret_cast<const Byte*>(m_screenData);
 	}
 
+	void GPU::set_indexed(bool bIndexed)
+	{
+		if(bIndexed && !m_bIndexed)
+			capture_frame_palette();
+
+		m_bIndexed = bIndexed;
+	}
+
+	void GPU::capture_frame_palette()
+	{
+		for(uint32_t type = 0; type < GPUPalette::Count; type++)
+		{
+			for(uint32_t palette = 0; palette < 8; palette++)
+			{
+				for(uint32_t colour = 0; colour < 4; colour++)
+				{
+					const uint32_t index = (type == GPUPalette::Sprite ? IndexedPixel::Sprite : 0) | (palette << IndexedPixel::PaletteShift) | colour;
+					memcpy(&m_framePalette[index], &m_palette[type].entries[palette][colour].pixel, sizeof(uint32_t));
+				}
+			}
+		}
+	}
+
+	bool GPU::set_frame_ring(void* memory, uint32_t size, uint32_t count)
+	{
+		// Keep showing the last frame until the next one starts.
+		if(m_screenData != m_screenBuffer)
+			memcpy(m_screenBuffer, m_screenData, sizeof(GPUPixel) * kScreenWidth * kScreenHeight);
+
+		m_screenData = m_screenBuffer;
+		m_bRingFrame = false;
+
+		if(!memory)
+		{
+			m_frameRing.detach();
+			return true;
+		}
+
+		return m_frameRing.attach(memory, size, count, kScreenWidth, kScreenHeight);
+	}
+
 	void GPU::set_tile_ram_data(Address vramAddress, Byte data)
 	{
 		if(vramAddress < 0x9800)
@@ -236,15 +371,22 @@ namespace gbhw
 
 			// @todo: Investigate if this needs optimising.
 			Byte* tileCol = &m_tileRam.tileData[m_tileRam.bank][tileIndex].pixels[tileRow][7];
+			bool bChanged = false;
 
 			for(uint32_t i = 0; i < 8; ++i)
 			{
 				// Bits are reversed.
-				*tileCol = (*tileCol & ~(tileBit + 1)) | ((data & 0x1) << tileBit);
+				const Byte pixel = (*tileCol & ~(tileBit + 1)) | ((data & 0x1) << tileBit);
+				bChanged |= (pixel != *tileCol);
+
+				*tileCol = pixel;
 				data >>= 1;
 
 				tileCol--;
 			}
+
+			if(bChanged)
+				m_tileRam.tileGeneration[m_tileRam.bank][tileIndex] = ++m_tileRam.generation;
 		}
 		else
 		{
@@ -259,13 +401,43 @@ namespace gbhw
 
 			if(m_tileRam.bank == 0)
 			{
+				if(m_tileRam.tileMap[tilemapIndex][tileIndex] == data)
+					return;
+
 				m_tileRam.tileMap[tilemapIndex][tileIndex] = data;
 			}
 			else
 			{
 				GPUAttributes attr(data);
+
+				if(m_tileRam.tileAttr[tilemapIndex][tileIndex] == attr)
+					return;
+
 				m_tileRam.tileAttr[tilemapIndex][tileIndex] = attr;
 			}
+
+			m_tileRam.mapGeneration[tilemapIndex][tileIndex] = ++m_tileRam.generation;
+		}
+	}
+
+	void GPU::set_tile_ram_data(Address vramAddress, const Byte* data, uint32_t size)
+	{
+		const uint32_t end = vramAddress + size;
+
+		while(vramAddress < end)
+		{
+			// Both bit planes of a row at once where possible, DMA blocks are
+			// always row aligned.
+			if((vramAddress < 0x9800) && ((vramAddress & 1) == 0) && ((vramAddress + 1u) < end))
+			{
+				set_tile_row(vramAddress, data[0], data[1]);
+				vramAddress += 2;
+				data += 2;
+			}
+			else
+			{
+				set_tile_ram_data(vramAddress++, *data++);
+			}
 		}
 	}
 
@@ -297,6 +469,19 @@ namespace gbhw
 		}
 	}
 
+	void GPU::set_sprite_table(const Byte* data)
+	{
+		for(uint32_t spriteIndex = 0; spriteIndex < 40; ++spriteIndex, data += 4)
+		{
+			GPUSpriteData* sprite = &m_spriteData[spriteIndex];
+
+			sprite->y		= data[0];
+			sprite->x		= data[1];
+			sprite->tile	= data[2];
+			sprite->attr	= GPUAttributes(data[3]);
+		}
+	}
+
 	void GPU::set_palette(GPUPalette::Type type, Byte index, Byte value)
 	{
 		const Byte entryIndex	= index >> 3;		// 8-bytes per entry.
@@ -305,7 +490,12 @@ namespace gbhw
 
 		// @todo: Do we need to store the values.
 		GPUPaletteColour& entry = m_palette[type].entries[entryIndex][colourIndex];
+
+		if(entry.values[byteIndex] == value)
+			return;
+
 		entry.values[byteIndex] = value;
+		m_palette[type].generation++;
 
 		// Construct pixel colour.
 		GPUPixel& pixel = entry.pixel;
@@ -340,6 +530,26 @@ namespace gbhw
 		return stat;
 	}
 
+	void GPU::end_frame()
+	{
+		m_bVBlankNotify = true;
+
+		m_dirty.frame++;
+		m_frameDirty = m_dirty;
+		m_dirty.count = 0;
+		memset(m_dirty.lines, 0, sizeof(m_dirty.lines));
+
+		// Nothing was drawn, the screen and palette still hold the last frame.
+		if(m_bHeadlessFrame)
+			return;
+
+		if(m_bRingFrame)
+			m_frameRing.end_frame(m_frameDirty);
+
+		if(m_bIndexed)
+			capture_frame_palette();
+	}
+
 	void GPU::scan_line(Byte line)
 	{
 		if (line >= kScreenHeight)
@@ -354,10 +564,29 @@ namespace gbhw
 		{
 			m_windowPosY = m_mmu->read_io(HWRegs::WindowY);	// Is this true?
 			m_windowReadY = 0;	// Reset this. Window drawing will resume drawing from where it last read when disabled between h-blanks.
+			m_bHeadlessFrame = m_bHeadless;
+
+			// Indexed frames never touch the 32-bit screen, a slot would be
+			// published holding a frame from a previous lap.
+			m_bRingFrame = m_frameRing.is_attached() && !m_bHeadlessFrame && !m_bIndexed;
+
+			if(m_bRingFrame)
+				m_screenData = reinterpret_cast<GPUPixel*>(m_frameRing.begin_frame());
+		}
+
+		// The window's line counter is the only drawing state later lines use.
+		if (m_bHeadlessFrame)
+		{
+			if (HWLCDC::window_enabled(m_lcdc) && is_window_on_line())
+				m_windowReadY++;
+
+			return;
 		}
 
 		memset(m_scanLinePriority, 0, sizeof(bool) * kScreenWidth);
 
+		m_perf->scanlines++;
+
 		if (HWLCDC::bg_enabled(m_lcdc))
 		{
 			scan_line_bg();
@@ -372,6 +601,62 @@ namespace gbhw
 		{
 			scan_line_sprite();
 		}
+
+		update_line_dirty();
+	}
+
+	void GPU::update_line_dirty()
+	{
+		const Byte* data	= m_bIndexed ? &m_indexData[m_currentScanLine * kScreenWidth] : reinterpret_cast<const Byte*>(&m_screenData[m_currentScanLine * kScreenWidth]);
+		const uint32_t size	= m_bIndexed ? kScreenWidth : kScreenWidth * sizeof(GPUPixel);
+
+		// Four independent lanes keep the multiplies from serialising, lines
+		// are always a multiple of 32 bytes.
+		uint64_t lanes[4] = { 0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x27D4EB2F165667C5ull };
+
+		for(uint32_t offset = 0; offset < size; offset += 32)
+		{
+			for(uint32_t lane = 0; lane < 4; lane++)
+			{
+				uint64_t word;
+				memcpy(&word, data + offset + (lane * 8), sizeof(word));
+				lanes[lane] = (lanes[lane] ^ word) * 0x100000001B3ull;
+			}
+		}
+
+		uint64_t hash = (lanes[0] ^ (lanes[1] >> 7)) + ((lanes[2] << 3) ^ (lanes[3] >> 11)) + m_bIndexed;
+		hash ^= hash >> 29;
+
+		if(hash != m_lineHash[m_currentScanLine])
+		{
+			m_lineHash[m_currentScanLine] = hash;
+			m_dirty.lines[m_currentScanLine >> 5] |= 1u << (m_currentScanLine & 31);
+			m_dirty.count++;
+		}
+	}
+
+	void GPU::set_tile_row(Address vramAddress, Byte low, Byte high)
+	{
+		// Offset into 0->0x17FF range.
+		vramAddress -= 0x8000;
+
+		const uint32_t	tileIndex	= vramAddress >> 4;
+		const uint32_t	tileRow		= (vramAddress % 16) >> 1;
+		Byte*			pixels		= m_tileRam.tileData[m_tileRam.bank][tileIndex].pixels[tileRow];
+		bool			bChanged	= false;
+
+		for(uint32_t i = 0; i < 8; ++i)
+		{
+			// Bits are reversed.
+			const Byte bit		= 7 - i;
+			const Byte pixel	= ((low >> bit) & 0x1) | (((high >> bit) & 0x1) << 1);
+
+			bChanged |= (pixel != pixels[i]);
+			pixels[i] = pixel;
+		}
+
+		if(bChanged)
+			m_tileRam.tileGeneration[m_tileRam.bank][tileIndex] = ++m_tileRam.generation;
 	}
 
 	void GPU::scan_line_bg()
@@ -397,6 +682,7 @@ namespace gbhw
 		m_tileRam.get_tilemap_row(tileMapIndex, tileMapY, &mapRow, &attrRow);
 
 		GPUPaletteColour* colours = m_palette[GPUPalette::BG].entries[attrRow[tileMapX].palette];
+		Byte paletteBits = attrRow[tileMapX].palette << IndexedPixel::PaletteShift;
 		Byte tileIndex = mapRow[tileMapX];
 
 		if(tileDataIndex == 0)
@@ -414,7 +700,7 @@ namespace gbhw
 
 		for (uint32_t screenX = 0; screenX < kScreenWidth; ++screenX)
 		{
-			m_screenData[lineOffset + screenX] = colours[tileRow[tileX]].pixel;
+			write_pixel(lineOffset + screenX, colours, paletteBits, tileRow[tileX]);
 			m_scanLinePriority[screenX] = priority;
 
 			if ((flipH && (tileX == 0)) || (!flipH && (tileX == 7)))
@@ -434,6 +720,7 @@ namespace gbhw
 
 				tileRow = m_tileRam.get_tiledata_row(attrRow[tileMapX].bank, tileIndex + tileOffset, tileL);
 				colours = m_palette[GPUPalette::BG].entries[attrRow[tileMapX].palette];
+				paletteBits = attrRow[tileMapX].palette << IndexedPixel::PaletteShift;
 			}
 			else
 			{
@@ -449,7 +736,7 @@ namespace gbhw
 		Byte windowX = static_cast<SWord>(m_mmu->read_io(HWRegs::WindowX));
 
 		// Start drawing when window is visible, and scanline is on or past vertical position.
-		if (windowX > 166 || m_currentScanLine < m_windowPosY)
+		if (!is_window_on_line())
 			return;
 
 		// Offset accordingly.
@@ -475,6 +762,7 @@ namespace gbhw
 		m_tileRam.get_tilemap_row(tileMapIndex, tileMapY, &mapRow, &attrRow);
 
 		GPUPaletteColour* colours = m_palette[GPUPalette::BG].entries[attrRow[tileMapX].palette];
+		Byte paletteBits = attrRow[tileMapX].palette << IndexedPixel::PaletteShift;
 		Byte tileIndex = mapRow[tileMapX];
 
 		if(tileDataIndex == 0)
@@ -484,7 +772,7 @@ namespace gbhw
 
 		for (Byte screenX = windowX; screenX < kScreenWidth; ++screenX)
 		{
-			m_screenData[lineOffset + screenX] = colours[tileRow[tileX]].pixel;
+			write_pixel(lineOffset + screenX, colours, paletteBits, tileRow[tileX]);
 
 			if (tileX++ == 7)
 			{
@@ -499,10 +787,16 @@ namespace gbhw
 
 				tileRow = m_tileRam.get_tiledata_row(attrRow[tileMapX].bank, tileIndex + tileOffset, tileY);
 				colours = m_palette[GPUPalette::BG].entries[attrRow[tileMapX].palette];
+				paletteBits = attrRow[tileMapX].palette << IndexedPixel::PaletteShift;
 			}
 		}
 	}
 
+	bool GPU::is_window_on_line() const
+	{
+		return (m_mmu->read_io(HWRegs::WindowX) <= 166) && (m_currentScanLine >= m_windowPosY);
+	}
+
 	void GPU::scan_line_sprite()
 	{
 		// Calculate sprites visible on scanline.
@@ -530,6 +824,8 @@ namespace gbhw
 				break;
 		}
 
+		m_perf->sprites_per_line[m_scanLineSprites.size()]++;
+
 		// GBC prioritises lower indexed sprites. Draw back to front
 		// (alternatively priority bit could be set during drawing).
 		std::sort(m_scanLineSprites.rbegin(), m_scanLineSprites.rend());
@@ -555,14 +851,15 @@ namespace gbhw
 			const Byte tileOffset		= (bDouble && (tileYIndex > 7)) ? 1 : 0;
 
 			GPUPaletteColour* colours = m_palette[GPUPalette::Sprite].entries[palette];
+			const Byte paletteBits = IndexedPixel::Sprite | (palette << IndexedPixel::PaletteShift);
 
 			const Byte* tileRow = m_tileRam.get_tiledata_row(bank, tileIndex + tileOffset, tileYIndex & 0x7);
 
 			Byte tileXIndex;
 			Byte tileX = (spriteX < 0) ? (-spriteX) : 0;
 
-			// Read the line data
-			for (; tileX < 8; tileX++)
+			// Read the line data, clipping sprites hanging off the right edge.
+			for (; (tileX < 8) && ((spriteX + tileX) < static_cast<int16_t>(kScreenWidth)); tileX++)
 			{
 				if (bFlipX)
 				{
@@ -574,10 +871,10 @@ namespace gbhw
 				}
 
 				// Colour 0 is always transparent for sprites.
-				const Byte paletteIndex = tileRow[tileXIndex];
-				if (paletteIndex && !m_scanLinePriority[spriteX + tileX])
+				const Byte colour = tileRow[tileXIndex];
+				if (colour && !m_scanLinePriority[spriteX + tileX])
 				{
-					m_screenData[lineOffset + spriteX + tileX] = colours[paletteIndex].pixel;
+					write_pixel(lineOffset + spriteX + tileX, colours, paletteBits, colour);
 				}
 			}
 		}
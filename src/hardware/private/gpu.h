@@ -1,5 +1,8 @@
 #pragma once
 
+#include "frame_ring.h"
+#include "framebuffer.h"
+#include "perf.h"
 #include "types.h"
 
 namespace gbhw
@@ -35,6 +38,11 @@ namespace gbhw
 			priority	= static_cast<bool>((data >> 7) & 0x01);
 		}
 
+		inline bool operator==(const GPUAttributes& other) const
+		{
+			return (palette == other.palette) && (bank == other.bank) && (hFlip == other.hFlip) && (vFlip == other.vFlip) && (priority == other.priority);
+		}
+
 		Byte palette;
 		Byte bank;
 		bool hFlip;
@@ -73,7 +81,8 @@ namespace gbhw
 			Count
 		};
 
-		GPUPaletteColour entries[8][4];
+		GPUPaletteColour	entries[8][4];
+		uint32_t			generation;		// Bumped whenever a colour changes.
 	};
 
 	//--------------------------------------------------------------------------
@@ -110,6 +119,14 @@ namespace gbhw
 		GPUTile			tileData[kTileDataBankCount][kTileDataCount];		// Banked for read & write.
 		Byte			tileMap[kTileMapCount][kTileMapSize];				// Only written when bank = 0
 		GPUAttributes	tileAttr[kTileMapCount][kTileMapSize];				// Only written when bank = 1. Should only be used for GBC rom.
+
+		// Change tracking for viewers. generation is bumped by every write that
+		// changes tile ram, and each tile and map entry records the generation
+		// it last changed in. Anything newer than the generation a viewer last
+		// drew needs drawing again.
+		uint32_t		generation;
+		uint32_t		tileGeneration[kTileDataBankCount][kTileDataCount];
+		uint32_t		mapGeneration[kTileMapCount][kTileMapSize];		// Index or attributes.
 	};
 
 	//--------------------------------------------------------------------------
@@ -120,20 +137,46 @@ namespace gbhw
 		GPU();
 		~GPU();
 
-		void initialise(CPU* cpu, MMU* mmu);
+		void initialise(CPU* cpu, MMU* mmu, PerfCounters* perf);
+		// Forking takes on both, save states only the emulation state and keep
+		// showing their own screen. The frame ring stays where it is.
+		void copy_state(const GPU& source);
+		void copy_screen(const GPU& source);
 		void update(uint32_t cycles);
 
+		// Cycles until the next mode change, which is the only time the GPU
+		// raises interrupts. 0 when the current mode has yet to be applied.
+		uint32_t get_cycles_to_event() const;
+
 		void set_lcdc(Byte val);
 		bool reset_vblank_notify();
 		const Byte* get_screen_data() const;
+		inline const gbhw_screen_dirty_t& get_screen_dirty() const;
+
+		// Indexed output, see IndexedPixel. Replaces RGB output while enabled,
+		// the palette is captured as each frame completes.
+		void set_indexed(bool bIndexed);
+		inline bool is_indexed() const;
+		inline const Byte* get_indexed_data() const;
+		inline const uint32_t* get_frame_palette() const;
+
+		// Frame ring, rendering switches over at the start of the next frame.
+		bool set_frame_ring(void* memory, uint32_t size, uint32_t count);
+
+		// Headless frames are emulated without drawing, the screen keeps the
+		// last frame drawn. Switches over at the start of the next frame.
+		inline void set_headless(bool bHeadless);
+		inline bool is_headless_frame() const;
 
 		// Tile Ram
 		void set_tile_ram_data(Address vramAddress, Byte data);
+		void set_tile_ram_data(Address vramAddress, const Byte* data, uint32_t size);	// Block copied into VRAM.
 		void set_tile_ram_bank(Byte bank);
 		inline const GPUTileRam* get_tile_ram() const;
 
 		// Sprite
 		void set_sprite_data(const Address spriteAddress, Byte value);
+		void set_sprite_table(const Byte* data);		// Whole of OAM, after DMA.
 
 		// Palette
 		void set_palette(GPUPalette::Type type, Byte index, Byte value);
@@ -141,14 +184,21 @@ namespace gbhw
 
 		static const uint32_t kScreenWidth	= 160;
 		static const uint32_t kScreenHeight	= 144;
+		static const uint32_t kFrameCycles	= 70224;	// 154 lines of 456 cycles.
 
 	private:
 		Byte update_lcdc_status_mode(Byte stat, HWLCDCStatus::Type mode, HWLCDCStatus::Type interrupt);
 
+		void end_frame();
 		void scan_line(Byte line);
 		void scan_line_bg();
 		void scan_line_window();
 		void scan_line_sprite();
+		bool is_window_on_line() const;
+		inline void write_pixel(uint32_t offset, const GPUPaletteColour* colours, Byte paletteBits, Byte colour);
+		void capture_frame_palette();
+		void update_line_dirty();
+		void set_tile_row(Address vramAddress, Byte low, Byte high);
 
 		struct Mode
 		{
@@ -163,6 +213,7 @@ namespace gbhw
 
 		CPU*					m_cpu;
 		MMU*					m_mmu;
+		PerfCounters*			m_perf;
 		Mode::Enum				m_mode;
 		uint32_t				m_modeCycles;
 		bool					m_bVBlankNotify;
@@ -170,7 +221,18 @@ namespace gbhw
 		Byte					m_currentScanLine;
 		Byte					m_windowPosY;
 		Byte					m_windowReadY;
-		GPUPixel*				m_screenData;
+		GPUPixel*				m_screenData;		// Frame being rendered, either m_screenBuffer or a ring slot.
+		GPUPixel*				m_screenBuffer;
+		FrameRing				m_frameRing;
+		bool					m_bRingFrame;					// The frame being emulated is drawn into a ring slot.
+		bool					m_bHeadless;
+		bool					m_bHeadlessFrame;				// m_bHeadless as the frame being emulated started.
+		bool					m_bIndexed;
+		Byte*					m_indexData;
+		uint32_t				m_framePalette[IndexedPixel::Count];
+		uint64_t				m_lineHash[kScreenHeight];		// Hash of each line as last rendered.
+		gbhw_screen_dirty_t		m_dirty;						// Lines changed in the frame being rendered.
+		gbhw_screen_dirty_t		m_frameDirty;					// Lines changed in the last completed frame.
 		GPUTileRam				m_tileRam;
 		std::vector<Byte>		m_scanLineSprites;
 		bool					m_scanLinePriority[kScreenWidth];
@@ -180,6 +242,16 @@ namespace gbhw
 
 	//--------------------------------------------------------------------------
 
+	inline void GPU::set_headless(bool bHeadless)
+	{
+		m_bHeadless = bHeadless;
+	}
+
+	inline bool GPU::is_headless_frame() const
+	{
+		return m_bHeadlessFrame;
+	}
+
 	inline const GPUTileRam* GPU::get_tile_ram() const
 	{
 		return &m_tileRam;
@@ -190,5 +262,34 @@ namespace gbhw
 		return &m_palette[type];
 	}
 
+	inline const gbhw_screen_dirty_t& GPU::get_screen_dirty() const
+	{
+		return m_frameDirty;
+	}
+
+	inline bool GPU::is_indexed() const
+	{
+		return m_bIndexed;
+	}
+
+	inline const Byte* GPU::get_indexed_data() const
+	{
+		return m_indexData;
+	}
+
+	inline const uint32_t* GPU::get_frame_palette() const
+	{
+		return m_framePalette;
+	}
+
+	inline void GPU::write_pixel(uint32_t offset, const GPUPaletteColour* colours, Byte paletteBits, Byte colour)
+	{
+		// paletteBits are the IndexedPixel palette and sprite bits.
+		if(m_bIndexed)
+			m_indexData[offset] = paletteBits | colour;
+		else
+			m_screenData[offset] = colours[colour].pixel;
+	}
+
 	//--------------------------------------------------------------------------
 }
\ No newline at end of file
@@ -27,5 +27,11 @@ namespace gbhw
 		return log;
 	}
 
+	char* Log::get_buffer(uint32_t index)
+	{
+		thread_local char buffers[2][kMaxFormattedLength];
+		return buffers[index];
+	}
+
 	//--------------------------------------------------------------------------
 }
\ No newline at end of file
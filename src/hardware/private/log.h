@@ -22,7 +22,11 @@ namespace gbhw
 
 	private:
 		static const uint32_t	kMaxFormattedLength = 4096;
-		char					m_buffer[2][kMaxFormattedLength];
+
+		// Contexts may log from several threads at once, each thread formats
+		// into its own buffers.
+		static char* get_buffer(uint32_t index);
+
 		gbhw_log_level_t		m_level;
 
 		struct
@@ -48,15 +52,18 @@ namespace gbhw
 		if(level < m_level)
 			return;
 
+		char* message	= get_buffer(0);
+		char* line		= get_buffer(1);
+
 #ifdef MSVC
-		sprintf_s(m_buffer[0], format, parameters...);
-		sprintf_s(m_buffer[1], "%s | %s", type, m_buffer[0]);
+		sprintf_s(message, kMaxFormattedLength, format, parameters...);
+		sprintf_s(line, kMaxFormattedLength, "%s | %s", type, message);
 #else
-		sprintf(m_buffer[0], format, parameters...);
-		sprintf(m_buffer[1], "%s | %s", type, m_buffer[0]);
+		sprintf(message, format, parameters...);
+		sprintf(line, "%s | %s", type, message);
 #endif
 
-		m_callback.trigger(level, m_buffer[1]);
+		m_callback.trigger(level, line);
 	}
 
 	template<typename... Args>
@@ -38,6 +38,11 @@ namespace gbhw
 		return false;
 	}
 
+	MBC* MBC::clone(MMU* mmu) const
+	{
+		return new MBC(mmu);
+	}
+
 	//--------------------------------------------------------------------------
 	// MBC1
 	//--------------------------------------------------------------------------
@@ -114,6 +119,13 @@ namespace gbhw
 			return false;
 		}
 
+		MBC* clone(MMU* mmu) const
+		{
+			MBC1* mbc = new MBC1(*this);
+			mbc->m_mmu = mmu;
+			return mbc;
+		}
+
 	private:
 		bool m_bMode0;
 		Byte m_romBank;
@@ -175,6 +187,13 @@ namespace gbhw
 
 			return false;
 		}
+
+		MBC* clone(MMU* mmu) const
+		{
+			MBC3* mbc = new MBC3(*this);
+			mbc->m_mmu = mmu;
+			return mbc;
+		}
 	};
 
 	// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -203,7 +222,8 @@ namespace gbhw
 				}
 				else if(range_check(address, 0x3000))
 				{
-					m_romBankHigh = value;
+					// Only bit 0 is connected, 9-bit bank number.
+					m_romBankHigh = value & 0x01;
 					load_rom_bank();
 				}
 				else if(range_check(address, 0x2000))
@@ -224,6 +244,13 @@ namespace gbhw
 			return false;
 		}
 
+		MBC* clone(MMU* mmu) const
+		{
+			MBC5* mbc = new MBC5(*this);
+			mbc->m_mmu = mmu;
+			return mbc;
+		}
+
 	private:
 		void load_rom_bank()
 		{
@@ -288,11 +315,13 @@ namespace gbhw
 			case CartridgeType::HudsonHuC1:
 			default:
 			{
-				log_error("Unsupported MBC\n");
 				break;
 			}
 		}
 
-		return nullptr;
+		// Fall back to plain ROM so the MMU always has a controller to talk to,
+		// the game will likely misbehave but the emulator won't.
+		log_error("Unsupported MBC, treating cartridge as ROM only\n");
+		return new MBC(mmu);
 	}
 }
\ No newline at end of file
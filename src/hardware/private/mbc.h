@@ -15,6 +15,9 @@ namespace gbhw
 		virtual ~MBC();
 		virtual bool write(const Address& address, Byte value);
 
+		// Copy of the controller's state acting on another MMU.
+		virtual MBC* clone(MMU* mmu) const;
+
 		static MBC* create(MMU* mmu, CartridgeType::Type cartridge);
 
 	protected:
@@ -4,6 +4,9 @@
 #include "log.h"
 #include "mbc.h"
 #include "rom.h"
+#include "serial.h"
+#include "timer.h"
+#include <atomic>
 
 namespace gbhw
 {
@@ -44,9 +47,19 @@ namespace gbhw
 		: m_gpu(nullptr)
 		, m_cpu(nullptr)
 		, m_rom(nullptr)
+		, m_timer(nullptr)
+		, m_serial(nullptr)
+		, m_perf(nullptr)
+		, m_breakpoints(nullptr)
+		, m_disassembly(nullptr)
 		, m_regionsLUT { nullptr }
 		, m_mbc(nullptr)
+		, m_romBank(1)
+		, m_pendingInterrupts(0)
 	{
+		// Behave as a cartridge without a controller until a ROM is loaded.
+		m_mbc = new MBC(this);
+
 		// @todo: Initialise all memory with "random" data.
 		initialise_region(RegionType::RomBank0,			0x0000, 16384, true, true);
 		initialise_region(RegionType::RomBank1,			0x4000, 16384, true, true);
@@ -81,11 +94,60 @@ namespace gbhw
 		}
 	}
 
-	void MMU::initialise(CPU* cpu, GPU* gpu, Rom* rom)
+	void MMU::initialise(CPU* cpu, GPU* gpu, Rom* rom, Timer* timer, Serial* serial, PerfCounters* perf, Breakpoints* breakpoints, Disassembly* disassembly)
 	{
 		m_cpu = cpu;
 		m_gpu = gpu;
 		m_rom = rom;
+		m_timer = timer;
+		m_serial = serial;
+		m_perf = perf;
+		m_breakpoints = breakpoints;
+		m_disassembly = disassembly;
+	}
+
+	void MMU::fork(MMU& parent)
+	{
+		memcpy(m_memory, parent.m_memory, kMemorySize);
+
+		// Both sides share every RAM bank until one of them writes to it.
+		for(MemoryBanks* banks : { &parent.m_vramBanks, &parent.m_wramBanks, &parent.m_eramBanks })
+		{
+			for(MemoryBank& bank : *banks)
+				bank.m_bShared = true;
+		}
+
+		m_vramBanks = parent.m_vramBanks;
+		m_wramBanks = parent.m_wramBanks;
+		m_eramBanks = parent.m_eramBanks;
+
+		// Regions keep their own LUT entries, only what they map is taken on.
+		// Fixed regions point into the flat memory, ROM regions into the ROM.
+		for(uint32_t i = 0; i < RegionType::Count; i++)
+		{
+			const Region& source = parent.m_regions[i];
+			Region& region = m_regions[i];
+
+			region.m_bEnabled	= source.m_bEnabled;
+			region.m_bank		= get_forked_bank(parent, source.m_bank);
+
+			if(region.m_bank)
+				region.m_memory = region.m_bank->m_memory;
+			else if((source.m_memory >= parent.m_memory) && (source.m_memory < (parent.m_memory + kMemorySize)))
+				region.m_memory = m_memory + (source.m_memory - parent.m_memory);
+			else
+				region.m_memory = source.m_memory;
+		}
+
+		delete m_mbc;
+		m_mbc = parent.m_mbc->clone(this);
+
+		m_dma				= parent.m_dma;
+		m_romBank			= parent.m_romBank;
+		m_pendingInterrupts	= parent.m_pendingInterrupts;
+		m_buttonColumn		= parent.m_buttonColumn;
+		m_buttonsDirection	= parent.m_buttonsDirection;
+		m_buttonsFace		= parent.m_buttonsFace;
 	}
 
 	void MMU::reset(CartridgeType::Type cartridgeType)
@@ -103,34 +165,22 @@ namespace gbhw
 		load_rom_bank(1);
 	}
 
-	void MMU::update(uint16_t cycles)
+	bool MMU::is_colour() const
 	{
-		if(m_dma.active && !m_dma.gdma)
-		{
-			m_dma.hdma_cycles += cycles;
-
-			while(m_dma.hdma_cycles >= 4)
-			{
-				write_byte(m_dma.dest.addr++, read_byte(m_dma.source.addr++));
-
-				m_dma.hdma_cycles -= 4;
-			}
-
-			if((m_dma.dest.addr & 0xF) == 0)
-			{
-				// Finished DMA.
-				if(--m_dma.length == 0)
-				{
-					m_dma.active = false;
-					m_dma.gdma = true;
-				}
-			}
-		}
+		return m_rom && (m_rom->get_hardware_type() == HardwareType::GameboyColour);
 	}
 
 	Byte MMU::read_byte(Address address) const
 	{
-		// @todo Check for out of bounds behaviour
+		const Byte value = peek_byte(address);
+		m_breakpoints->check_read(address, value);
+		return value;
+	}
+
+	Byte MMU::peek_byte(Address address) const
+	{
+		// The LUT spans the whole 16-bit address space and every region is backed
+		// by at least m_size bytes, so any address resolves to valid memory.
 		const uint32_t	lutindex	= (address >> kLutShiftGranularity);
 		const Region*	region		= m_regionsLUT[lutindex];
 		const Address	regionAddr	= address - region->m_baseAddress;
@@ -169,11 +219,20 @@ namespace gbhw
 				{
 					case HWRegs::HDMA5:
 					{
+						// 0xFF once finished, bit 7 set with the remaining length if stopped.
 						if(!m_dma.active)
-							return 0xFF;
+							return region->m_memory[regionAddr];
 
 						return (m_dma.length & 0x7F);
 					}
+					case HWRegs::DIV:
+					{
+						return m_timer->get_div();
+					}
+					case HWRegs::TIMA:
+					{
+						return m_timer->get_tima();
+					}
 					default:
 					{
 						break;
@@ -196,18 +255,24 @@ namespace gbhw
 		return (read_byte(address) + (static_cast<Word>(read_byte(address + 1)) << 8));
 	}
 
+	Word MMU::peek_word(Address address) const
+	{
+		return (peek_byte(address) + (static_cast<Word>(peek_byte(address + 1)) << 8));
+	}
+
 	Byte MMU::read_io(HWRegs::Type reg)
 	{
-		return read_byte(static_cast<Address>(reg));
+		return peek_byte(static_cast<Address>(reg));
 	}
 
 	void MMU::write_byte(Address address, Byte byte)
 	{
-		// @todo Check for out of bounds behaviour
 		const uint32_t	lutindex = (address >> kLutShiftGranularity);
 			  Region*	region = m_regionsLUT[lutindex];
 		const Address	regionAddr = address - region->m_baseAddress;
 
+		m_breakpoints->check_write(address, byte);
+
 		// If this is an MBC write then consume the byte.
 		// The MBC can prevent writes when they occur inside
 		// certain address ranges that manipulate the MMU in
@@ -223,6 +288,8 @@ namespace gbhw
 			return;
 		}
 
+		m_disassembly->invalidate(address);
+
 		switch (region->m_type)
 		{
 			case RegionType::RomBank0:
@@ -231,6 +298,7 @@ namespace gbhw
 			}
 			case RegionType::VideoRam:
 			{
+				prepare_write(region);
 				region->m_memory[regionAddr] = byte;
 				m_gpu->set_tile_ram_data(address, byte);
 				break;
@@ -240,9 +308,17 @@ namespace gbhw
 			case RegionType::WorkingRam1:
 			case RegionType::WorkingRamEcho0:
 			case RegionType::WorkingRamEcho1:
+			{
+				prepare_write(region);
+				region->m_memory[regionAddr] = byte;
+				break;
+			}
 			case RegionType::ZeroPageRam:	// @todo Safety checks on this.
 			{
 				region->m_memory[regionAddr] = byte;
+
+				if(address == HWRegs::IE)
+					update_pending_interrupts();
 				break;
 			}
 			case RegionType::SpriteAttribute:
@@ -279,23 +355,52 @@ namespace gbhw
 
 						break;
 					}
+					case HWRegs::SC:
+					{
+						region->m_memory[regionAddr] = byte;
+						m_serial->set_control(byte);
+						break;
+					}
 					case HWRegs::DIV:
 					{
+						m_timer->reset_div();
 						region->m_memory[regionAddr] = 0;	// DIV is reset when written to.
 						break;
 					}
+					case HWRegs::TIMA:
+					{
+						m_timer->set_tima(byte);
+						region->m_memory[regionAddr] = byte;
+						break;
+					}
+					case HWRegs::TAC:
+					{
+						m_timer->set_tac(byte);
+						region->m_memory[regionAddr] = byte;
+						break;
+					}
 					case HWRegs::DMA:
 					{
 						Address source = byte << 8;
 						Address dest = 0xFE00;
-						memcpy(&m_memory[dest], &m_memory[source], sizeof(Byte) * 160);
 
-						for(Address i = 0; i < 160; ++i)
-						{
-							const Address dstAddress = dest + i;
-							m_gpu->set_sprite_data(dstAddress, m_memory[dstAddress]);
-						}
+						// The top pages can't read OAM or IO, they mirror working RAM.
+						if(source >= dest)
+							source -= 0x2000;
+
+						// Sources are page aligned, so never cross a region.
+						uint32_t available = 0;
+						const Byte* sourceData = get_dma_source(source, available);
 
+						if(sourceData)
+							memcpy(&m_memory[dest], sourceData, sizeof(Byte) * 160);
+						else
+							memset(&m_memory[dest], 0xFF, sizeof(Byte) * 160);
+
+						m_breakpoints->check_read_block(source, sourceData, 160);
+						m_breakpoints->check_write_block(dest, &m_memory[dest], 160);
+						m_gpu->set_sprite_table(&m_memory[dest]);
+						invalidate_code(dest, 160);
 						break;
 					}
 					case HWRegs::LCDC:
@@ -339,7 +444,14 @@ namespace gbhw
 					}
 					case HWRegs::HDMA5:
 					{
-						region->m_memory[regionAddr] = byte;
+						// Clearing bit 7 during an H-Blank DMA stops it rather than
+						// starting a general-purpose DMA.
+						if(m_dma.active && !m_dma.gdma && !(byte & 0x80))
+						{
+							m_dma.active = false;
+							region->m_memory[regionAddr] = 0x80 | m_dma.length;
+							break;
+						}
 
 						m_dma.active = true;
 						m_dma.length = byte & 0x7F;
@@ -388,6 +500,7 @@ namespace gbhw
 						m_gpu->set_tile_ram_bank(byte);
 
 						region->m_memory[regionAddr] = byte;
+						break;
 					}
 					case HWRegs::SVBK:
 					{
@@ -396,6 +509,21 @@ namespace gbhw
 						byte &= 0x07;
 						load_wram_bank(byte);
 						region->m_memory[regionAddr] = byte;
+						break;
+					}
+					case HWRegs::Key1:
+					{
+						// Only the prepare bit is writable, the current speed is
+						// set by the CPU when it switches. DMG has no speed switch.
+						if(is_colour())
+							region->m_memory[regionAddr] = (region->m_memory[regionAddr] & 0x80) | (byte & 0x01);
+						break;
+					}
+					case HWRegs::IF:
+					{
+						region->m_memory[regionAddr] = byte;
+						update_pending_interrupts();
+						break;
 					}
 					default:
 					{
@@ -424,6 +552,9 @@ namespace gbhw
 		// Special case by-pass for IO regs, this is essentially a HW write rather
 		// than a SW write.
 		m_memory[static_cast<Address>(reg)] = byte;
+
+		if((reg == HWRegs::IF) || (reg == HWRegs::IE))
+			update_pending_interrupts();
 	}
 
 	void MMU::set_button_state(gbhw_button_t button, gbhw_button_state_t state)
@@ -461,6 +592,12 @@ namespace gbhw
 		if (romBankData)
 		{
 			m_regions[destRegion].m_memory = romBankData;
+
+			if(destRegion == RegionType::RomBank1)
+			{
+				m_romBank = sourceBankIndex;
+				m_perf->rom_bank_switches++;
+			}
 		}
 		else
 		{
@@ -476,6 +613,8 @@ namespace gbhw
 		if (data)
 		{
 			m_regions[RegionType::VideoRam].m_memory = data;
+			m_regions[RegionType::VideoRam].m_bank = &m_vramBanks[index];
+			invalidate_code(0x8000, 8192);
 		}
 		else
 		{
@@ -494,7 +633,9 @@ namespace gbhw
 		if(data)
 		{
 			m_regions[RegionType::WorkingRam1].m_memory = data;
+			m_regions[RegionType::WorkingRam1].m_bank = &m_wramBanks[index];
 			echo_region(RegionType::WorkingRam1, RegionType::WorkingRamEcho1);
+			invalidate_code(0xD000, 4096);
 		}
 		else
 		{
@@ -507,7 +648,11 @@ namespace gbhw
 		uint8_t* bank = m_eramBanks[index].m_memory;
 
 		if(bank)
+		{
 			m_regions[RegionType::ExternalRam].m_memory = bank;
+			m_regions[RegionType::ExternalRam].m_bank = &m_eramBanks[index];
+			invalidate_code(0xA000, 8192);
+		}
 		else
 			log_error("Failed to load ERAM bank\n");
 	}
@@ -515,11 +660,86 @@ namespace gbhw
 	void MMU::set_enable_eram(bool bEnabled)
 	{
 		m_regions[RegionType::ExternalRam].m_bEnabled = bEnabled;
+		invalidate_code(0xA000, 8192);
+	}
+
+	void MMU::perform_hdma()
+	{
+		// One 16 byte block per H-Blank, the registers advance past it.
+		copy_to_vram(m_dma.source.addr, m_dma.dest.addr, 16);
+		m_perf->hdma_bytes += 16;
+
+		m_dma.source.addr	+= 16;
+		m_dma.dest.addr		+= 16;
+
+		if(m_dma.length-- == 0)
+		{
+			m_dma.active = false;
+			m_dma.length = 0;
+			m_memory[HWRegs::HDMA5] = 0xFF;
+		}
+	}
+
+	void MMU::copy_to_vram(Address source, Address dest, uint32_t size)
+	{
+		// Only bits 4-12 of the destination are used, it is always in VRAM.
+		Address src = source;
+		Address dst = 0x8000 | (dest & 0x1FF0);
+		uint32_t remaining = size;
+
+		prepare_write(&m_regions[RegionType::VideoRam]);
+
+		// Copy a run at a time, a run ends where the source leaves its region
+		// or the destination reaches the end of VRAM.
+		while((remaining > 0) && (dst < 0xA000))
+		{
+			uint32_t available = 0;
+			const Byte* sourceData	= get_dma_source(src, available);
+			const uint32_t runSize	= std::min(remaining, std::min(available, 0xA000u - dst));
+			Byte* destData			= m_regions[RegionType::VideoRam].m_memory + (dst - 0x8000);
+
+			// Watches see the source before a copy within VRAM overwrites it.
+			m_breakpoints->check_read_block(src, sourceData, runSize);
+
+			if(sourceData)
+				memmove(destData, sourceData, runSize);
+			else
+				memset(destData, 0xFF, runSize);
+
+			m_breakpoints->check_write_block(dst, destData, runSize);
+			m_gpu->set_tile_ram_data(dst, destData, runSize);
+			invalidate_code(dst, runSize);
+
+			src			+= static_cast<Address>(runSize);
+			dst			+= static_cast<Address>(runSize);
+			remaining	-= runSize;
+		}
+	}
+
+	const Byte* MMU::get_dma_source(Address address, uint32_t& available) const
+	{
+		// Host memory for the rest of the region, null if it reads as open bus.
+		const Region* region = m_regionsLUT[(address >> kLutShiftGranularity)];
+		const Address offset = address - region->m_baseAddress;
+
+		available = region->m_size - offset;
+
+		if(!region->m_bEnabled)
+			return nullptr;
+
+		return region->m_memory + offset;
+	}
+
+	void MMU::invalidate_code(Address first, uint32_t size)
+	{
+		// Banks are first mapped before the MMU is initialised.
+		if(m_disassembly)
+			m_disassembly->invalidate(first, size);
 	}
 
 	const uint8_t* MMU::get_memory_ptr_from_addr(Address address)
 	{
-		// @todo: Check for out of bounds behaviour
+		// Valid for the remainder of the region containing the address.
 		const Region* region = m_regionsLUT[(address >> kLutShiftGranularity)];
 		return (region->m_memory + (address - region->m_baseAddress));
 	}
@@ -528,19 +748,14 @@ namespace gbhw
 	{
 		log_debug("general-purpose dma. Src=0x%04x, Dst=0x%04x, Len=%u\n", m_dma.source.addr, m_dma.dest.addr, m_dma.length);
 
-		Address src = m_dma.source.addr;
-		Address dst = m_dma.dest.addr;
+		const uint32_t size = (m_dma.length + 1) * 16;
 
-		for(Word i = 0; i < m_dma.length + 1; ++i)
-		{
-			for(Byte c = 0; c < 16; ++c)
-			{
-				write_byte(dst++, read_byte(src++));
-			}
-		}
+		copy_to_vram(m_dma.source.addr, m_dma.dest.addr, size);
+		m_perf->gdma_bytes += size;
 
 		m_dma.active = false;
 		m_dma.length = 0;
+		m_memory[HWRegs::HDMA5] = 0xFF;
 
 #if 0
 		Bit7=0 - General Purpose DMA
@@ -568,6 +783,11 @@ Transfer Mode:
 #endif
 	}
 
+	void MMU::update_pending_interrupts()
+	{
+		m_pendingInterrupts = m_memory[HWRegs::IF] & m_memory[HWRegs::IE] & HWInterrupts::kMask;
+	}
+
 	void MMU::initialise_region(RegionType::Enum type, Address baseaddress, uint16_t size, bool bEnabled, bool bReadOnly)
 	{
 		Region* region = &m_regions[type];
@@ -579,6 +799,7 @@ Transfer Mode:
 		region->m_baseAddress	= baseaddress;
 		region->m_bEnabled		= bEnabled;
 		region->m_bReadOnly		= bReadOnly;
+		region->m_bank			= nullptr;
 
 		// Setup LUT.
 		uint32_t lutindex = (baseaddress >> kLutShiftGranularity);
@@ -593,28 +814,64 @@ Transfer Mode:
 	void MMU::initialise_ram()
 	{
 		// 2 x 8KiB banks available for VRAM.
-		for(uint32_t i = 0; i < 2; ++i)
+		add_banks(m_vramBanks, 2, 8192);
+
+		// 7 x 4KiB banks available for 2nd half of WRAM.
+		add_banks(m_wramBanks, 7, 4096);
+
+		// 16 x 8KiB banks available for eram.
+		add_banks(m_eramBanks, 16, 8192);
+	}
+
+	void MMU::add_banks(MemoryBanks& banks, uint32_t count, uint32_t size)
+	{
+		for(uint32_t i = 0; i < count; ++i)
 		{
 			MemoryBank bank;
-			bank.m_memory = new uint8_t[8192];
-			m_vramBanks.push_back(bank);
+			bank.m_storage	= std::make_shared<Buffer>(size);
+			bank.m_memory	= bank.m_storage->data();
+			banks.push_back(bank);
 		}
+	}
 
-		// 7 x 4KiB banks available for 2nd half of WRAM.
-		for(uint32_t i = 0; i < 7; ++i)
+	void MMU::unshare_bank(MemoryBank& bank)
+	{
+		// The last owner can keep the storage, otherwise take a private copy
+		// and move every region mapping the bank onto it.
+		if(bank.m_storage.use_count() > 1)
 		{
-			MemoryBank bank;
-			bank.m_memory = new uint8_t[4096];
-			m_wramBanks.push_back(bank);
+			bank.m_storage	= std::make_shared<Buffer>(*bank.m_storage);
+			bank.m_memory	= bank.m_storage->data();
+
+			for(Region& region : m_regions)
+			{
+				if(region.m_bank == &bank)
+					region.m_memory = bank.m_memory;
+			}
+		}
+		else
+		{
+			// Forks on other threads released the storage after their last
+			// read of it.
+			std::atomic_thread_fence(std::memory_order_acquire);
 		}
 
-		// 16 x 8KiB banks available for eram.
-		for(uint32_t i = 0; i < 16; ++i)
+		bank.m_bShared = false;
+	}
+
+	MemoryBank* MMU::get_forked_bank(const MMU& parent, const MemoryBank* bank)
+	{
+		// The bank at the same index in this MMU's copy of the bank vectors.
+		const MemoryBanks* parentBanks[]	= { &parent.m_vramBanks, &parent.m_wramBanks, &parent.m_eramBanks };
+		MemoryBanks* banks[]				= { &m_vramBanks, &m_wramBanks, &m_eramBanks };
+
+		for(uint32_t i = 0; bank && (i < 3); i++)
 		{
-			MemoryBank bank;
-			bank.m_memory = new uint8_t[8192];
-			m_eramBanks.push_back(bank);
+			if((bank >= parentBanks[i]->data()) && (bank < (parentBanks[i]->data() + parentBanks[i]->size())))
+				return &(*banks[i])[bank - parentBanks[i]->data()];
 		}
+
+		return nullptr;
 	}
 
 	void MMU::echo_region(RegionType::Enum src, RegionType::Enum dst)
@@ -622,6 +879,7 @@ Transfer Mode:
 		Region& srcRegion = m_regions[static_cast<uint32_t>(src)];
 		Region& dstRegion = m_regions[static_cast<uint32_t>(dst)];
 		dstRegion.m_memory = srcRegion.m_memory;
+		dstRegion.m_bank = srcRegion.m_bank;
 	}
 
 	void MMU::reset()
@@ -629,10 +887,16 @@ Transfer Mode:
 		memset(m_memory, 0, kMemorySize);
 
 		for(auto& bank : m_wramBanks)
+		{
+			unshare_bank(bank);
 			memset(bank.m_memory, 0, 4096);
+		}
 
 		for(auto& bank : m_eramBanks)
+		{
+			unshare_bank(bank);
 			memset(bank.m_memory, 0, 8192);
+		}
 
 		m_memory[HWRegs::P1] = 0xFF;
 
@@ -672,12 +936,16 @@ Transfer Mode:
 
 		m_memory[0xFF4A] = 0x00;
 		m_memory[0xFF4B] = 0x00;
+		m_memory[HWRegs::Key1] = is_colour() ? 0x00 : 0xFF;
 		m_memory[HWRegs::IE] = 0x00;
 
 		memset(&m_dma, 0, sizeof(DMAState));
+		m_memory[HWRegs::HDMA5] = 0xFF;
 
 		m_buttonColumn = 0;
 		m_buttonsDirection = 0x0F;
 		m_buttonsFace = 0x0F;
+
+		update_pending_interrupts();
 	}
 }
\ No newline at end of file
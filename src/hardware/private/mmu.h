@@ -1,13 +1,19 @@
 #pragma once
 
+#include "breakpoints.h"
+#include "disassembly.h"
 #include "gbhw.h"
 #include "mbc.h"
+#include "perf.h"
+#include <memory>
 
 namespace gbhw
 {
 	class CPU;
 	class GPU;
 	class Rom;
+	class Serial;
+	class Timer;
 
 	// The Gameboy has a total addressable memory size of 65536, which is divided
 	// into regions. Behavior changes depending on the region accessed. Below is
@@ -34,8 +40,10 @@ namespace gbhw
 	// Store details about a specific memory bank
 	struct MemoryBank
 	{
-		inline MemoryBank() : m_memory(nullptr) {}
-		uint8_t* m_memory;
+		inline MemoryBank() : m_memory(nullptr), m_bShared(false) {}
+		uint8_t*				m_memory;
+		std::shared_ptr<Buffer>	m_storage;		// RAM banks only, ROM banks point into the ROM.
+		bool					m_bShared;		// Storage may be shared with a fork, copy it before writing.
 	};
 
 	// Store details about the current DMA
@@ -46,7 +54,6 @@ namespace gbhw
 		Byte		length;
 		bool		gdma;
 		bool		active;
-		int16_t		hdma_cycles;
 	};
 
 	using MemoryBanks = std::vector<MemoryBank>;
@@ -82,18 +89,26 @@ namespace gbhw
 			Address				m_baseAddress;
 			bool				m_bEnabled;
 			bool				m_bReadOnly;
+			MemoryBank*			m_bank;			// RAM bank mapped into the region, null if fixed.
 		};
 
 	public:
 		MMU();
 		~MMU();
 
-		void initialise(CPU* cpu, GPU* gpu, Rom* rom);
+		void initialise(CPU* cpu, GPU* gpu, Rom* rom, Timer* timer, Serial* serial, PerfCounters* perf, Breakpoints* breakpoints, Disassembly* disassembly);
+
+		// Takes on the parent's state. RAM banks are shared by both until
+		// either writes to them, so the parent must not be running.
+		void fork(MMU& parent);
 		void reset(CartridgeType::Type cartridgeType);
-		void update(uint16_t cycles);
+		// GPU entered H-Blank, H-Blank DMA copies its next block.
+		inline void update_hblank() { if(m_dma.active && !m_dma.gdma) perform_hdma(); }
 
 		Byte read_byte(Address address) const;
+		Byte peek_byte(Address address) const;		// As read_byte, without triggering watchpoints.
 		Word read_word(Address address) const;
+		Word peek_word(Address address) const;		// As read_word, without triggering watchpoints.
 		Byte read_io(HWRegs::Type reg);
 
 		void write_byte(Address address, Byte byte);
@@ -109,9 +124,25 @@ namespace gbhw
 		void set_enable_eram(bool bEnabled);
 
 		const uint8_t* get_memory_ptr_from_addr(Address address);
+		inline uint32_t get_rom_bank() const { return m_romBank; }
+
+		// IF & IE, kept up to date by every write to either register.
+		inline Byte get_pending_interrupts() const { return m_pendingInterrupts; }
+
+		// The loaded ROM runs in CGB mode, which has the CGB only registers.
+		bool is_colour() const;
 
 	private:
 		void perform_gdma();
+		void perform_hdma();
+		void copy_to_vram(Address source, Address dest, uint32_t size);
+		const Byte* get_dma_source(Address address, uint32_t& available) const;
+		void invalidate_code(Address first, uint32_t size);
+		void update_pending_interrupts();
+		inline void prepare_write(Region* region);
+		void unshare_bank(MemoryBank& bank);
+		MemoryBank* get_forked_bank(const MMU& parent, const MemoryBank* bank);
+		void add_banks(MemoryBanks& banks, uint32_t count, uint32_t size);
 
 		void initialise_region(RegionType::Enum type, Address baseaddress, uint16_t size, bool bEnabled, bool bReadOnly);
 		void initialise_ram();
@@ -125,6 +156,11 @@ namespace gbhw
 		GPU*					m_gpu;
 		CPU*					m_cpu;
 		Rom*					m_rom;
+		Timer*					m_timer;
+		Serial*					m_serial;
+		PerfCounters*			m_perf;
+		Breakpoints*			m_breakpoints;
+		Disassembly*			m_disassembly;
 		uint8_t					m_memory[kMemorySize];
 		Region					m_regions[static_cast<uint32_t>(RegionType::Count)];
 		Region*					m_regionsLUT[kRegionLutCount];
@@ -133,9 +169,19 @@ namespace gbhw
 		MemoryBanks				m_eramBanks;
 		MemoryBanks				m_vramBanks;
 		DMAState				m_dma;
+		uint32_t				m_romBank;		// Bank mapped into RomBank1.
+		Byte					m_pendingInterrupts;
 
 		Byte					m_buttonColumn;
 		Byte					m_buttonsDirection;
 		Byte					m_buttonsFace;
 	};
-}
\ No newline at end of file
+
+	//--------------------------------------------------------------------------
+
+	inline void MMU::prepare_write(Region* region)
+	{
+		if(region->m_bank && region->m_bank->m_bShared)
+			unshare_bank(*region->m_bank);
+	}
+}
@@ -0,0 +1,372 @@
+#include "netplay.h"
+#include <algorithm>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		// Packet layout, little endian:
+		//	0	'G' 'N'
+		//	2	Sending player
+		//	3	Input count
+		//	4	Remote frames the sender has, acknowledging them
+		//	8	Frame of the first input
+		//	12	One byte of buttons per input
+		const Byte kMagic[2] = { 'G', 'N' };
+
+		void write_u32(Byte* data, uint32_t value)
+		{
+			for(uint32_t i = 0; i < 4; i++)
+				data[i] = static_cast<Byte>(value >> (i * 8));
+		}
+
+		uint32_t read_u32(const Byte* data)
+		{
+			return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+		}
+
+		uint64_t get_elapsed_ns(const Clock::time_point& start)
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+		}
+	}
+
+	//--------------------------------------------------------------------------
+
+	Netplay::Netplay()
+		: m_ctx(nullptr)
+		, m_player(0)
+		, m_inputDelay(0)
+		, m_maxRollback(kDefaultRollback)
+		, m_buttons(0)
+		, m_frame(0)
+		, m_localFrame(0)
+		, m_remoteFrame(0)
+		, m_remoteAck(0)
+		, m_rollbackFrame(kNoFrame)
+	{
+		memset(&m_transport, 0, sizeof(m_transport));
+		memset(m_predicted, 0, sizeof(m_predicted));
+		memset(m_snapshots, 0, sizeof(m_snapshots));
+		memset(m_snapshotButtons, 0, sizeof(m_snapshotButtons));
+		memset(&m_stats, 0, sizeof(m_stats));
+	}
+
+	Netplay::~Netplay()
+	{
+		for(gbhw_context_t snapshot : m_snapshots)
+			gbhw_destroy(snapshot);
+	}
+
+	bool Netplay::initialise(gbhw_context_t ctx, const gbhw_netplay_settings_t& settings)
+	{
+		if(!ctx || (settings.player >= kPlayers) || (settings.input_delay > kMaxInputDelay) || (settings.max_rollback > kMaxRollback))
+			return false;
+
+		if(!settings.transport.send || !settings.transport.receive)
+			return false;
+
+		m_ctx			= ctx;
+		m_transport		= settings.transport;
+		m_player		= settings.player;
+		m_inputDelay	= settings.input_delay;
+		m_maxRollback	= settings.max_rollback;
+
+		if(m_maxRollback == 0)
+			m_maxRollback = kDefaultRollback;
+
+		for(uint32_t i = 0; i <= m_maxRollback; i++)
+			gbhw_fork(ctx, &m_snapshots[i]);
+
+		// Nobody has pressed anything during the input delay.
+		for(uint32_t player = 0; player < kPlayers; player++)
+		{
+			for(uint32_t frame = 0; frame < kInputCount; frame++)
+			{
+				m_inputs[player][frame].frame	= kNoFrame;
+				m_inputs[player][frame].buttons	= 0;
+
+				if(frame < m_inputDelay)
+					m_inputs[player][frame].frame = frame;
+			}
+		}
+
+		m_localFrame	= m_inputDelay;
+		m_remoteFrame	= m_inputDelay;
+		m_remoteAck		= m_inputDelay;
+
+		// The joypad is only driven from here on.
+		for(uint32_t button = button_a; button <= button_dpad_down; button++)
+			gbhw_set_button_state(m_ctx, static_cast<gbhw_button_t>(button), button_released);
+
+		return true;
+	}
+
+	bool Netplay::advance(Byte buttons)
+	{
+		receive();
+
+		// Running further ahead would leave more frames to emulate again than
+		// a rollback is allowed.
+		if(m_frame >= (m_remoteFrame + m_maxRollback))
+		{
+			m_stats.stalls++;
+			send();
+			return false;
+		}
+
+		Input& input	= m_inputs[m_player][m_localFrame & (kInputCount - 1)];
+		input.frame		= m_localFrame++;
+		input.buttons	= buttons;
+
+		send();
+
+		if(m_rollbackFrame != kNoFrame)
+			rollback();
+
+		emulate_frame();
+
+		m_stats.frame				= m_frame;
+		m_stats.confirmed_frames	= std::min(m_frame, m_remoteFrame);
+		return true;
+	}
+
+	//--------------------------------------------------------------------------
+
+	void Netplay::send()
+	{
+		// Oldest first, the remote peer can never be missing more than fit.
+		const uint32_t first = m_remoteAck;
+		const uint32_t count = std::min<uint32_t>(m_localFrame - first, static_cast<uint32_t>(kMaxPacketInputs));
+		Byte packet[kMaxPacket];
+
+		packet[0] = kMagic[0];
+		packet[1] = kMagic[1];
+		packet[2] = static_cast<Byte>(m_player);
+		packet[3] = static_cast<Byte>(count);
+		write_u32(&packet[4], m_remoteFrame);
+		write_u32(&packet[8], first);
+
+		for(uint32_t i = 0; i < count; i++)
+			packet[kPacketHeader + i] = m_inputs[m_player][(first + i) & (kInputCount - 1)].buttons;
+
+		m_transport.send(m_transport.userdata, packet, kPacketHeader + count);
+	}
+
+	void Netplay::receive()
+	{
+		Byte packet[kMaxPacket];
+		uint32_t size;
+
+		while((size = m_transport.receive(m_transport.userdata, packet, kMaxPacket)) != 0)
+			receive_packet(packet, size);
+	}
+
+	void Netplay::receive_packet(const Byte* data, uint32_t size)
+	{
+		const uint32_t remote = m_player ^ 1;
+
+		if((size < kPacketHeader) || (data[0] != kMagic[0]) || (data[1] != kMagic[1]) || (data[2] != remote))
+			return;
+
+		const uint32_t count = data[3];
+
+		if((count > kMaxPacketInputs) || (size < (kPacketHeader + count)))
+			return;
+
+		// Packets may arrive out of order, acknowledgements only move forward.
+		const uint32_t ack = read_u32(&data[4]);
+
+		if((ack > m_remoteAck) && (ack <= m_localFrame))
+			m_remoteAck = ack;
+
+		const uint32_t first = read_u32(&data[8]);
+
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t frame = first + i;
+
+			// The last known input is kept for predicting from, anything further
+			// ahead than that leaves room for is sent again.
+			if((frame < m_remoteFrame) || (frame >= (m_remoteFrame + kInputCount - 1)))
+				continue;
+
+			Input& input	= m_inputs[remote][frame & (kInputCount - 1)];
+			input.frame		= frame;
+			input.buttons	= data[kPacketHeader + i];
+		}
+
+		// Frames already emulated on a prediction are checked as the input
+		// leading up to them completes.
+		for(;;)
+		{
+			const uint32_t slot = m_remoteFrame & (kInputCount - 1);
+			const Input& input = m_inputs[remote][slot];
+
+			if(input.frame != m_remoteFrame)
+				break;
+
+			if((m_remoteFrame < m_frame) && (input.buttons != m_predicted[slot]))
+				m_rollbackFrame = std::min(m_rollbackFrame, m_remoteFrame);
+
+			m_remoteFrame++;
+		}
+	}
+
+	void Netplay::rollback()
+	{
+		const Clock::time_point start	= Clock::now();
+		const uint32_t frames			= m_frame - m_rollbackFrame;
+		const uint32_t slot				= m_rollbackFrame % (m_maxRollback + 1);
+
+		gbhw_copy_state(m_ctx, m_snapshots[slot]);
+		m_buttons	= m_snapshotButtons[slot];
+		m_frame		= m_rollbackFrame;
+
+		// Only the frame being caught up to is drawn.
+		gbhw_set_headless(m_ctx, 1);
+
+		for(uint32_t i = 0; i < frames; i++)
+			emulate_frame();
+
+		gbhw_set_headless(m_ctx, 0);
+		m_rollbackFrame = kNoFrame;
+
+		const uint64_t elapsed = get_elapsed_ns(start);
+
+		m_stats.rollbacks++;
+		m_stats.rollback_frames		+= frames;
+		m_stats.max_rollback_frames	= std::max(m_stats.max_rollback_frames, frames);
+		m_stats.rollback_ns			+= elapsed;
+		m_stats.max_rollback_ns		= std::max(m_stats.max_rollback_ns, elapsed);
+	}
+
+	void Netplay::emulate_frame()
+	{
+		const Clock::time_point start	= Clock::now();
+		const uint32_t slot				= m_frame % (m_maxRollback + 1);
+
+		gbhw_copy_state(m_snapshots[slot], m_ctx);
+		m_snapshotButtons[slot] = m_buttons;
+
+		m_stats.snapshot_ns += get_elapsed_ns(start);
+
+		apply_input(m_frame);
+		gbhw_step(m_ctx, step_vsync);
+		m_frame++;
+	}
+
+	void Netplay::apply_input(uint32_t frame)
+	{
+		const uint32_t slot		= frame & (kInputCount - 1);
+		const Byte remote		= get_remote_input(frame);
+		const Byte buttons		= m_inputs[m_player][slot].buttons | remote;
+		const Byte changed		= buttons ^ m_buttons;
+
+		m_predicted[slot] = remote;
+
+		// Only changes are applied, every press raises the joypad interrupt.
+		for(uint32_t button = button_a; button <= button_dpad_down; button++)
+		{
+			if(changed & (1 << button))
+				gbhw_set_button_state(m_ctx, static_cast<gbhw_button_t>(button), (buttons & (1 << button)) ? button_pressed : button_released);
+		}
+
+		m_buttons = buttons;
+	}
+
+	Byte Netplay::get_remote_input(uint32_t frame) const
+	{
+		const uint32_t remote = m_player ^ 1;
+		const Input& input = m_inputs[remote][frame & (kInputCount - 1)];
+
+		if(input.frame == frame)
+			return input.buttons;
+
+		// Players tend to hold buttons, predict the last known input repeats.
+		if(m_remoteFrame == 0)
+			return 0;
+
+		return m_inputs[remote][(m_remoteFrame - 1) & (kInputCount - 1)].buttons;
+	}
+
+	//--------------------------------------------------------------------------
+
+	LoopbackLink::LoopbackLink()
+		: m_latency(0)
+		, m_lossPercent(0)
+	{
+		for(uint32_t side = 0; side < 2; side++)
+		{
+			m_endpoints[side].link		= this;
+			m_endpoints[side].side		= side;
+			m_endpoints[side].lossSeed	= 0x9E3779B9u * (side + 1);
+		}
+	}
+
+	void LoopbackLink::initialise(uint32_t latencyMs, uint32_t lossPercent)
+	{
+		m_latency		= std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(latencyMs));
+		m_lossPercent	= std::min(lossPercent, 100u);
+	}
+
+	void LoopbackLink::get_transport(uint32_t side, gbhw_netplay_transport_t& transport)
+	{
+		transport.userdata	= &m_endpoints[side];
+		transport.send		= &LoopbackLink::send;
+		transport.receive	= &LoopbackLink::receive;
+	}
+
+	//--------------------------------------------------------------------------
+
+	void LoopbackLink::send(void* userdata, const uint8_t* data, uint32_t size)
+	{
+		Endpoint& endpoint	= *static_cast<Endpoint*>(userdata);
+		LoopbackLink& link	= *endpoint.link;
+
+		std::lock_guard<std::mutex> lock(link.m_mutex);
+
+		// Xorshift, the same packets are dropped every run.
+		endpoint.lossSeed ^= endpoint.lossSeed << 13;
+		endpoint.lossSeed ^= endpoint.lossSeed >> 17;
+		endpoint.lossSeed ^= endpoint.lossSeed << 5;
+
+		if((endpoint.lossSeed % 100) < link.m_lossPercent)
+			return;
+
+		Packet packet;
+		packet.arrival = Clock::now() + link.m_latency;
+		packet.data.assign(data, data + size);
+
+		link.m_endpoints[endpoint.side ^ 1].incoming.push_back(std::move(packet));
+	}
+
+	uint32_t LoopbackLink::receive(void* userdata, uint8_t* data, uint32_t capacity)
+	{
+		Endpoint& endpoint	= *static_cast<Endpoint*>(userdata);
+		LoopbackLink& link	= *endpoint.link;
+
+		std::lock_guard<std::mutex> lock(link.m_mutex);
+
+		while(!endpoint.incoming.empty() && (endpoint.incoming.front().arrival <= Clock::now()))
+		{
+			const Buffer packet = std::move(endpoint.incoming.front().data);
+			endpoint.incoming.pop_front();
+
+			// As a datagram socket would, packets too big to take are lost.
+			if(packet.size() > capacity)
+				continue;
+
+			memcpy(data, packet.data(), packet.size());
+			return static_cast<uint32_t>(packet.size());
+		}
+
+		return 0;
+	}
+
+	//--------------------------------------------------------------------------
+}
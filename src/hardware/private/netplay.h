@@ -0,0 +1,127 @@
+#pragma once
+
+#include "gbhw.h"
+#include "types.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Rollback netplay for two peers emulating the same game. Each frame both
+	// players' buttons are merged onto the context's joypad, a button is held
+	// if either player holds it.
+	//
+	// Local input is sent every frame and the remote input is predicted to
+	// repeat its last known value until it arrives. A snapshot is taken before
+	// every frame, when a prediction turns out wrong the snapshot of the first
+	// wrong frame is restored and the frames since are emulated again headless.
+	// Snapshots are contexts refreshed with gbhw_copy_state, so taking one only
+	// copies RAM banks written since.
+	//
+	// Packets carry every input the remote peer hasn't acknowledged, a lost
+	// packet is covered by the next. Peers never run more than the rollback
+	// window ahead of the input they have confirmed.
+	class Netplay
+	{
+	public:
+		static const uint32_t kMaxRollback		= 16;
+		static const uint32_t kDefaultRollback	= 8;
+		static const uint32_t kMaxInputDelay	= 16;
+
+		Netplay();
+		~Netplay();
+
+		bool initialise(gbhw_context_t ctx, const gbhw_netplay_settings_t& settings);
+
+		// False if too far ahead of the remote peer, nothing is emulated and
+		// the input is dropped.
+		bool advance(Byte buttons);
+		inline const gbhw_netplay_stats_t& get_stats() const { return m_stats; }
+
+	private:
+		static const uint32_t kPlayers			= 2;
+		static const uint32_t kNoFrame			= ~0u;
+		static const uint32_t kInputCount		= 128;	// Frames of input kept, a power of two.
+		static const uint32_t kMaxPacketInputs	= 64;
+		static const uint32_t kPacketHeader		= 12;
+		static const uint32_t kMaxPacket		= kPacketHeader + kMaxPacketInputs;
+
+		struct Input
+		{
+			uint32_t	frame;		// Frame the slot holds, kNoFrame if none.
+			Byte		buttons;
+		};
+
+		void send();
+		void receive();
+		void receive_packet(const Byte* data, uint32_t size);
+		void rollback();
+		void emulate_frame();
+		void apply_input(uint32_t frame);
+		Byte get_remote_input(uint32_t frame) const;
+
+		gbhw_context_t				m_ctx;
+		gbhw_netplay_transport_t	m_transport;
+		uint32_t					m_player;
+		uint32_t					m_inputDelay;
+		uint32_t					m_maxRollback;
+
+		Input						m_inputs[kPlayers][kInputCount];
+		Byte						m_predicted[kInputCount];		// Remote input each emulated frame used.
+		gbhw_context_t				m_snapshots[kMaxRollback + 1];	// State before each of the latest frames.
+		Byte						m_snapshotButtons[kMaxRollback + 1];
+		Byte						m_buttons;						// Merged input applied to the joypad.
+
+		uint32_t					m_frame;			// Next frame to emulate.
+		uint32_t					m_localFrame;		// Next frame local input is recorded for.
+		uint32_t					m_remoteFrame;		// Remote input is known for every frame before this.
+		uint32_t					m_remoteAck;		// Remote peer has every local input before this.
+		uint32_t					m_rollbackFrame;	// Earliest mispredicted frame, kNoFrame if none.
+
+		gbhw_netplay_stats_t		m_stats;
+	};
+
+	//--------------------------------------------------------------------------
+
+	// In-process stand-in for a network, two endpoints exchanging packets with
+	// a fixed latency and a deterministic share of them dropped. Either side
+	// may be used from its own thread.
+	class LoopbackLink
+	{
+	public:
+		LoopbackLink();
+
+		void initialise(uint32_t latencyMs, uint32_t lossPercent);
+		void get_transport(uint32_t side, gbhw_netplay_transport_t& transport);
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Packet
+		{
+			Clock::time_point	arrival;
+			Buffer				data;
+		};
+
+		struct Endpoint
+		{
+			LoopbackLink*		link;
+			uint32_t			side;
+			std::deque<Packet>	incoming;
+			uint32_t			lossSeed;		// Drops packets sent from this side.
+		};
+
+		static void send(void* userdata, const uint8_t* data, uint32_t size);
+		static uint32_t receive(void* userdata, uint8_t* data, uint32_t capacity);
+
+		std::mutex					m_mutex;
+		Endpoint					m_endpoints[2];
+		Clock::duration				m_latency;
+		uint32_t					m_lossPercent;
+	};
+
+	//--------------------------------------------------------------------------
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gbhw.h"
+#include "types.h"
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Per-context performance counters. These are always compiled in, each
+	// component is handed a pointer at initialisation and bumps the relevant
+	// counter inline on paths that are already being executed.
+	struct PerfCounters : public gbhw_perf_counters
+	{
+		inline PerfCounters()
+		{
+			reset();
+		}
+
+		inline void reset()
+		{
+			memset(static_cast<gbhw_perf_counters*>(this), 0, sizeof(gbhw_perf_counters));
+		}
+	};
+
+	//--------------------------------------------------------------------------
+}
@@ -66,6 +66,24 @@ namespace gbhw
 		reset();
 	}
 
+	Registers::Registers(const Registers& other)
+		: Registers()
+	{
+		*this = other;
+	}
+
+	Registers& Registers::operator=(const Registers& other)
+	{
+		af	= other.af;
+		bc	= other.bc;
+		de	= other.de;
+		hl	= other.hl;
+		sp	= other.sp;
+		pc	= other.pc;
+		ime	= other.ime;
+		return *this;
+	}
+
 	void Registers::reset()
 	{
 		af = 0x11B0; //DMG = 0x01B0, GBP = 0xFFB0
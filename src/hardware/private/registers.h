@@ -129,6 +129,10 @@ namespace gbhw
 	{
 	public:
 		Registers();
+		Registers(const Registers& other);
+
+		// Copies values only, the lookups keep pointing at this instance.
+		Registers& operator=(const Registers& other);
 
 		void reset();
 
@@ -16,7 +16,8 @@ namespace gbhw
 		static const uint32_t kRamSizeOffset			= 0x149;
 		static const uint32_t kDestinationCodeOffset	= 0x14A;
 		static const uint32_t kLicenseeCodeOldOffset	= 0x14B;
-		static const uint32_t kBankSize					= 16384;
+		static const uint32_t kHeaderEnd				= 0x150;
+		static const uint32_t kMaxBankCount				= 512;	// MBC5, 8MB.
 	}
 
 	//--------------------------------------------------------------------------
@@ -32,13 +33,23 @@ namespace gbhw
 
 	bool Rom::load(const uint8_t* data, uint32_t length)
 	{
-		reset();
+		// Rejected data leaves the current ROM loaded.
+		if(length < kHeaderEnd)
+		{
+			log_error("ROM is too small to contain a cartridge header\n");
+			return false;
+		}
 
-		if(length == 0)
+		if(((static_cast<uint64_t>(length) + kBankSize - 1) / kBankSize) > kMaxBankCount)
+		{
+			log_error("ROM is larger than any supported cartridge\n");
 			return false;
+		}
 
-		// Copy ROM into memory.
-		m_romData = Buffer(&data[0], &data[length]);
+		reset();
+
+		// Copy ROM into memory, forks share the copy as it is never written.
+		m_romData = std::make_shared<Buffer>(&data[0], &data[length]);
 
 		// Perform actual load.
 		load_header();
@@ -47,25 +58,42 @@ namespace gbhw
 		return true;
 	}
 
-	uint8_t* Rom::get_bank(Byte bankIndex)
+	uint32_t Rom::get_bank_count() const
+	{
+		return static_cast<uint32_t>(m_banks.size());
+	}
+
+	uint8_t* Rom::get_bank(uint32_t bankIndex)
 	{
-		if (bankIndex < m_banks.size())
+		if (!m_banks.empty())
 		{
-			return m_banks[bankIndex].m_memory;
+			// Bank count is a power of two, unused high bits of the bank number
+			// are ignored in the same way the cartridge address lines ignore them.
+			return m_banks[bankIndex & (m_banks.size() - 1)].m_memory;
 		}
 
-		log_error("Failed to obtain rom bank, index out of range\n");
+		log_error("Failed to obtain rom bank, no rom loaded\n");
 		return nullptr;
 	}
 
+	bool Rom::is_same_data(const Rom& other) const
+	{
+		return m_romData == other.m_romData;
+	}
+
 	CartridgeType::Type Rom::get_cartridge_type() const
 	{
 		return m_cartridgeType;
 	}
 
+	HardwareType::Type Rom::get_hardware_type() const
+	{
+		return m_hardwareType;
+	}
+
 	void Rom::reset()
 	{
-		m_romData.resize(0);
+		m_romData = std::make_shared<Buffer>();
 		m_title				= "";
 		m_cartridgeType		= CartridgeType::Unknown;
 		m_hardwareType		= HardwareType::Unknown;
@@ -78,17 +106,15 @@ namespace gbhw
 
 	void Rom::load_header()
 	{
-		m_title				= std::string(m_romData.begin() + kTitleOffset, m_romData.begin() + kTitleOffset + kTitleLength);
-		m_cartridgeType		= static_cast<CartridgeType::Type>(m_romData[kCartridgeTypeOffset]);
-		m_romSize			= static_cast<RomSize::Type>(m_romData[kRomSizeOffset]);
-		m_ramSize			= static_cast<RamSize::Type>(m_romData[kRamSizeOffset]);
-		m_destinationCode	= static_cast<DestinationCode::Type>(m_romData[kDestinationCodeOffset]);
-		m_licenseeCodeOld	= static_cast<LicenseeCodeOld::Type>(m_romData[kLicenseeCodeOldOffset]);
-
-		// @todo: sanity check rom size matches supplied data buffer.
+		m_title				= std::string(m_romData->begin() + kTitleOffset, m_romData->begin() + kTitleOffset + kTitleLength);
+		m_cartridgeType		= static_cast<CartridgeType::Type>((*m_romData)[kCartridgeTypeOffset]);
+		m_romSize			= static_cast<RomSize::Type>((*m_romData)[kRomSizeOffset]);
+		m_ramSize			= static_cast<RamSize::Type>((*m_romData)[kRamSizeOffset]);
+		m_destinationCode	= static_cast<DestinationCode::Type>((*m_romData)[kDestinationCodeOffset]);
+		m_licenseeCodeOld	= static_cast<LicenseeCodeOld::Type>((*m_romData)[kLicenseeCodeOldOffset]);
 
 		// Detect HW type
-		Byte hwType = static_cast<Byte>(m_romData[kHWTypeOffset]);
+		Byte hwType = static_cast<Byte>((*m_romData)[kHWTypeOffset]);
 
 		if (hwType == 0x80 || hwType == 0xC0)
 		{
@@ -96,7 +122,7 @@ namespace gbhw
 		}
 		else
 		{
-			if(m_romData[kSGBIndicatorOffset] == 0x03)
+			if((*m_romData)[kSGBIndicatorOffset] == 0x03)
 			{
 				m_hardwareType = HardwareType::SuperGameboy;
 			}
@@ -118,8 +144,23 @@ namespace gbhw
 
 	void Rom::load_banks()
 	{
-		m_banks.resize(RomSize::get_bank_count(m_romSize));
-		uint8_t* dataPtr = m_romData.data();
+		const uint32_t headerBanks	= RomSize::get_bank_count(m_romSize);
+		const uint32_t dataBanks	= static_cast<uint32_t>((m_romData->size() + kBankSize - 1) / kBankSize);
+
+		if(headerBanks != dataBanks)
+			log_warning("ROM header declares %u banks, data contains %u\n", headerBanks, dataBanks);
+
+		// Provide whichever is larger so no bank reference can point past the
+		// data, rounded up to a power of two so bank numbers can be wrapped.
+		// Missing data reads as open bus.
+		uint32_t bankCount = 2;
+
+		while(bankCount < std::max(headerBanks, dataBanks))
+			bankCount <<= 1;
+
+		m_romData->resize(bankCount * kBankSize, 0xFF);
+		m_banks.resize(bankCount);
+		uint8_t* dataPtr = m_romData->data();
 
 		for (auto& bank : m_banks)
 		{
@@ -9,20 +9,25 @@ namespace gbhw
 	class Rom
 	{
 	public:
+		static const uint32_t kBankSize = 16384;
+
 		Rom();
 		~Rom();
 
 		bool load(const uint8_t* data, uint32_t length);
 
-		uint8_t* get_bank(Byte bankIndex);
+		uint32_t get_bank_count() const;
+		uint8_t* get_bank(uint32_t bankIndex);
 		CartridgeType::Type get_cartridge_type() const;
+		HardwareType::Type get_hardware_type() const;
+		bool is_same_data(const Rom& other) const;		// Both hold the same load of a ROM.
 
 	private:
 		void reset();
 		void load_header();
 		void load_banks();
 
-		Buffer						m_romData;
+		std::shared_ptr<Buffer>		m_romData;
 		std::string					m_title;
 		CartridgeType::Type			m_cartridgeType;
 		HardwareType::Type			m_hardwareType;
@@ -0,0 +1,280 @@
+#include "serial.h"
+#include "cpu.h"
+#include "mmu.h"
+#include <thread>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		static const Byte kTransferStart	= 0x80;
+		static const Byte kFastClock		= 0x02;
+		static const Byte kInternalClock	= 0x01;
+
+		// CPU cycles per bit, at 8192Hz or 262144Hz in single speed. The
+		// serial clock doubles with the CPU.
+		static const uint64_t kBitCycles		= 512;
+		static const uint64_t kFastBitCycles	= 16;
+	}
+
+	//--------------------------------------------------------------------------
+
+	Serial::Serial()
+		: m_cpu(nullptr)
+		, m_mmu(nullptr)
+		, m_bFastClock(false)
+		, m_transferEnd(kNever)
+		, m_nextSync(kNever)
+		, m_waitStart(0)
+		, m_side(0)
+		, m_handledEnd(0)
+	{
+	}
+
+	Serial::~Serial()
+	{
+		disconnect();
+	}
+
+	void Serial::initialise(CPU* cpu, MMU* mmu)
+	{
+		m_cpu = cpu;
+		m_mmu = mmu;
+	}
+
+	void Serial::fork(const Serial& parent)
+	{
+		disconnect();
+
+		m_bFastClock	= parent.m_bFastClock;
+		m_transferEnd	= parent.m_transferEnd;
+		m_nextSync		= parent.m_transferEnd;
+		m_waitStart		= parent.m_waitStart;
+	}
+
+	void Serial::reset(bool bFastClock)
+	{
+		disconnect();
+
+		m_bFastClock	= bFastClock;
+		m_transferEnd	= kNever;
+		m_nextSync		= kNever;
+		m_waitStart		= 0;
+	}
+
+	void Serial::connect(Serial& a, Serial& b)
+	{
+		a.disconnect();
+		b.disconnect();
+
+		std::shared_ptr<SerialLink> link = std::make_shared<SerialLink>();
+		Serial* sides[2] = { &a, &b };
+
+		for(uint32_t side = 0; side < 2; side++)
+		{
+			Serial& serial = *sides[side];
+			SerialLink::Port& port = link->ports[side];
+			const uint64_t clock = serial.m_cpu->get_clock();
+
+			port.time			= 0;
+			port.transferEnd	= SerialLink::kNever;
+			port.reply			= SerialLink::kNoReply;
+			port.transferData	= 0xFF;
+			port.clockOffset	= clock;
+			port.minDuration	= serial.get_min_duration();
+
+			// A transfer already running completes unanswered.
+			if(serial.m_transferEnd != kNever)
+			{
+				port.transferEnd	= serial.m_transferEnd - clock;
+				port.reply			= 0xFF;
+			}
+
+			serial.m_link		= link;
+			serial.m_side		= side;
+			serial.m_handledEnd	= 0;
+			serial.m_nextSync	= clock;
+		}
+
+		link->bConnected = true;
+	}
+
+	void Serial::disconnect()
+	{
+		if(!m_link)
+			return;
+
+		m_link->bConnected.store(false, std::memory_order_release);
+		m_link.reset();
+		m_nextSync = m_transferEnd;
+	}
+
+	uint64_t Serial::get_ticks_to_event(uint64_t clock) const
+	{
+		if(m_nextSync == kNever)
+			return ~0ull;
+
+		return (m_nextSync > clock) ? (m_nextSync - clock) : 0;
+	}
+
+	void Serial::set_control(Byte value)
+	{
+		const uint64_t clock = m_cpu->get_clock();
+
+		// Clearing the start bit doesn't stop a transfer once it is under way.
+		if(((value & (kTransferStart | kInternalClock)) == (kTransferStart | kInternalClock)) && (m_transferEnd == kNever))
+		{
+			m_transferEnd = clock + get_duration(m_bFastClock && (value & kFastClock));
+
+			if(m_link)
+			{
+				SerialLink::Port& port = m_link->ports[m_side];
+				port.transferData = m_mmu->read_io(HWRegs::SB);
+				port.reply.store(SerialLink::kNoReply, std::memory_order_relaxed);
+				port.transferEnd.store(m_transferEnd - port.clockOffset, std::memory_order_release);
+			}
+		}
+
+		// Waiting on an external clock bounds how far ahead this side can run,
+		// which is checked at the next instruction boundary.
+		if(is_waiting())
+			m_waitStart = clock;
+
+		m_nextSync = clock;
+	}
+
+	//--------------------------------------------------------------------------
+
+	void Serial::sync(uint64_t clock)
+	{
+		if(m_link && !m_link->bConnected.load(std::memory_order_acquire))
+			disconnect();
+
+		if(!m_link)
+		{
+			// Nothing is connected, the other side never replies.
+			if(clock >= m_transferEnd)
+				complete(0xFF);
+
+			schedule(clock);
+			return;
+		}
+
+		SerialLink::Port& own	= m_link->ports[m_side];
+		SerialLink::Port& other	= m_link->ports[m_side ^ 1];
+		const uint64_t now		= clock - own.clockOffset;
+
+		own.time.store(now, std::memory_order_release);
+
+		// Any transfer the other side starts from the time it has published on
+		// ends at least its shortest transfer later, until then there is
+		// nothing this side can miss.
+		while(is_waiting() && (now >= (other.time.load(std::memory_order_acquire) + other.minDuration)))
+		{
+			if(!m_link->bConnected.load(std::memory_order_acquire))
+				break;
+
+			receive(now);
+			std::this_thread::yield();
+		}
+
+		receive(now);
+
+		if(clock >= m_transferEnd)
+		{
+			uint32_t reply = own.reply.load(std::memory_order_acquire);
+
+			while((reply == SerialLink::kNoReply) && m_link->bConnected.load(std::memory_order_acquire))
+			{
+				receive(now);
+				std::this_thread::yield();
+				reply = own.reply.load(std::memory_order_acquire);
+			}
+
+			own.transferEnd.store(SerialLink::kNever, std::memory_order_relaxed);
+			complete((reply == SerialLink::kNoReply) ? 0xFF : static_cast<Byte>(reply));
+		}
+
+		schedule(clock);
+	}
+
+	void Serial::receive(uint64_t now)
+	{
+		SerialLink::Port& own	= m_link->ports[m_side];
+		SerialLink::Port& other	= m_link->ports[m_side ^ 1];
+		const uint64_t end		= other.transferEnd.load(std::memory_order_acquire);
+
+		if((end == SerialLink::kNever) || (end <= m_handledEnd) || (end > now))
+			return;
+
+		m_handledEnd = end;
+
+		// A side waiting on the external clock can't run past the end of a
+		// transfer without seeing it, one seen late ended before the wait began
+		// and this side wasn't listening.
+		Byte reply = 0xFF;
+
+		if(is_waiting() && ((end + own.clockOffset) >= m_waitStart))
+		{
+			reply = m_mmu->read_io(HWRegs::SB);
+			complete(other.transferData);
+		}
+
+		other.reply.store(reply, std::memory_order_release);
+	}
+
+	void Serial::complete(Byte received)
+	{
+		m_transferEnd = kNever;
+
+		m_mmu->write_io(HWRegs::SB, received);
+		m_mmu->write_io(HWRegs::SC, m_mmu->read_io(HWRegs::SC) & ~kTransferStart);
+		m_cpu->generate_interrupt(HWInterrupts::Serial);
+	}
+
+	void Serial::schedule(uint64_t clock)
+	{
+		m_nextSync = m_transferEnd;
+
+		if(!m_link)
+			return;
+
+		SerialLink::Port& own	= m_link->ports[m_side];
+		SerialLink::Port& other	= m_link->ports[m_side ^ 1];
+
+		// Publish often enough that a waiting side is rarely held up, and pick
+		// up transfers the other side starts.
+		uint64_t next = clock + std::max<uint64_t>(own.minDuration / 2, 1);
+
+		if(is_waiting())
+			next = std::min(next, other.time.load(std::memory_order_relaxed) + other.minDuration + own.clockOffset);
+
+		const uint64_t end = other.transferEnd.load(std::memory_order_acquire);
+
+		if((end != SerialLink::kNever) && (end > m_handledEnd))
+			next = std::min(next, end + own.clockOffset);
+
+		m_nextSync = std::min(m_nextSync, std::max(next, clock + 1));
+	}
+
+	bool Serial::is_waiting() const
+	{
+		return (m_mmu->read_io(HWRegs::SC) & (kTransferStart | kInternalClock)) == kTransferStart;
+	}
+
+	uint64_t Serial::get_duration(bool bFast) const
+	{
+		const uint64_t cycles = 8 * (bFast ? kFastBitCycles : kBitCycles);
+		return cycles << (CPU::kClockShift - m_cpu->get_speed());
+	}
+
+	uint64_t Serial::get_min_duration() const
+	{
+		// Double speed halves the duration in master clock ticks.
+		return (8 * (m_bFastClock ? kFastBitCycles : kBitCycles)) << (CPU::kClockShift - 1);
+	}
+
+	//--------------------------------------------------------------------------
+}
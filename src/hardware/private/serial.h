@@ -0,0 +1,110 @@
+#pragma once
+
+#include "types.h"
+#include <atomic>
+#include <memory>
+
+namespace gbhw
+{
+	class CPU;
+	class MMU;
+
+	//--------------------------------------------------------------------------
+
+	// Link cable state shared by the two connected serial ports. Times are in
+	// master clock ticks since the ports were connected. Each side writes its
+	// own port, except for the reply, which the other side writes.
+	struct SerialLink
+	{
+		static const uint64_t kNever	= ~0ull;
+		static const uint32_t kNoReply	= ~0u;
+
+		struct Port
+		{
+			std::atomic<uint64_t>	time;				// Time the side has run to.
+			uint8_t					padding[56];		// Keeps the times on their own cache lines.
+			std::atomic<uint64_t>	transferEnd;		// Time the side's transfer completes, kNever if none.
+			std::atomic<uint32_t>	reply;				// Other side's byte for the transfer, kNoReply until sent.
+			Byte					transferData;		// Written before transferEnd.
+			uint64_t				clockOffset;		// Side's clock when connected.
+			uint64_t				minDuration;		// Shortest transfer the side can start.
+		};
+
+		Port					ports[2];
+		std::atomic<bool>		bConnected;
+	};
+
+	// Serial port, SB and SC, optionally connected to another context's port.
+	//
+	// The side driving the clock starts a transfer and the byte is exchanged
+	// when the transfer completes. A transfer can only affect the other side
+	// if that side is waiting on an external clock transfer, so connected
+	// sides run independently except for two rules:
+	//
+	// - A side waiting on an external clock stays less than one transfer
+	//   duration ahead of the other side, so it can't run past the end of a
+	//   transfer it hasn't seen started.
+	// - A side completing its transfer waits at the transfer end for the other
+	//   side to reach it and reply.
+	//
+	// The exchange happens at the first instruction boundary at or after the
+	// transfer end on both sides, whichever thread gets there first, and the
+	// results don't depend on how the two sides are scheduled. A side that
+	// isn't waiting on a transfer replies 0xFF and is otherwise unaffected.
+	class Serial
+	{
+	public:
+		Serial();
+		~Serial();
+
+		void initialise(CPU* cpu, MMU* mmu);
+		void fork(const Serial& parent);		// The fork is left unconnected.
+		void reset(bool bFastClock);			// bFastClock enables the CGB SC speed bit.
+
+		// Neither side may be running. Either side may disconnect while the
+		// other runs, the other carries on unconnected.
+		static void connect(Serial& a, Serial& b);
+		void disconnect();
+
+		// Called at every instruction boundary, may wait for the other side.
+		inline void update(uint64_t clock);
+
+		// Master clock ticks until update needs to run, ~0 if never.
+		uint64_t get_ticks_to_event(uint64_t clock) const;
+
+		// SC written by the CPU.
+		void set_control(Byte value);
+
+	private:
+		static const uint64_t kNever = ~0ull;
+
+		void sync(uint64_t clock);
+		void receive(uint64_t now);
+		void complete(Byte received);
+		void schedule(uint64_t clock);
+		bool is_waiting() const;
+		uint64_t get_duration(bool bFast) const;
+		uint64_t get_min_duration() const;
+
+		CPU*						m_cpu;
+		MMU*						m_mmu;
+		bool						m_bFastClock;
+		uint64_t					m_transferEnd;		// Local clock, kNever unless this side drives a transfer.
+		uint64_t					m_nextSync;			// Local clock update next has work to do on.
+		uint64_t					m_waitStart;		// Local clock the last external clock wait began.
+
+		std::shared_ptr<SerialLink>	m_link;
+		uint32_t					m_side;
+		uint64_t					m_handledEnd;		// Last of the other side's transfers replied to.
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline void Serial::update(uint64_t clock)
+	{
+		if(clock >= m_nextSync)
+			sync(clock);
+	}
+
+	//--------------------------------------------------------------------------
+}
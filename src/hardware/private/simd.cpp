@@ -0,0 +1,81 @@
+#include "simd.h"
+#include <atomic>
+
+#if HWSimdX86 && defined(MSVC)
+#include <intrin.h>
+#endif
+
+namespace gbhw
+{
+	namespace simd
+	{
+		//----------------------------------------------------------------------
+
+		namespace
+		{
+			Level::Type detect_level()
+			{
+#if HWSimdX86 && defined(MSVC)
+				int info[4];
+				__cpuid(info, 0);
+				const int maxLeaf = info[0];
+
+				__cpuid(info, 1);
+				const bool bSSE2	= (info[3] & (1 << 26)) != 0;
+				const bool bSSSE3	= (info[2] & (1 << 9)) != 0;
+				const bool bOSXSave	= (info[2] & (1 << 27)) != 0;
+				bool bAVX2			= false;
+
+				// AVX state must also be enabled by the OS.
+				if(maxLeaf >= 7 && bOSXSave && ((_xgetbv(0) & 0x6) == 0x6))
+				{
+					__cpuidex(info, 7, 0);
+					bAVX2 = (info[1] & (1 << 5)) != 0;
+				}
+
+				if(bAVX2)
+					return Level::AVX2;
+
+				if(bSSSE3)
+					return Level::SSSE3;
+
+				return bSSE2 ? Level::SSE2 : Level::Scalar;
+#elif HWSimdX86
+				__builtin_cpu_init();
+
+				if(__builtin_cpu_supports("avx2"))
+					return Level::AVX2;
+
+				if(__builtin_cpu_supports("ssse3"))
+					return Level::SSSE3;
+
+				if(__builtin_cpu_supports("sse2"))
+					return Level::SSE2;
+
+				return Level::Scalar;
+#elif HWSimdWasm
+				return Level::Simd128;
+#else
+				return Level::Scalar;
+#endif
+			}
+
+			const Level::Type kSupportedLevel = detect_level();
+			std::atomic<int> g_level(kSupportedLevel);
+		}
+
+		//----------------------------------------------------------------------
+
+		Level::Type get_level()
+		{
+			return static_cast<Level::Type>(g_level.load(std::memory_order_relaxed));
+		}
+
+		void set_level(Level::Type level)
+		{
+			g_level.store(level < kSupportedLevel ? level : kSupportedLevel, std::memory_order_relaxed);
+		}
+
+		//----------------------------------------------------------------------
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "types.h"
+
+// Vector paths are compiled per function with target attributes and selected
+// at runtime, so the library itself keeps building for the baseline ISA.
+// WebAssembly has no per function targets, modules built with -msimd128 only
+// load where it is supported, so those paths are enabled at compile time.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define HWSimdX86 1
+	#define HWSimdWasm 0
+
+	#ifdef MSVC
+		#define HWTargetSSE2
+		#define HWTargetSSSE3
+		#define HWTargetAVX2
+	#else
+		#define HWTargetSSE2	__attribute__((target("sse2")))
+		#define HWTargetSSSE3	__attribute__((target("ssse3")))
+		#define HWTargetAVX2	__attribute__((target("avx2")))
+	#endif
+#elif defined(__wasm_simd128__)
+	#define HWSimdX86 0
+	#define HWSimdWasm 1
+#else
+	#define HWSimdX86 0
+	#define HWSimdWasm 0
+#endif
+
+namespace gbhw
+{
+	namespace simd
+	{
+		//----------------------------------------------------------------------
+
+		struct Level
+		{
+			enum Type
+			{
+				Scalar = 0,
+				SSE2,
+				SSSE3,
+				AVX2,
+				Simd128		// WebAssembly, never supported alongside the x86 levels.
+			};
+		};
+
+		// Level used by vector paths, defaults to the highest supported by both
+		// the CPU and the OS.
+		Level::Type get_level();
+
+		// Lowers the level, for benchmarking and testing the narrower paths.
+		// Levels above what is supported are clamped.
+		void set_level(Level::Type level);
+
+		//----------------------------------------------------------------------
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "types.h"
+#include <atomic>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Bounded, lock-free, single-producer/single-consumer queue. The producer
+	// is always the emulation thread, the consumer is a background worker.
+	// Capacity is rounded up to a power of two so indices can be masked.
+	template<typename T>
+	class SPSCQueue
+	{
+	public:
+		inline SPSCQueue(uint32_t capacity = 1024);
+
+		inline bool push(const T& item);
+		inline bool pop(T& item);
+		inline bool empty() const;
+
+		// Direct slot access, lets large items be filled or consumed in place
+		// rather than copied through push/pop.
+		inline T* acquire_write();
+		inline void commit_write();
+		inline T* acquire_read();
+		inline void commit_read();
+
+	private:
+		// Padding keeps the producer and consumer indices on separate cache
+		// lines, alignas would require aligned new which C++11 lacks.
+		static const uint32_t kCacheLineSize = 64;
+
+		std::vector<T>			m_items;
+		uint32_t				m_mask;
+		uint8_t					m_pad0[kCacheLineSize];
+		std::atomic<uint32_t>	m_head;		// Written by producer.
+		uint8_t					m_pad1[kCacheLineSize - sizeof(std::atomic<uint32_t>)];
+		std::atomic<uint32_t>	m_tail;		// Written by consumer.
+		uint8_t					m_pad2[kCacheLineSize - sizeof(std::atomic<uint32_t>)];
+	};
+
+	//--------------------------------------------------------------------------
+
+	template<typename T>
+	inline SPSCQueue<T>::SPSCQueue(uint32_t capacity)
+		: m_head(0)
+		, m_tail(0)
+	{
+		uint32_t size = 2;
+
+		while(size < capacity)
+			size <<= 1;
+
+		m_items.resize(size);
+		m_mask = size - 1;
+	}
+
+	template<typename T>
+	inline bool SPSCQueue<T>::push(const T& item)
+	{
+		T* slot = acquire_write();
+
+		if(!slot)
+			return false;
+
+		*slot = item;
+		commit_write();
+		return true;
+	}
+
+	template<typename T>
+	inline bool SPSCQueue<T>::pop(T& item)
+	{
+		T* slot = acquire_read();
+
+		if(!slot)
+			return false;
+
+		item = *slot;
+		commit_read();
+		return true;
+	}
+
+	template<typename T>
+	inline bool SPSCQueue<T>::empty() const
+	{
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+	template<typename T>
+	inline T* SPSCQueue<T>::acquire_write()
+	{
+		const uint32_t head = m_head.load(std::memory_order_relaxed);
+
+		if((head - m_tail.load(std::memory_order_acquire)) > m_mask)
+			return nullptr;	// Full.
+
+		return &m_items[head & m_mask];
+	}
+
+	template<typename T>
+	inline void SPSCQueue<T>::commit_write()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	template<typename T>
+	inline T* SPSCQueue<T>::acquire_read()
+	{
+		const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if(tail == m_head.load(std::memory_order_acquire))
+			return nullptr;	// Empty.
+
+		return &m_items[tail & m_mask];
+	}
+
+	template<typename T>
+	inline void SPSCQueue<T>::commit_read()
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	//--------------------------------------------------------------------------
+}
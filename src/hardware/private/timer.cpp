@@ -6,60 +6,133 @@ namespace gbhw
 	namespace
 	{
 		static const uint32_t kTimaPeriods[] = { 1024, 16, 64, 256 };
+		static const uint32_t kDivShift = 8;		// DIV increments every 256 cycles.
+		static const Byte kTimerEnabled = 0x04;
 	}
 
 	Timer::Timer()
+		: m_cpu(nullptr)
+		, m_mmu(nullptr)
 	{
-		reset();
+		m_divBase		= 0;
+		m_timaBase		= 0;
+		m_tima			= 0;
+		m_tac			= 0;
+		m_overflowCycle	= kNever;
 	}
 
 	void Timer::initialise(CPU* cpu, MMU* mmu)
 	{
 		m_cpu = cpu;
 		m_mmu = mmu;
+
+		reset();
 	}
 
-	void Timer::update(uint32_t cycles)
+	void Timer::fork(const Timer& parent)
 	{
-		const uint32_t timaPeriod = kTimaPeriods[m_mmu->read_io(HWRegs::TAC) & 0x03];
+		m_divBase		= parent.m_divBase;
+		m_timaBase		= parent.m_timaBase;
+		m_tima			= parent.m_tima;
+		m_tac			= parent.m_tac;
+		m_overflowCycle	= parent.m_overflowCycle;
+	}
 
-		if(m_mmu->read_io(HWRegs::TAC) & (0x2))	// Bit 2 is timer enabled.
-		{
-			m_tima += cycles;
-
-			while(m_tima >= timaPeriod)
-			{
-				// Increment tima once for the period.
-				Byte newTima = m_mmu->read_io(HWRegs::TIMA) + 1;
-				m_mmu->write_io(HWRegs::TIMA, newTima);
-
-				// Wrapped around/overflowed.
-				if(newTima == 0)
-				{
-					m_mmu->write_io(HWRegs::TIMA, m_mmu->read_io(HWRegs::TMA));	// Reset tima.
-					m_cpu->generate_interrupt(HWInterrupts::Timer);				// Generate an interrupt.
-				}
-
-				m_tima -= timaPeriod;
-			}
-		}
-		else
+	void Timer::reset()
+	{
+		m_divBase		= m_cpu->get_cycles();
+		m_timaBase		= m_divBase;
+		m_tima			= 0;
+		m_tac			= 0;
+		m_overflowCycle	= kNever;
+	}
+
+	uint32_t Timer::get_cycles_to_interrupt() const
+	{
+		if(m_overflowCycle == kNever)
+			return ~0u;
+
+		const uint64_t cycles = m_cpu->get_cycles();
+		return (m_overflowCycle > cycles) ? static_cast<uint32_t>(m_overflowCycle - cycles) : 0;
+	}
+
+	Byte Timer::get_div() const
+	{
+		return static_cast<Byte>((m_cpu->get_cycles() - m_divBase) >> kDivShift);
+	}
+
+	Byte Timer::get_tima() const
+	{
+		if(!(m_tac & kTimerEnabled))
+			return m_tima;
+
+		// An overflow not yet handled reads as having wrapped.
+		return static_cast<Byte>(m_tima + (get_ticks(m_cpu->get_cycles()) - get_ticks(m_timaBase)));
+	}
+
+	void Timer::reset_div()
+	{
+		// TIMA ticks from the counter being reset, so bring it up to date first.
+		sync();
+		m_divBase	= m_cpu->get_cycles();
+		m_timaBase	= m_divBase;
+		schedule();
+	}
+
+	void Timer::set_tima(Byte value)
+	{
+		sync();
+		m_tima = value;
+		schedule();
+	}
+
+	void Timer::set_tac(Byte value)
+	{
+		sync();
+		m_tac = value;
+		schedule();
+	}
+
+	void Timer::overflow(uint64_t cycles)
+	{
+		// The CPU runs whole instructions, so more than one period may have
+		// passed since the overflow. Restart TIMA from TMA at the overflow and
+		// let the remaining ticks count from there.
+		while(cycles >= m_overflowCycle)
 		{
-			m_tima = 0;
+			m_timaBase	= m_overflowCycle;
+			m_tima		= m_mmu->read_io(HWRegs::TMA);
+
+			m_cpu->generate_interrupt(HWInterrupts::Timer);
+			schedule();
 		}
+	}
+
+	void Timer::sync()
+	{
+		const uint64_t cycles = m_cpu->get_cycles();
 
-		m_divt += cycles;
+		m_tima		= get_tima();
+		m_timaBase	= cycles;
+	}
 
-		while(m_divt >= 64)
+	void Timer::schedule()
+	{
+		if(!(m_tac & kTimerEnabled))
 		{
-			m_mmu->write_io(HWRegs::DIV, m_mmu->read_io(HWRegs::DIV) + 1);
-			m_divt -= 64;
+			m_overflowCycle = kNever;
+			return;
 		}
+
+		// Overflow happens on the tick that takes TIMA past 0xFF.
+		const uint64_t period	= kTimaPeriods[m_tac & 0x03];
+		const uint64_t ticks	= get_ticks(m_timaBase) + (0x100 - m_tima);
+
+		m_overflowCycle = m_divBase + (ticks * period);
 	}
 
-	void Timer::reset()
+	uint64_t Timer::get_ticks(uint64_t cycles) const
 	{
-		m_tima = 0;
-		m_divt = 0;
+		return (cycles - m_divBase) / kTimaPeriods[m_tac & 0x03];
 	}
-}
\ No newline at end of file
+}
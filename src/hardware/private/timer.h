@@ -7,20 +7,54 @@ namespace gbhw
 	class CPU;
 	class MMU;
 
+	// DIV and TIMA are derived from the CPU's cycle count when they are read,
+	// rather than counted as the CPU runs. Both tick from the same internal
+	// counter DIV exposes the top byte of, and the only scheduled work is the
+	// TIMA overflow, which exists while TAC has the timer enabled.
 	class Timer
 	{
 	public:
 		Timer();
 
 		void initialise(CPU* cpu, MMU* mmu);
-		void update(uint32_t cycles);
+		void fork(const Timer& parent);
+		void reset();
+
+		// Raises the timer interrupt once the overflow cycle is reached.
+		inline void update(uint64_t cycles);
+
+		// CPU cycles until TIMA overflows, ~0 if the timer is stopped.
+		uint32_t get_cycles_to_interrupt() const;
+
+		// Register access for the MMU.
+		Byte get_div() const;
+		Byte get_tima() const;
+		void reset_div();
+		void set_tima(Byte value);
+		void set_tac(Byte value);
 
 	private:
-		void reset();
+		static const uint64_t kNever = ~0ull;
+
+		void overflow(uint64_t cycles);
+		void sync();
+		void schedule();
+		uint64_t get_ticks(uint64_t cycles) const;
 
 		CPU*		m_cpu;
 		MMU*		m_mmu;
-		uint32_t	m_tima;
-		uint32_t	m_divt;
+		uint64_t	m_divBase;			// Cycle the internal counter was last reset on.
+		uint64_t	m_timaBase;			// Cycle m_tima was last brought up to date on.
+		Byte		m_tima;
+		Byte		m_tac;
+		uint64_t	m_overflowCycle;	// kNever while the timer is stopped.
 	};
-}
\ No newline at end of file
+
+	//--------------------------------------------------------------------------
+
+	inline void Timer::update(uint64_t cycles)
+	{
+		if(cycles >= m_overflowCycle)
+			overflow(cycles);
+	}
+}
@@ -0,0 +1,315 @@
+#include "trace.h"
+#include "log.h"
+#include <chrono>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	namespace
+	{
+		static const char kTraceMagic[4] = { 'G', 'B', 'T', 'R' };
+
+		inline void put_word(Buffer& buffer, Word word)
+		{
+			buffer.push_back(static_cast<Byte>(word & 0xFF));
+			buffer.push_back(static_cast<Byte>(word >> 8));
+		}
+
+		inline Byte* put_word(Byte* out, Word word)
+		{
+			*out++ = static_cast<Byte>(word & 0xFF);
+			*out++ = static_cast<Byte>(word >> 8);
+			return out;
+		}
+
+		inline Byte* put_varint(Byte* out, uint64_t value)
+		{
+			while(value >= 0x80)
+			{
+				*out++ = static_cast<Byte>(value | 0x80);
+				value >>= 7;
+			}
+
+			*out++ = static_cast<Byte>(value);
+			return out;
+		}
+
+		inline uint64_t zigzag_encode(int32_t value)
+		{
+			return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+		}
+
+		inline int32_t zigzag_decode(uint64_t value)
+		{
+			const uint32_t v = static_cast<uint32_t>(value);
+			return static_cast<int32_t>((v >> 1) ^ (~(v & 1) + 1));
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// TraceWriter
+	//--------------------------------------------------------------------------
+
+	TraceWriter::TraceWriter()
+		: m_queue(kQueueSize)
+		, m_bRunning(false)
+		, m_file(nullptr)
+	{
+		memset(&m_previous, 0, sizeof(m_previous));
+	}
+
+	TraceWriter::~TraceWriter()
+	{
+		close();
+	}
+
+	bool TraceWriter::open(const char* path)
+	{
+		close();
+
+		m_file = fopen(path, "wb");
+
+		if(!m_file)
+		{
+			log_error("Failed to open trace file '%s'\n", path);
+			return false;
+		}
+
+		m_buffer.clear();
+		m_buffer.reserve(kFlushSize * 2);
+
+		for(char c : kTraceMagic)
+			m_buffer.push_back(static_cast<Byte>(c));
+
+		put_word(m_buffer, static_cast<Word>(kTraceVersion & 0xFFFF));
+		put_word(m_buffer, static_cast<Word>(kTraceVersion >> 16));
+		memset(&m_previous, 0, sizeof(m_previous));
+
+		m_bRunning = true;
+		m_thread = std::thread(&TraceWriter::drain, this);
+		return true;
+	}
+
+	void TraceWriter::close()
+	{
+		if(!m_file)
+			return;
+
+		m_bRunning = false;
+
+		if(m_thread.joinable())
+			m_thread.join();
+
+		flush();
+		fclose(m_file);
+		m_file = nullptr;
+	}
+
+	void TraceWriter::drain()
+	{
+		while(true)
+		{
+			// Sample the running flag before draining so records committed
+			// prior to close() are always written out.
+			const bool bRunning = m_bRunning;
+			TraceRecord* record = m_queue.acquire_read();
+
+			if(record)
+			{
+				encode(*record);
+				m_queue.commit_read();
+
+				if(m_buffer.size() >= kFlushSize)
+					flush();
+			}
+			else if(bRunning)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	void TraceWriter::encode(const TraceRecord& record)
+	{
+		const TraceRecord& prev = m_previous;
+		Byte mask = 0;
+
+		if(record.pc != prev.pc)									mask |= TraceField::PC;
+		if(record.bank != prev.bank)								mask |= TraceField::Bank;
+		if(record.af != prev.af)									mask |= TraceField::AF;
+		if(record.bc != prev.bc)									mask |= TraceField::BC;
+		if(record.de != prev.de)									mask |= TraceField::DE;
+		if(record.hl != prev.hl)									mask |= TraceField::HL;
+		if(record.sp != prev.sp)									mask |= TraceField::SP;
+		if(memcmp(&record.mem[1], &prev.mem[1], 3) != 0)			mask |= TraceField::Mem;
+
+		// Encode straight into the tail of the buffer, a record is bounded by
+		// kMaxRecordSize so only a single resize is needed.
+		const size_t offset = m_buffer.size();
+		m_buffer.resize(offset + kMaxRecordSize);
+
+		Byte* out = &m_buffer[offset];
+		*out++ = mask;
+		*out++ = record.mem[0];
+		out = put_varint(out, record.cycle - prev.cycle);
+
+		if(mask & TraceField::PC)	out = put_varint(out, zigzag_encode(static_cast<int32_t>(record.pc) - static_cast<int32_t>(prev.pc)));
+		if(mask & TraceField::Bank)	out = put_word(out, record.bank);
+		if(mask & TraceField::AF)	out = put_word(out, record.af);
+		if(mask & TraceField::BC)	out = put_word(out, record.bc);
+		if(mask & TraceField::DE)	out = put_word(out, record.de);
+		if(mask & TraceField::HL)	out = put_word(out, record.hl);
+		if(mask & TraceField::SP)	out = put_word(out, record.sp);
+
+		if(mask & TraceField::Mem)
+		{
+			*out++ = record.mem[1];
+			*out++ = record.mem[2];
+			*out++ = record.mem[3];
+		}
+
+		m_buffer.resize(out - &m_buffer[0]);
+		m_previous = record;
+	}
+
+	void TraceWriter::flush()
+	{
+		if(!m_buffer.empty())
+		{
+			fwrite(&m_buffer[0], 1, m_buffer.size(), m_file);
+			m_buffer.clear();
+		}
+	}
+
+	//--------------------------------------------------------------------------
+	// TraceReader
+	//--------------------------------------------------------------------------
+
+	TraceReader::TraceReader()
+		: m_file(nullptr)
+	{
+		memset(&m_previous, 0, sizeof(m_previous));
+	}
+
+	TraceReader::~TraceReader()
+	{
+		close();
+	}
+
+	bool TraceReader::open(const char* path)
+	{
+		close();
+
+		m_file = fopen(path, "rb");
+
+		if(!m_file)
+			return false;
+
+		char magic[4];
+		Word versionLow = 0, versionHigh = 0;
+
+		if((fread(magic, 1, sizeof(magic), m_file) != sizeof(magic)) || (memcmp(magic, kTraceMagic, sizeof(magic)) != 0) ||
+		   !read_word(versionLow) || !read_word(versionHigh) || ((static_cast<uint32_t>(versionHigh) << 16 | versionLow) != kTraceVersion))
+		{
+			close();
+			return false;
+		}
+
+		memset(&m_previous, 0, sizeof(m_previous));
+		return true;
+	}
+
+	void TraceReader::close()
+	{
+		if(m_file)
+		{
+			fclose(m_file);
+			m_file = nullptr;
+		}
+	}
+
+	bool TraceReader::read(TraceRecord& record)
+	{
+		if(!m_file)
+			return false;
+
+		Byte mask = 0;
+		uint64_t value = 0;
+
+		record = m_previous;
+
+		if(!read_byte(mask) || !read_byte(record.mem[0]) || !read_varint(value))
+			return false;
+
+		record.cycle += value;
+
+		if(mask & TraceField::PC)
+		{
+			if(!read_varint(value))
+				return false;
+
+			record.pc = static_cast<Word>(static_cast<int32_t>(record.pc) + zigzag_decode(value));
+		}
+
+		if((mask & TraceField::Bank) && !read_word(record.bank))	return false;
+		if((mask & TraceField::AF) && !read_word(record.af))		return false;
+		if((mask & TraceField::BC) && !read_word(record.bc))		return false;
+		if((mask & TraceField::DE) && !read_word(record.de))		return false;
+		if((mask & TraceField::HL) && !read_word(record.hl))		return false;
+		if((mask & TraceField::SP) && !read_word(record.sp))		return false;
+
+		if((mask & TraceField::Mem) && (fread(&record.mem[1], 1, 3, m_file) != 3))
+			return false;
+
+		m_previous = record;
+		return true;
+	}
+
+	bool TraceReader::read_byte(Byte& byte)
+	{
+		const int c = fgetc(m_file);
+
+		if(c == EOF)
+			return false;
+
+		byte = static_cast<Byte>(c);
+		return true;
+	}
+
+	bool TraceReader::read_word(Word& word)
+	{
+		Byte low, high;
+
+		if(!read_byte(low) || !read_byte(high))
+			return false;
+
+		word = static_cast<Word>(low | (high << 8));
+		return true;
+	}
+
+	bool TraceReader::read_varint(uint64_t& value)
+	{
+		Byte byte = 0;
+		uint32_t shift = 0;
+
+		value = 0;
+
+		do
+		{
+			if(!read_byte(byte) || shift > 63)
+				return false;
+
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			shift += 7;
+		} while(byte & 0x80);
+
+		return true;
+	}
+
+	//--------------------------------------------------------------------------
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "gbhw.h"
+#include "spsc_queue.h"
+#include "types.h"
+#include <atomic>
+#include <thread>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// A single executed instruction, captured before the instruction runs so
+	// the registers describe the state the opcode observed.
+	using TraceRecord = gbhw_trace_record_t;
+
+	// Trace file layout:
+	//
+	// Header	- "GBTR", uint32 version.
+	// Record	- uint8 mask of fields that changed relative to the previous
+	//			  record (TraceField), uint8 opcode, varint cycle delta, then
+	//			  each changed field in TraceField order. PC is stored as a
+	//			  zig-zag varint delta, the bank and registers as little
+	//			  endian words.
+	struct TraceField
+	{
+		enum Type
+		{
+			PC		= 0x01,
+			Bank	= 0x02,
+			AF		= 0x04,
+			BC		= 0x08,
+			DE		= 0x10,
+			HL		= 0x20,
+			SP		= 0x40,
+			Mem		= 0x80		// mem[1..3].
+		};
+	};
+
+	static const uint32_t kTraceVersion = 2;	// 2 widened the bank to a word.
+
+	//--------------------------------------------------------------------------
+
+	// Records are produced on the emulation thread into a lock-free ring and
+	// drained to disk by a background thread, which performs all encoding.
+	class TraceWriter
+	{
+	public:
+		TraceWriter();
+		~TraceWriter();
+
+		bool open(const char* path);
+		void close();
+
+		inline TraceRecord* acquire();
+		inline void commit();
+
+	private:
+		void drain();
+		void encode(const TraceRecord& record);
+		void flush();
+
+		static const uint32_t	kQueueSize		= 65536;
+		static const uint32_t	kFlushSize		= 65536;
+		static const uint32_t	kMaxRecordSize	= 40;	// mask, opcode, 2 varints, 6 words, mem.
+
+		SPSCQueue<TraceRecord>	m_queue;
+		std::thread				m_thread;
+		std::atomic<bool>		m_bRunning;
+		FILE*					m_file;
+		Buffer					m_buffer;
+		TraceRecord				m_previous;
+	};
+
+	//--------------------------------------------------------------------------
+
+	class TraceReader
+	{
+	public:
+		TraceReader();
+		~TraceReader();
+
+		bool open(const char* path);
+		void close();
+
+		bool read(TraceRecord& record);
+
+	private:
+		bool read_byte(Byte& byte);
+		bool read_word(Word& word);
+		bool read_varint(uint64_t& value);
+
+		FILE*					m_file;
+		TraceRecord				m_previous;
+	};
+
+	//--------------------------------------------------------------------------
+
+	inline TraceRecord* TraceWriter::acquire()
+	{
+		TraceRecord* record = m_queue.acquire_write();
+
+		// Never drop records, a trace with holes is useless for diffing. Wait
+		// on the drain thread instead.
+		while(!record)
+		{
+			std::this_thread::yield();
+			record = m_queue.acquire_write();
+		}
+
+		return record;
+	}
+
+	inline void TraceWriter::commit()
+	{
+		m_queue.commit_write();
+	}
+
+	//--------------------------------------------------------------------------
+}
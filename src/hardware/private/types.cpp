@@ -171,6 +171,22 @@ namespace gbhw
 		return "InterruptType - Error";
 	}
 
+	uint32_t HWInterrupts::get_index(Type interrupt)
+	{
+		switch (interrupt)
+		{
+			case HWInterrupts::VBlank:	return 0;
+			case HWInterrupts::Stat:	return 1;
+			case HWInterrupts::Timer:	return 2;
+			case HWInterrupts::Serial:	return 3;
+			case HWInterrupts::Button:	return 4;
+			default: break;
+		}
+
+		log_error("Can't determine interrupt index, unknown interrupt supplied: %u\n", static_cast<uint32_t>(interrupt));
+		return 0;
+	}
+
 	bool HWLCDC::bg_enabled(Byte lcdc)
 	{
 		return ((lcdc & BGEnabled) != 0);
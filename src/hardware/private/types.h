@@ -39,7 +39,7 @@ namespace gbhw
 
 	struct CartridgeType
 	{
-		enum Type
+		enum Type : uint32_t		// Fixed so any header byte is a valid value.
 		{
 			RomOnly = 0x00,
 			RomMBC1 = 0x01,
@@ -91,7 +91,7 @@ namespace gbhw
 
 	struct RomSize
 	{
-		enum Type
+		enum Type : uint32_t
 		{
 			Size_32kB = 0x00,
 			Size_64kB = 0x01,
@@ -113,7 +113,7 @@ namespace gbhw
 
 	struct RamSize
 	{
-		enum Type
+		enum Type : uint32_t
 		{
 			None = 0x00,
 			Size_2kB = 0x01,
@@ -130,7 +130,7 @@ namespace gbhw
 
 	struct DestinationCode
 	{
-		enum Type
+		enum Type : uint32_t
 		{
 			Japanese = 0x00,
 			NonJapanese = 0x01,
@@ -142,7 +142,7 @@ namespace gbhw
 
 	struct LicenseeCodeOld
 	{
-		enum Type
+		enum Type : uint32_t
 		{
 			CheckNew = 0x33,
 			Accolade = 0x79,
@@ -158,6 +158,8 @@ namespace gbhw
 		enum Type
 		{
 			P1		= 0xFF00,
+			SB		= 0xFF01,
+			SC		= 0xFF02,
 			DIV		= 0xFF04,
 			TIMA	= 0xFF05,
 			TMA		= 0xFF06,
@@ -202,7 +204,11 @@ namespace gbhw
 			Button = 0x10
 		};
 
+		static const uint32_t kCount = 5;
+		static const Byte kMask = 0x1F;
+
 		static const char* get_string(Type interrupt);
+		static uint32_t get_index(Type interrupt);
 	};
 
 	struct HWInterruptRoutines
@@ -0,0 +1,131 @@
+#include "worker_pool.h"
+#include "log.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	WorkerPool::WorkerPool()
+		: m_job(nullptr)
+		, m_generation(0)
+		, m_running(0)
+		, m_bStopping(false)
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bStopping = true;
+		}
+
+		m_startCv.notify_all();
+
+		for(std::thread& thread : m_threads)
+			thread.join();
+	}
+
+	void WorkerPool::initialise(uint32_t threads, bool bPinned)
+	{
+		const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+		if(threads == 0)
+			threads = cores;
+
+#if defined(EMSCRIPTEN) && !defined(__EMSCRIPTEN_PTHREADS__)
+		threads = 1;
+#endif
+
+		for(uint32_t worker = 1; worker < threads; worker++)
+		{
+			m_threads.push_back(std::thread(&WorkerPool::thread_main, this, worker));
+
+			if(bPinned)
+				pin(m_threads.back(), worker % cores);
+		}
+	}
+
+	uint32_t WorkerPool::get_worker_count() const
+	{
+		return static_cast<uint32_t>(m_threads.size()) + 1;
+	}
+
+	void WorkerPool::run(const Job& job)
+	{
+		if(!m_threads.empty())
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job		= &job;
+			m_running	= static_cast<uint32_t>(m_threads.size());
+			m_generation++;
+		}
+
+		m_startCv.notify_all();
+
+		job(0);
+
+		if(!m_threads.empty())
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_doneCv.wait(lock, [this] { return m_running == 0; });
+			m_job = nullptr;
+		}
+	}
+
+	//--------------------------------------------------------------------------
+
+	void WorkerPool::thread_main(uint32_t worker)
+	{
+		uint64_t generation = 0;
+
+		for(;;)
+		{
+			const Job* job;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_startCv.wait(lock, [&] { return m_bStopping || (m_generation != generation); });
+
+				if(m_bStopping)
+					return;
+
+				generation	= m_generation;
+				job			= m_job;
+			}
+
+			(*job)(worker);
+
+			bool bLast;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				bLast = (--m_running == 0);
+			}
+
+			if(bLast)
+				m_doneCv.notify_one();
+		}
+	}
+
+	void WorkerPool::pin(std::thread& thread, uint32_t core)
+	{
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core, &set);
+
+		if(pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) != 0)
+			log_warning("Failed to pin worker thread to core %u\n", core);
+#else
+		(void)thread;
+		(void)core;
+#endif
+	}
+
+	//--------------------------------------------------------------------------
+}
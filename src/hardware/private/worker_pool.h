@@ -0,0 +1,49 @@
+#pragma once
+
+#include "types.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace gbhw
+{
+	//--------------------------------------------------------------------------
+
+	// Fixed set of threads running the same job together, one call per worker.
+	// The calling thread is worker 0 so a pool of one never switches thread.
+	//
+	// Workers keep their index for the life of the pool, jobs that split their
+	// data by worker index touch the same data from the same thread every run.
+	// Pinned workers are bound to a core each where the platform allows it.
+	class WorkerPool
+	{
+	public:
+		typedef std::function<void(uint32_t worker)> Job;
+
+		WorkerPool();
+		~WorkerPool();
+
+		// 0 threads uses one per hardware thread.
+		void initialise(uint32_t threads, bool bPinned);
+		uint32_t get_worker_count() const;
+
+		// Returns once every worker has finished the job.
+		void run(const Job& job);
+
+	private:
+		void thread_main(uint32_t worker);
+		void pin(std::thread& thread, uint32_t core);
+
+		std::vector<std::thread>	m_threads;
+		std::mutex					m_mutex;
+		std::condition_variable		m_startCv;
+		std::condition_variable		m_doneCv;
+		const Job*					m_job;
+		uint64_t					m_generation;	// Bumped for each job.
+		uint32_t					m_running;		// Threads yet to finish the current job.
+		bool						m_bStopping;
+	};
+
+	//--------------------------------------------------------------------------
+}
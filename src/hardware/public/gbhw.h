@@ -25,6 +25,9 @@ extern "C" {
 /*----------------------------------------------------------------------------*/
 
 typedef struct gbhw_context *gbhw_context_t;
+typedef struct gbhw_batch *gbhw_batch_t;
+typedef struct gbhw_netplay *gbhw_netplay_t;
+typedef struct gbhw_loopback *gbhw_loopback_t;
 
 typedef enum gbhw_step_mode
 {
@@ -50,6 +53,26 @@ typedef enum gbhw_button_state
 	button_released
 } gbhw_button_state_t;
 
+typedef enum gbhw_screen_format
+{
+	format_rgb		= 0,							// 32-bit pixels, see gbhw_get_screen.
+	format_indexed									// 8-bit palette indices, see gbhw_get_screen_indexed.
+} gbhw_screen_format_t;
+
+typedef enum gbhw_scaler
+{
+	scaler_nearest_2x	= 0,
+	scaler_nearest_3x,
+	scaler_nearest_4x,
+	scaler_scale2x									// EPX edge smoothing, output is 2x.
+} gbhw_scaler_t;
+
+typedef enum gbhw_capture_mode
+{
+	capture_drop	= 0,							// Drop frames the compressor is behind on, for interactive use.
+	capture_wait									// Stall emulation until the compressor catches up, for offline recording.
+} gbhw_capture_mode_t;
+
 typedef enum gbhw_errorcode
 {
 	e_success		= 0,
@@ -77,24 +100,318 @@ typedef struct gbhw_settings
 	void*				log_userdata;
 } gbhw_settings_t;
 
+typedef struct gbhw_batch_settings
+{
+	uint32_t			count;						// Contexts in the batch.
+	uint32_t			threads;					// Threads stepping the batch including the caller, 0 for one per hardware thread.
+	uint32_t			pin_threads;				// Non-zero binds each worker thread to its own core where supported.
+} gbhw_batch_settings_t;
+
+// Carries netplay packets between the two peers, neither call may block.
+// Packets may be lost, duplicated or reordered. receive copies the next
+// packet waiting into data and returns its size, 0 if there is none.
+typedef struct gbhw_netplay_transport
+{
+	void*				userdata;
+	void				(*send)(void* userdata, const uint8_t* data, uint32_t size);
+	uint32_t			(*receive)(void* userdata, uint8_t* data, uint32_t capacity);
+} gbhw_netplay_transport_t;
+
+typedef struct gbhw_netplay_settings
+{
+	uint32_t			player;						// This peer's player, 0 or 1.
+	uint32_t			input_delay;				// Frames local input is held back for, at most 16.
+	uint32_t			max_rollback;				// Frames to run ahead of the remote input, 0 for 8, at most 16.
+	gbhw_netplay_transport_t	transport;
+} gbhw_netplay_settings_t;
+
+typedef struct gbhw_netplay_stats
+{
+	uint32_t			frame;						// Frames emulated.
+	uint32_t			confirmed_frames;			// Leading frames emulated with both players' input known.
+	uint32_t			stalls;						// Advances that waited for the remote peer.
+	uint32_t			rollbacks;					// Mispredictions corrected.
+	uint32_t			rollback_frames;			// Frames emulated again by all rollbacks.
+	uint32_t			max_rollback_frames;		// Most frames emulated again by one rollback.
+	uint64_t			rollback_ns;				// Time spent in rollbacks, restoring and emulating.
+	uint64_t			max_rollback_ns;			// Longest rollback.
+	uint64_t			snapshot_ns;				// Time spent taking snapshots.
+} gbhw_netplay_stats_t;
+
+typedef struct gbhw_perf_counters
+{
+	uint64_t			instructions;				// Instructions retired.
+	uint64_t			cycles;						// CPU cycles executed.
+	uint64_t			halted_cycles;				// CPU cycles skipped while halted, included in cycles.
+	uint64_t			opcodes[256];				// Execution count per opcode.
+	uint64_t			opcodes_extended[256];		// Execution count per 0xCB prefixed opcode.
+	uint64_t			interrupts[5];				// Interrupts taken, ordered VBlank, Stat, Timer, Serial, Button.
+	uint64_t			rom_bank_switches;			// Switchable ROM bank loads.
+	uint64_t			hdma_bytes;					// Bytes transferred by H-Blank DMA.
+	uint64_t			gdma_bytes;					// Bytes transferred by general-purpose DMA.
+	uint64_t			scanlines;					// Scanlines rendered.
+	uint64_t			sprites_per_line[11];		// Histogram of visible sprites per rendered scanline (0->10).
+} gbhw_perf_counters_t;
+
+typedef struct gbhw_trace_record
+{
+	uint64_t			cycle;						// CPU cycles executed before this instruction.
+	uint16_t			pc;
+	uint16_t			af;
+	uint16_t			bc;
+	uint16_t			de;
+	uint16_t			hl;
+	uint16_t			sp;
+	uint16_t			bank;						// Switchable ROM bank mapped at 0x4000.
+	uint8_t				mem[4];						// Bytes at PC, mem[0] is the opcode.
+} gbhw_trace_record_t;
+
+typedef void(*gbhw_trace_callback_t)(void* userdata, const gbhw_trace_record_t* record);
+
+typedef enum gbhw_watch_type
+{
+	watch_read		= 1,
+	watch_write		= 2,
+	watch_access	= 3								// Read or write.
+} gbhw_watch_type_t;
+
+typedef enum gbhw_break_reason
+{
+	break_none		= 0,
+	break_execute,									// About to execute a breakpoint.
+	break_read,										// Watched address was read.
+	break_write										// Watched address was written.
+} gbhw_break_reason_t;
+
+// Why the last gbhw_step returned early. Watch hits let the instruction that
+// made the access complete, execution stops before the following one.
+typedef struct gbhw_break
+{
+	gbhw_break_reason_t	reason;
+	uint16_t			address;					// PC for break_execute, otherwise the accessed address.
+	uint16_t			bank;						// ROM bank mapped at 0x4000, break_execute only.
+	uint8_t				value;						// Byte read or written.
+} gbhw_break_t;
+
+// Scanlines that changed in the last completed frame compared to the frame
+// before it, lets presenters and encoders skip unchanged lines or frames.
+typedef struct gbhw_screen_dirty
+{
+	uint64_t			frame;						// Completed frames, compare to spot a new one.
+	uint32_t			count;						// Changed lines, 0 if the frame is identical.
+	uint32_t			lines[5];					// Bit (n % 32) of lines[n / 32] is set if line n changed.
+} gbhw_screen_dirty_t;
+
+// A frame ring is a caller supplied block of memory the GPU renders directly
+// into. It may be backed by shared memory so another process can read frames
+// in place without ever blocking emulation. Layout:
+//
+//	gbhw_frame_ring_t									- 64 bytes
+//	count x (gbhw_frame_t + width * height * 4 pixels)	- slot_size bytes each
+//
+// Pixels use the same format as gbhw_get_screen. Each slot is guarded by its
+// fence, which is odd while the GPU writes the frame and even once complete.
+// Readers use gbhw_frame_ring_acquire/gbhw_frame_ring_validate, a frame read
+// between the two is only valid if validate succeeds.
+typedef struct gbhw_frame
+{
+	uint64_t			fence;
+	uint64_t			sequence;					// Frame number, starting at 1.
+	uint32_t			dirty_count;				// As gbhw_screen_dirty_t, relative to the previous frame.
+	uint32_t			dirty_lines[5];
+	uint8_t				reserved[24];
+} gbhw_frame_t;
+
+typedef struct gbhw_frame_ring
+{
+	uint32_t			magic;						// 'GBFR'
+	uint32_t			version;
+	uint32_t			count;						// Number of slots.
+	uint32_t			slot_size;					// Bytes per slot, including the gbhw_frame_t.
+	uint32_t			width;
+	uint32_t			height;
+	uint32_t			stride;						// Bytes per row of pixels.
+	uint32_t			reserved0;
+	uint64_t			latest;						// Sequence of the newest complete frame, 0 if none.
+	uint8_t				reserved[24];
+} gbhw_frame_ring_t;
+
 /*----------------------------------------------------------------------------*/
 
 HWPublicAPI gbhw_errorcode_t gbhw_create(gbhw_settings_t* settings, gbhw_context_t* ctx);
 
 HWPublicAPI void gbhw_destroy(gbhw_context_t ctx);
 
+// Creates a context continuing from ctx's current state. The ROM is shared and
+// RAM banks are copied only once either context writes to them. ctx must not
+// be running while it is forked, afterwards each context may run on its own
+// thread. Tracing and capture are not carried over. Destroy with gbhw_destroy.
+HWPublicAPI gbhw_errorcode_t gbhw_fork(gbhw_context_t ctx, gbhw_context_t* child);
+
+// Overwrites dst's state with src's as gbhw_fork would, reusing dst. A ring of
+// contexts refreshed this way makes save states cheap enough to take every
+// frame. Neither may be running. dst keeps its own screen, settings, counters
+// and breakpoints, and its serial port is left unconnected.
+HWPublicAPI gbhw_errorcode_t gbhw_copy_state(gbhw_context_t dst, gbhw_context_t src);
+
+// A batch owns count contexts in a single allocation, all starting from the
+// ROM in settings and sharing it and their RAM as gbhw_fork does. Stepping a
+// batch steps every context on a fixed pool of threads, each thread always
+// stepping the same slice of contexts.
+HWPublicAPI gbhw_errorcode_t gbhw_batch_create(gbhw_settings_t* settings, gbhw_batch_settings_t* batch_settings, gbhw_batch_t* batch);
+
+HWPublicAPI void gbhw_batch_destroy(gbhw_batch_t batch);
+
+// Contexts belong to the batch and are valid until it is destroyed. They work
+// with every other call except gbhw_destroy, but not during gbhw_batch_step.
+// gbhw_serial_connect can't connect two contexts of the same batch.
+HWPublicAPI gbhw_errorcode_t gbhw_batch_get_context(gbhw_batch_t batch, uint32_t index, gbhw_context_t* ctx);
+
+// Steps every context once and returns when all have finished. results and
+// screens may be null, otherwise they hold an entry per context receiving the
+// gbhw_step result and gbhw_get_screen pointer.
+HWPublicAPI gbhw_errorcode_t gbhw_batch_step(gbhw_batch_t batch, gbhw_step_mode_t mode, gbhw_errorcode_t* results, const uint8_t** screens);
+
+// Connects the serial ports of two contexts with a link cable, neither may be
+// running. Connected contexts run independently until a transfer needs both,
+// so each must be stepped on its own thread: stepping one alone may wait for
+// the other. Two contexts of the same batch are rejected with e_invalidparam,
+// one worker may step both. Loading a ROM disconnects the context.
+HWPublicAPI gbhw_errorcode_t gbhw_serial_connect(gbhw_context_t a, gbhw_context_t b);
+
+// Either side may disconnect while the other is running.
+HWPublicAPI gbhw_errorcode_t gbhw_serial_disconnect(gbhw_context_t ctx);
+
+// Runs ctx as one of two netplay peers. Both must start from the same state,
+// such as a freshly loaded ROM, and the netplay drives ctx's joypad from then
+// on: a button is held if either player holds it. The transport must outlive
+// the netplay.
+HWPublicAPI gbhw_errorcode_t gbhw_netplay_create(gbhw_context_t ctx, gbhw_netplay_settings_t* settings, gbhw_netplay_t* netplay);
+
+HWPublicAPI void gbhw_netplay_destroy(gbhw_netplay_t netplay);
+
+// Emulates the next frame, buttons holds this player's input with bit n set
+// for gbhw_button_t n pressed. The remote input is predicted until it arrives
+// and frames it was mispredicted for are emulated again headless first.
+// advanced is set to 0 if the remote peer is too far behind, nothing is
+// emulated and the input is dropped, call again next frame.
+HWPublicAPI gbhw_errorcode_t gbhw_netplay_advance(gbhw_netplay_t netplay, uint8_t buttons, uint32_t* advanced);
+
+HWPublicAPI gbhw_errorcode_t gbhw_netplay_get_stats(gbhw_netplay_t netplay, gbhw_netplay_stats_t* stats);
+
+// In-process transport pair for testing netplay without a network. Packets
+// sent from either side arrive latency_ms later, loss_percent of them never
+// do. Each side may be used from its own thread.
+HWPublicAPI gbhw_errorcode_t gbhw_loopback_create(uint32_t latency_ms, uint32_t loss_percent, gbhw_loopback_t* loopback);
+
+HWPublicAPI void gbhw_loopback_destroy(gbhw_loopback_t loopback);
+
+// Transport for side 0 or 1, valid until the loopback is destroyed.
+HWPublicAPI gbhw_errorcode_t gbhw_loopback_get_transport(gbhw_loopback_t loopback, uint32_t side, gbhw_netplay_transport_t* transport);
+
 HWPublicAPI gbhw_errorcode_t gbhw_load_rom_file(gbhw_context_t ctx, const char* path);
 
 HWPublicAPI gbhw_errorcode_t gbhw_load_rom_memory(gbhw_context_t ctx, const uint8_t* memory, uint32_t length);
 
 HWPublicAPI gbhw_errorcode_t gbhw_get_screen(gbhw_context_t ctx, const uint8_t** screen);
 
+HWPublicAPI gbhw_errorcode_t gbhw_get_screen_dirty(gbhw_context_t ctx, gbhw_screen_dirty_t* dirty);
+
+// Selects what the GPU renders. format_indexed writes one byte per pixel in
+// place of the 32-bit screen: bits 0-1 colour, bits 2-4 palette number and
+// bit 5 set for sprite palettes. Only frames started in format_rgb are written
+// to the frame ring, indexed frames leave it untouched.
+HWPublicAPI gbhw_errorcode_t gbhw_set_screen_format(gbhw_context_t ctx, gbhw_screen_format_t format);
+
+// Non-zero emulates frames without drawing them, from the start of the next
+// frame. The screen keeps the last frame drawn and nothing is captured or
+// written to the frame ring. Emulation itself is unaffected.
+HWPublicAPI gbhw_errorcode_t gbhw_set_headless(gbhw_context_t ctx, uint32_t headless);
+
+// Indexed screen plus the 64 entry palette captured when the frame completed,
+// entries use the gbhw_get_screen pixel format. Palette changes mid-frame are
+// not represented.
+HWPublicAPI gbhw_errorcode_t gbhw_get_screen_indexed(gbhw_context_t ctx, const uint8_t** screen, const uint32_t** palette);
+
+// Converts count indexed pixels to 32-bit pixels through palette.
+HWPublicAPI gbhw_errorcode_t gbhw_expand_indexed(const uint8_t* indexed, const uint32_t* palette, uint32_t count, uint32_t* pixels);
+
+// Upscales a screen, or any 32-bit image, on the CPU for headless capture and
+// software presenters. pitch is the output row stride in pixels, at least
+// width times the scale factor. get_scaler_factor returns the factor.
+HWPublicAPI gbhw_errorcode_t gbhw_get_scaler_factor(gbhw_scaler_t scaler, uint32_t* factor);
+
+HWPublicAPI gbhw_errorcode_t gbhw_scale_screen(const uint8_t* screen, uint32_t width, uint32_t height, gbhw_scaler_t scaler, uint8_t* output, uint32_t pitch);
+
 HWPublicAPI gbhw_errorcode_t gbhw_get_screen_resolution(gbhw_context_t ctx, uint32_t* width, uint32_t* height);
 
+// Runs an instruction or up to the next vsync. Returns early when a
+// breakpoint or watchpoint fires, see gbhw_get_break. A breakpoint at the
+// current PC doesn't fire until an instruction has run, so stepping again
+// continues past the breakpoint that was hit.
 HWPublicAPI gbhw_errorcode_t gbhw_step(gbhw_context_t ctx, gbhw_step_mode_t mode);
 
 HWPublicAPI gbhw_errorcode_t gbhw_set_button_state(gbhw_context_t ctx, gbhw_button_t button, gbhw_button_state_t state);
 
+HWPublicAPI gbhw_errorcode_t gbhw_get_perf_counters(gbhw_context_t ctx, gbhw_perf_counters_t* counters);
+
+HWPublicAPI gbhw_errorcode_t gbhw_reset_perf_counters(gbhw_context_t ctx);
+
+HWPublicAPI gbhw_errorcode_t gbhw_trace_start(gbhw_context_t ctx, const char* path);
+
+HWPublicAPI gbhw_errorcode_t gbhw_trace_stop(gbhw_context_t ctx);
+
+// Invoked on the emulation thread before each instruction executes, after any
+// interrupt has been dispatched. Pass a null callback to remove it.
+HWPublicAPI gbhw_errorcode_t gbhw_trace_set_callback(gbhw_context_t ctx, gbhw_trace_callback_t callback, void* userdata);
+
+// Records every completed frame to a losslessly compressed capture file, see
+// the gb_capture tool. Compression runs on a background thread, the mode picks
+// whether frames are dropped or emulation stalls if it falls behind.
+HWPublicAPI gbhw_errorcode_t gbhw_capture_start(gbhw_context_t ctx, const char* path, gbhw_capture_mode_t mode);
+
+HWPublicAPI gbhw_errorcode_t gbhw_capture_stop(gbhw_context_t ctx);
+
+// Frames dropped by the active capture.
+HWPublicAPI gbhw_errorcode_t gbhw_capture_get_dropped(gbhw_context_t ctx, uint64_t* dropped);
+
+// Bytes required for a frame ring with the given number of slots (minimum 2).
+HWPublicAPI gbhw_errorcode_t gbhw_get_frame_ring_size(uint32_t count, uint32_t* size);
+
+// Render into the supplied ring from the next frame on, a null memory block
+// returns to the internal framebuffer. The memory must outlive the ring.
+HWPublicAPI gbhw_errorcode_t gbhw_set_frame_ring(gbhw_context_t ctx, void* memory, uint32_t size, uint32_t count);
+
+// Reader side, usable from any process mapping the ring. Acquire returns the
+// newest complete frame, e_failed if there is none or it is being replaced.
+HWPublicAPI gbhw_errorcode_t gbhw_frame_ring_acquire(const gbhw_frame_ring_t* ring, const gbhw_frame_t** frame, const uint8_t** pixels, uint64_t* fence);
+
+// Returns e_success if the frame wasn't overwritten since it was acquired.
+HWPublicAPI gbhw_errorcode_t gbhw_frame_ring_validate(const gbhw_frame_t* frame, uint64_t fence);
+
+// Reads memory as the CPU sees it without triggering any side effects.
+HWPublicAPI gbhw_errorcode_t gbhw_read_memory(gbhw_context_t ctx, uint16_t address, uint8_t* buffer, uint32_t length);
+
+// Execution breakpoints. bank selects the ROM bank a breakpoint in the
+// switchable 0x4000-0x7FFF window applies to, -1 matches any bank. The bank
+// is ignored for every other address.
+HWPublicAPI gbhw_errorcode_t gbhw_add_breakpoint(gbhw_context_t ctx, uint16_t address, int32_t bank);
+
+HWPublicAPI gbhw_errorcode_t gbhw_remove_breakpoint(gbhw_context_t ctx, uint16_t address, int32_t bank);
+
+// Watches the inclusive address range for CPU accesses, including instruction
+// fetches, and for the bytes OAM, general-purpose and H-Blank DMA copy. id
+// identifies the watchpoint for removal.
+HWPublicAPI gbhw_errorcode_t gbhw_add_watchpoint(gbhw_context_t ctx, uint16_t first, uint16_t last, gbhw_watch_type_t type, uint32_t* id);
+
+HWPublicAPI gbhw_errorcode_t gbhw_remove_watchpoint(gbhw_context_t ctx, uint32_t id);
+
+// Removes every breakpoint and watchpoint.
+HWPublicAPI gbhw_errorcode_t gbhw_clear_breakpoints(gbhw_context_t ctx);
+
+// Reason the last gbhw_step stopped early, break_none if it didn't.
+HWPublicAPI gbhw_errorcode_t gbhw_get_break(gbhw_context_t ctx, gbhw_break_t* info);
+
 /*----------------------------------------------------------------------------*/
 
 #ifdef __cplusplus
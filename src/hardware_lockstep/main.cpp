@@ -0,0 +1,304 @@
+#include <gbhw.h>
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	// Fields a reference trace can provide, text logs from other emulators
+	// carry no bank or cycle information.
+	struct RefField
+	{
+		enum Type
+		{
+			Registers	= 0x01,
+			Memory		= 0x02,
+			Bank		= 0x04,
+			Cycle		= 0x08,
+			All			= 0x0F
+		};
+	};
+
+	//--------------------------------------------------------------------------
+
+	// Reads either a binary trace recorded by gbhw_trace_start, or a text log in
+	// the "A:00 F:00 ... SP:0000 PC:0000 PCMEM:00,00,00,00" format.
+	class ReferenceTrace
+	{
+	public:
+		ReferenceTrace() : m_text(nullptr), m_fields(0) {}
+		~ReferenceTrace() { if(m_text) fclose(m_text); }
+
+		bool open(const char* path)
+		{
+			if(m_binary.open(path))
+			{
+				m_fields = RefField::All;
+				return true;
+			}
+
+			m_text = fopen(path, "r");
+			m_fields = RefField::Registers | RefField::Memory;
+			return m_text != nullptr;
+		}
+
+		bool read(TraceRecord& record)
+		{
+			memset(&record, 0, sizeof(record));
+
+			if(!m_text)
+				return m_binary.read(record);
+
+			char line[256];
+
+			while(fgets(line, sizeof(line), m_text))
+			{
+				unsigned int a, f, b, c, d, e, h, l, sp, pc, m0, m1, m2, m3;
+
+				if(sscanf(line, "A:%x F:%x B:%x C:%x D:%x E:%x H:%x L:%x SP:%x PC:%x PCMEM:%x,%x,%x,%x",
+						  &a, &f, &b, &c, &d, &e, &h, &l, &sp, &pc, &m0, &m1, &m2, &m3) != 14)
+				{
+					continue;	// Skip anything that isn't a state line.
+				}
+
+				record.af = static_cast<Word>((a << 8) | f);
+				record.bc = static_cast<Word>((b << 8) | c);
+				record.de = static_cast<Word>((d << 8) | e);
+				record.hl = static_cast<Word>((h << 8) | l);
+				record.sp = static_cast<Word>(sp);
+				record.pc = static_cast<Word>(pc);
+				record.mem[0] = static_cast<Byte>(m0);
+				record.mem[1] = static_cast<Byte>(m1);
+				record.mem[2] = static_cast<Byte>(m2);
+				record.mem[3] = static_cast<Byte>(m3);
+				return true;
+			}
+
+			return false;
+		}
+
+		uint32_t fields() const { return m_fields; }
+
+	private:
+		TraceReader		m_binary;
+		FILE*			m_text;
+		uint32_t		m_fields;
+	};
+
+	//--------------------------------------------------------------------------
+
+	struct Lockstep
+	{
+		gbhw_context_t	ctx;
+		ReferenceTrace	reference;
+		TraceRecord		expected;
+		TraceRecord		actual;
+		TraceRecord		previous;
+		uint64_t		instructions;
+		uint64_t		maxInstructions;
+		bool			bDiverged;
+		bool			bFinished;
+
+		static const uint32_t	kMemoryWindow = 16;
+		Byte			memoryPC[kMemoryWindow];
+		Byte			memorySP[kMemoryWindow];
+		Byte			memoryHL[kMemoryWindow];
+	};
+
+	bool records_match(const TraceRecord& expected, const TraceRecord& actual, uint32_t fields)
+	{
+		if((fields & RefField::Registers) &&
+		   ((expected.pc != actual.pc) || (expected.af != actual.af) || (expected.bc != actual.bc) ||
+			(expected.de != actual.de) || (expected.hl != actual.hl) || (expected.sp != actual.sp)))
+		{
+			return false;
+		}
+
+		if((fields & RefField::Memory) && (memcmp(expected.mem, actual.mem, sizeof(expected.mem)) != 0))
+			return false;
+
+		if((fields & RefField::Bank) && (expected.bank != actual.bank))
+			return false;
+
+		if((fields & RefField::Cycle) && (expected.cycle != actual.cycle))
+			return false;
+
+		return true;
+	}
+
+	void lockstep_callback(void* userdata, const gbhw_trace_record_t* record)
+	{
+		Lockstep& ls = *static_cast<Lockstep*>(userdata);
+
+		if(ls.bDiverged || ls.bFinished)
+			return;
+
+		if((ls.instructions >= ls.maxInstructions) || !ls.reference.read(ls.expected))
+		{
+			ls.bFinished = true;
+			return;
+		}
+
+		ls.actual = *record;
+
+		if(!records_match(ls.expected, ls.actual, ls.reference.fields()))
+		{
+			// Capture memory now, the instruction is about to execute.
+			ls.bDiverged = true;
+			gbhw_read_memory(ls.ctx, ls.actual.pc, ls.memoryPC, Lockstep::kMemoryWindow);
+			gbhw_read_memory(ls.ctx, ls.actual.sp, ls.memorySP, Lockstep::kMemoryWindow);
+			gbhw_read_memory(ls.ctx, ls.actual.hl, ls.memoryHL, Lockstep::kMemoryWindow);
+			return;
+		}
+
+		ls.previous = ls.actual;
+		ls.instructions++;
+	}
+
+	//--------------------------------------------------------------------------
+
+	void print_word(const char* name, Word expected, Word actual)
+	{
+		printf("  %-6s %04X       %04X%s\n", name, expected, actual, expected != actual ? "   <--" : "");
+	}
+
+	void print_memory(const char* name, Address address, const Byte* memory)
+	{
+		printf("  %-2s %04X:", name, address);
+
+		for(uint32_t i = 0; i < Lockstep::kMemoryWindow; i++)
+			printf(" %02X", memory[i]);
+
+		printf("\n");
+	}
+
+	void print_divergence(const Lockstep& ls)
+	{
+		const TraceRecord& e = ls.expected;
+		const TraceRecord& a = ls.actual;
+		const uint32_t fields = ls.reference.fields();
+
+		printf("Diverged at instruction %" PRIu64 "\n", ls.instructions);
+
+		if(ls.instructions > 0)
+			printf("Last matching instruction: PC:%04X BANK:%03X opcode %02X\n", ls.previous.pc, ls.previous.bank, ls.previous.mem[0]);
+
+		printf("\n           expected   actual\n");
+		print_word("PC", e.pc, a.pc);
+		print_word("AF", e.af, a.af);
+		print_word("BC", e.bc, a.bc);
+		print_word("DE", e.de, a.de);
+		print_word("HL", e.hl, a.hl);
+		print_word("SP", e.sp, a.sp);
+
+		if(fields & RefField::Bank)
+			printf("  %-6s %03X        %03X%s\n", "BANK", e.bank, a.bank, e.bank != a.bank ? "     <--" : "");
+
+		if(fields & RefField::Cycle)
+			printf("  %-6s %-10" PRIu64 " %-10" PRIu64 "%s\n", "CYCLE", e.cycle, a.cycle, e.cycle != a.cycle ? " <--" : "");
+
+		printf("  %-6s %02X,%02X,%02X,%02X %02X,%02X,%02X,%02X%s\n", "PCMEM",
+			   e.mem[0], e.mem[1], e.mem[2], e.mem[3], a.mem[0], a.mem[1], a.mem[2], a.mem[3],
+			   memcmp(e.mem, a.mem, sizeof(e.mem)) != 0 ? " <--" : "");
+
+		printf("\nActual memory:\n");
+		print_memory("PC", a.pc, ls.memoryPC);
+		print_memory("SP", a.sp, ls.memorySP);
+		print_memory("HL", a.hl, ls.memoryHL);
+	}
+
+	void print_usage()
+	{
+		printf("Runs a ROM and compares CPU state every instruction against a reference trace.\n");
+		printf("\tUsage: EXE [-n <MAX INSTRUCTIONS>] <ROM PATH> <TRACE PATH>\n");
+		printf("\n");
+		printf("The trace is either a binary trace from gbhw_trace_start, or a text log with\n");
+		printf("one \"A:00 F:00 B:00 C:00 D:00 E:00 H:00 L:00 SP:0000 PC:0000 PCMEM:00,00,00,00\"\n");
+		printf("line per instruction. Exits 0 on a match, 1 on divergence, -1 on error.\n");
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	const char* romPath = nullptr;
+	const char* tracePath = nullptr;
+	uint64_t maxInstructions = UINT64_MAX;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if((strcmp(args[i], "-n") == 0) && (i + 1 < argc))
+			maxInstructions = strtoull(args[++i], nullptr, 10);
+		else if(!romPath)
+			romPath = args[i];
+		else if(!tracePath)
+			tracePath = args[i];
+		else
+		{
+			print_usage();
+			return -1;
+		}
+	}
+
+	if(!romPath || !tracePath)
+	{
+		print_usage();
+		return -1;
+	}
+
+	Lockstep* ls = new Lockstep();
+	ls->instructions = 0;
+	ls->maxInstructions = maxInstructions;
+
+	if(!ls->reference.open(tracePath))
+	{
+		printf("Failed to open reference trace '%s'\n", tracePath);
+		delete ls;
+		return -1;
+	}
+
+	gbhw_settings_t settings	= {0};
+	settings.log_level			= l_disabled;
+
+	if((gbhw_create(&settings, &ls->ctx) != e_success) || (gbhw_load_rom_file(ls->ctx, romPath) != e_success))
+	{
+		printf("Failed to load ROM '%s'\n", romPath);
+		gbhw_destroy(ls->ctx);
+		delete ls;
+		return -1;
+	}
+
+	gbhw_trace_set_callback(ls->ctx, lockstep_callback, ls);
+
+	int result = 0;
+
+	while(!ls->bDiverged && !ls->bFinished)
+	{
+		if(gbhw_step(ls->ctx, step_vsync) != e_success)
+		{
+			printf("Hardware failed after %" PRIu64 " matching instructions\n", ls->instructions);
+			result = 1;
+			break;
+		}
+	}
+
+	if(ls->bDiverged)
+	{
+		print_divergence(*ls);
+		result = 1;
+	}
+	else if(result == 0)
+	{
+		printf("Matched %" PRIu64 " instructions\n", ls->instructions);
+	}
+
+	gbhw_destroy(ls->ctx);
+	delete ls;
+	return result;
+}
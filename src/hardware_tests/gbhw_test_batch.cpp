@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <vector>
+
+namespace
+{
+	const uint32_t kBatchCount = 7;
+
+	// Adds the held directions to SCX each frame and draws them into the first
+	// tile, so contexts holding different buttons drift apart. The DMG
+	// palette isn't emulated, this is a colour ROM to draw something.
+	TestRom CreateScrollRom()
+	{
+		TestRom rom(true);
+		rom.Emit(
+		{
+			0xF3,				// DI
+			0x3E, 0x01,			// LD A, $01
+			0xE0, 0xFF,			// LDH ($FF), A		IE = V-Blank
+			0x3E, 0x82,			// LD A, $82
+			0xE0, 0x68,			// LDH ($68), A		BGPI = palette 0 colour 1, auto-increment
+			0xAF,				// XOR A
+			0xE0, 0x69,			// LDH ($69), A		BGPD = black
+			0xE0, 0x69			// LDH ($69), A
+		});
+		rom.Emit(
+		{
+			0xAF,				// XOR A
+			0xE0, 0x0F,			// LDH ($0F), A		IF = none
+			0x76,				// HALT
+			0x3E, 0x20,			// LD A, $20
+			0xE0, 0x00,			// LDH ($00), A		P1 = directions
+			0xF0, 0x00,			// LDH A, ($00)
+			0x2F,				// CPL
+			0xE6, 0x0F,			// AND $0F
+			0x47,				// LD B, A
+			0xEA, 0x00, 0x80,	// LD ($8000), A	Tile 0 row 0
+			0xF0, 0x43,			// LDH A, ($43)
+			0x80,				// ADD A, B
+			0xE0, 0x43,			// LDH ($43), A		SCX
+			0x18, 0xE8			// JR loop
+		});
+
+		return rom;
+	}
+
+	// Each context holds a different, non-empty set of directions.
+	void HoldDirections(gbhw_context_t ctx, uint32_t index)
+	{
+		for(uint32_t direction = 0; direction < 4; direction++)
+		{
+			if(((index + 1) >> direction) & 1)
+				gbhw_set_button_state(ctx, static_cast<gbhw_button_t>(button_dpad_right + direction), button_pressed);
+		}
+	}
+
+	uint64_t HashState(gbhw_context_t ctx)
+	{
+		std::vector<uint8_t> memory(0x8000);
+		gbhw_read_memory(ctx, 0x8000, memory.data(), static_cast<uint32_t>(memory.size()));
+
+		const uint8_t* screen = nullptr;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		gbhw_get_screen(ctx, &screen);
+		gbhw_get_screen_resolution(ctx, &width, &height);
+
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		for(uint8_t value : memory)
+			hash = (hash ^ value) * 0x100000001B3ull;
+
+		for(uint32_t i = 0; i < (width * height * 4); i++)
+			hash = (hash ^ screen[i]) * 0x100000001B3ull;
+
+		return hash;
+	}
+
+	// Steps a batch on the given number of threads next to a context per
+	// entry stepped on its own, every frame of each must match.
+	void ExpectMatchesSingle(uint32_t threads)
+	{
+		const TestRom rom = CreateScrollRom();
+		gbhw_settings_t settings = rom.GetSettings();
+		gbhw_batch_settings_t batchSettings = {0};
+		batchSettings.count		= kBatchCount;
+		batchSettings.threads	= threads;
+
+		gbhw_batch_t batch = nullptr;
+		ASSERT_EQ(e_success, gbhw_batch_create(&settings, &batchSettings, &batch));
+
+		gbhw_context_t contexts[kBatchCount];
+		std::vector<TestContext> singles;
+
+		for(uint32_t i = 0; i < kBatchCount; i++)
+		{
+			ASSERT_EQ(e_success, gbhw_batch_get_context(batch, i, &contexts[i]));
+			singles.push_back(rom.CreateContext());
+
+			HoldDirections(contexts[i], i);
+			HoldDirections(singles[i].get(), i);
+		}
+
+		for(uint32_t frame = 0; frame < 30; frame++)
+		{
+			gbhw_errorcode_t results[kBatchCount];
+			const uint8_t* screens[kBatchCount];
+
+			for(uint32_t i = 0; i < kBatchCount; i++)
+			{
+				results[i] = e_failed;
+				screens[i] = nullptr;
+			}
+
+			ASSERT_EQ(e_success, gbhw_batch_step(batch, step_vsync, results, screens));
+
+			for(uint32_t i = 0; i < kBatchCount; i++)
+			{
+				const uint8_t* screen = nullptr;
+				gbhw_get_screen(contexts[i], &screen);
+
+				EXPECT_EQ(e_success, results[i]) << "context " << i << " frame " << frame;
+				EXPECT_EQ(screen, screens[i]) << "context " << i << " frame " << frame;
+
+				ASSERT_EQ(e_success, gbhw_step(singles[i].get(), step_vsync));
+				ASSERT_EQ(HashState(singles[i].get()), HashState(contexts[i])) << "context " << i << " frame " << frame;
+			}
+		}
+
+		// The contexts really did run apart.
+		EXPECT_NE(HashState(contexts[0]), HashState(contexts[1]));
+		gbhw_batch_destroy(batch);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Step
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_BATCH, STEP_ONE_THREAD)
+{
+	ExpectMatchesSingle(1);
+}
+
+TEST(HW_BATCH, STEP_TWO_THREADS)
+{
+	ExpectMatchesSingle(2);
+}
+
+TEST(HW_BATCH, STEP_THREE_THREADS)
+{
+	// Slices are uneven, three doesn't divide the batch.
+	ExpectMatchesSingle(3);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Serial
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_BATCH, SERIAL_CONNECT)
+{
+	// With one worker stepping both, a transfer between two contexts of the
+	// batch would wait forever. A context outside the batch may connect.
+	TestRom rom;
+	gbhw_settings_t settings = rom.GetSettings();
+	gbhw_batch_settings_t batchSettings = {0};
+	batchSettings.count		= 2;
+	batchSettings.threads	= 1;
+
+	gbhw_batch_t batch = nullptr;
+	ASSERT_EQ(e_success, gbhw_batch_create(&settings, &batchSettings, &batch));
+
+	gbhw_context_t contexts[2] = { nullptr, nullptr };
+	gbhw_batch_get_context(batch, 0, &contexts[0]);
+	gbhw_batch_get_context(batch, 1, &contexts[1]);
+
+	EXPECT_EQ(e_invalidparam, gbhw_serial_connect(contexts[0], contexts[1]));
+
+	TestContext ctx = rom.CreateContext();
+	EXPECT_EQ(e_success, gbhw_serial_connect(contexts[0], ctx.get()));
+	EXPECT_EQ(e_success, gbhw_serial_disconnect(ctx.get()));
+
+	EXPECT_EQ(e_success, gbhw_batch_step(batch, step_vsync, nullptr, nullptr));
+	gbhw_batch_destroy(batch);
+}
@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include "capture.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gbhw;
+
+namespace
+{
+	const uint32_t kKeyFrameInterval = 600;
+
+	// Each frame has an untouched band (zero runs), a band filled with one
+	// value per frame (repeat runs) and a band of noise (literal runs). Every
+	// fifth frame repeats the last one exactly.
+	void FillFrame(uint64_t index, uint32_t* pixels)
+	{
+		const uint64_t seed = index - (index % 5 == 4 ? 1 : 0);
+		uint32_t hash = static_cast<uint32_t>(seed) * 2654435761u;
+
+		for(uint32_t i = 0; i < kCapturePixels; i++)
+		{
+			if(i < 8000)
+			{
+				pixels[i] = 0xFF204060;
+			}
+			else if(i < 16000)
+			{
+				pixels[i] = static_cast<uint32_t>(seed) * 0x01010101u;
+			}
+			else
+			{
+				hash ^= hash << 13;
+				hash ^= hash >> 17;
+				hash ^= hash << 5;
+				pixels[i] = hash;
+			}
+		}
+	}
+
+	struct DecodedFrame
+	{
+		uint64_t				number;
+		std::vector<uint32_t>	pixels;
+	};
+
+	std::vector<DecodedFrame> ReadCapture(const std::string& path)
+	{
+		std::vector<DecodedFrame> frames;
+		CaptureReader reader;
+		DecodedFrame frame;
+		frame.pixels.resize(kCapturePixels);
+
+		EXPECT_TRUE(reader.open(path.c_str()));
+
+		while(reader.read(frame.number, &frame.pixels[0]))
+			frames.push_back(frame);
+
+		return frames;
+	}
+
+	bool ReadVarint(FILE* file, uint64_t& value)
+	{
+		value = 0;
+
+		for(uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			const int byte = fgetc(file);
+
+			if(byte == EOF)
+				return false;
+
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+			if((byte & 0x80) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Walks the frame headers, returning the index of every key frame.
+	std::vector<uint64_t> GetKeyFrames(const std::string& path)
+	{
+		std::vector<uint64_t> keyFrames;
+		FILE* file = fopen(path.c_str(), "rb");
+
+		if(!file)
+			return keyFrames;
+
+		fseek(file, 16, SEEK_SET);
+
+		for(uint64_t index = 0; ; index++)
+		{
+			const int flags = fgetc(file);
+			uint64_t delta = 0;
+			uint64_t size = 0;
+
+			if((flags == EOF) || !ReadVarint(file, delta) || !ReadVarint(file, size))
+				break;
+
+			if(flags & CaptureFlags::KeyFrame)
+				keyFrames.push_back(index);
+
+			fseek(file, static_cast<long>(size), SEEK_CUR);
+		}
+
+		fclose(file);
+		return keyFrames;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Encoding
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_CAPTURE, ROUND_TRIP)
+{
+	// Past the key frame interval so decoding crosses a second key frame.
+	const uint32_t kFrames = kKeyFrameInterval + 10;
+	const std::string path = ::testing::TempDir() + "gbhw_test_capture_round_trip.gbvc";
+
+	CaptureWriter writer;
+	ASSERT_TRUE(writer.open(path.c_str(), true));
+
+	for(uint32_t i = 0; i < kFrames; i++)
+	{
+		CaptureFrame* frame = writer.acquire();
+		ASSERT_NE(nullptr, frame);
+		FillFrame(i, frame->pixels);
+		writer.commit();
+	}
+
+	writer.close();
+	EXPECT_EQ(0u, writer.get_dropped());
+
+	const std::vector<DecodedFrame> frames = ReadCapture(path);
+	const std::vector<uint64_t> keyFrames = GetKeyFrames(path);
+	remove(path.c_str());
+
+	ASSERT_EQ(kFrames, frames.size());
+	ASSERT_EQ(2u, keyFrames.size());
+	EXPECT_EQ(0u, keyFrames[0]);
+	EXPECT_EQ(kKeyFrameInterval, keyFrames[1]);
+
+	std::vector<uint32_t> expected(kCapturePixels);
+
+	for(uint32_t i = 0; i < kFrames; i++)
+	{
+		FillFrame(i, &expected[0]);
+		EXPECT_EQ(i + 1, frames[i].number);
+		ASSERT_TRUE(expected == frames[i].pixels) << "frame " << i;
+	}
+}
+
+TEST(HW_CAPTURE, DROPPED_FRAMES)
+{
+	// Frames are handed out faster than they compress, the ones the full ring
+	// turns away leave gaps in the numbering and the rest still decode.
+	const std::string path = ::testing::TempDir() + "gbhw_test_capture_dropped.gbvc";
+
+	CaptureWriter writer;
+	ASSERT_TRUE(writer.open(path.c_str(), false));
+
+	std::vector<uint64_t> numbers;
+	uint64_t acquired = 0;
+
+	for(; numbers.size() < 32; acquired++)
+	{
+		CaptureFrame* frame = writer.acquire();
+
+		if(frame)
+		{
+			FillFrame(frame->number, frame->pixels);
+			numbers.push_back(frame->number);
+			writer.commit();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+
+	writer.close();
+	ASSERT_GT(writer.get_dropped(), 0u);
+	EXPECT_EQ(acquired - numbers.size(), writer.get_dropped());
+	EXPECT_GT(numbers.back(), numbers.size());
+
+	const std::vector<DecodedFrame> frames = ReadCapture(path);
+	remove(path.c_str());
+
+	ASSERT_EQ(numbers.size(), frames.size());
+
+	std::vector<uint32_t> expected(kCapturePixels);
+
+	for(size_t i = 0; i < frames.size(); i++)
+	{
+		FillFrame(numbers[i], &expected[0]);
+		EXPECT_EQ(numbers[i], frames[i].number);
+		ASSERT_TRUE(expected == frames[i].pixels) << "frame " << i;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Emulation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_CAPTURE, WAIT_KEEPS_EVERY_FRAME)
+{
+	// Scrolls a striped tile a pixel a frame. Waiting for the compressor
+	// keeps every frame and the last matches the screen. The DMG palette
+	// isn't emulated, so this draws with a colour one.
+	TestRom rom(true);
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x01,			// LD A, $01
+		0xE0, 0xFF,			// LDH ($FF), A		IE = V-Blank
+		0x3E, 0x82,			// LD A, $82
+		0xE0, 0x68,			// LDH ($68), A		BGPI = palette 0 colour 1, auto-increment
+		0xAF,				// XOR A
+		0xE0, 0x69,			// LDH ($69), A		BGPD = black
+		0xE0, 0x69			// LDH ($69), A
+	});
+	rom.Emit(
+	{
+		0xAF,				// XOR A
+		0xE0, 0x0F,			// LDH ($0F), A		IF = none
+		0x76,				// HALT
+		0x3E, 0x5A,			// LD A, $5A
+		0xEA, 0x00, 0x80,	// LD ($8000), A	Tile 0 row 0
+		0xF0, 0x43,			// LDH A, ($43)
+		0x3C,				// INC A
+		0xE0, 0x43,			// LDH ($43), A		SCX
+		0x18, 0xF0			// JR loop
+	});
+
+	const uint32_t kFrames = 120;
+	const std::string path = ::testing::TempDir() + "gbhw_test_capture_wait.gbvc";
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_EQ(e_success, gbhw_capture_start(ctx.get(), path.c_str(), capture_wait));
+
+	for(uint32_t i = 0; i < kFrames; i++)
+		ASSERT_EQ(e_success, gbhw_step(ctx.get(), step_vsync));
+
+	uint64_t dropped = 1;
+	EXPECT_EQ(e_success, gbhw_capture_get_dropped(ctx.get(), &dropped));
+	EXPECT_EQ(0u, dropped);
+	ASSERT_EQ(e_success, gbhw_capture_stop(ctx.get()));
+
+	const std::vector<DecodedFrame> frames = ReadCapture(path);
+	remove(path.c_str());
+
+	ASSERT_EQ(kFrames, frames.size());
+
+	for(size_t i = 0; i < frames.size(); i++)
+		EXPECT_EQ(i + 1, frames[i].number);
+
+	for(size_t i = 1; i < frames.size(); i++)
+		EXPECT_FALSE(frames[i - 1].pixels == frames[i].pixels) << "frame " << i;
+
+	const uint8_t* screen = nullptr;
+	gbhw_get_screen(ctx.get(), &screen);
+
+	EXPECT_EQ(0, memcmp(screen, &frames.back().pixels[0], kCapturePixels * sizeof(uint32_t)));
+}
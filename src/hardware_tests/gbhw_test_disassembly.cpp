@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#if HWEnableDebug
+
+#include "gbhw_test_rom.h"
+#include <gbhw_debug.h>
+#include <stdio.h>
+#include <string>
+
+namespace
+{
+	gbhw::Address Find(gbhw_context_t ctx, gbhw::Address address)
+	{
+		gbhw::Address start = 0;
+		EXPECT_EQ(e_success, gbhw_disasm_find(ctx, address, &start));
+		return start;
+	}
+
+	const char* FindSymbol(gbhw_context_t ctx, gbhw::Address address)
+	{
+		const char* name = nullptr;
+		EXPECT_EQ(e_success, gbhw_find_symbol(ctx, address, &name));
+		return name;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Invalidation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_DISASSEMBLY, RAM_WRITE_REDECODES)
+{
+	// Assembles LD BC, $1234 into WRAM, then overwrites its opcode with a NOP
+	// so the operands become instructions of their own.
+	TestRom rom;
+	rom.Emit(
+	{
+		0x21, 0x00, 0xC0,	// LD HL, $C000
+		0x3E, 0x01,			// LD A, $01
+		0x22,				// LD (HL+), A
+		0x3E, 0x34,			// LD A, $34
+		0x22,				// LD (HL+), A
+		0x3E, 0x12,			// LD A, $12
+		0x22				// LD (HL+), A
+	});
+	const uint16_t kWritten = rom.Emit(
+	{
+		0xAF,				// XOR A
+		0xEA, 0x00, 0xC0	// LD ($C000), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kWritten));
+
+	EXPECT_EQ(0xC000, Find(ctx.get(), 0xC002));
+
+	gbhw::DisasmLine line;
+	uint32_t written = 0;
+	ASSERT_EQ(e_success, gbhw_disasm_lines(ctx.get(), 0xC000, &line, 1, &written));
+	ASSERT_EQ(1u, written);
+	EXPECT_EQ(3, line.size);
+	EXPECT_EQ(0x01, line.bytes[0]);
+	EXPECT_EQ(0x34, line.bytes[1]);
+	EXPECT_EQ(0x12, line.bytes[2]);
+
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_EQ(0xC001, Find(ctx.get(), 0xC001));
+	EXPECT_EQ(0xC002, Find(ctx.get(), 0xC002));
+
+	ASSERT_EQ(e_success, gbhw_disasm_lines(ctx.get(), 0xC000, &line, 1, &written));
+	ASSERT_EQ(1u, written);
+	EXPECT_EQ(1, line.size);
+	EXPECT_EQ(0x00, line.bytes[0]);
+}
+
+TEST(HW_DISASSEMBLY, ROM_RELOAD_REINDEXES)
+{
+	// Both banks are indexed before the reload, neither index may survive it.
+	TestRom first;
+	first.Write(0x0200, { 0xC3, 0x00, 0x02 });	// JP $0200
+	first.Write(0x4000, { 0xC3, 0x00, 0x40 });	// JP $4000
+
+	TestContext ctx = first.CreateContext();
+	EXPECT_EQ(0x0200, Find(ctx.get(), 0x0201));
+	EXPECT_EQ(0x4000, Find(ctx.get(), 0x4002));
+
+	TestRom second;
+	const gbhw_settings_t settings = second.GetSettings();
+	ASSERT_EQ(e_success, gbhw_load_rom_memory(ctx.get(), settings.rom, settings.rom_size));
+
+	EXPECT_EQ(0x0201, Find(ctx.get(), 0x0201));
+	EXPECT_EQ(0x4002, Find(ctx.get(), 0x4002));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Symbols
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_DISASSEMBLY, LOAD_SYMBOLS)
+{
+	// Banked symbols only match the bank mapped, RAM symbols any bank. The
+	// first name given to an address wins.
+	const std::string path = ::testing::TempDir() + "gbhw_test_disassembly.sym";
+	FILE* file = fopen(path.c_str(), "w");
+	ASSERT_NE(nullptr, file);
+	fputs(
+		"; File generated by rgblink\n"
+		"00:0150 Start\n"
+		"00:0150 Start.alias\n"
+		"01:4000 BankOne\n"
+		"02:4000 BankTwo\n"
+		"00:c000 wScratch\n"
+		"not a symbol\n", file);
+	fclose(file);
+
+	TestRom rom;
+	TestContext ctx = rom.CreateContext();
+
+	EXPECT_EQ(e_failed, gbhw_load_symbols(ctx.get(), (path + ".missing").c_str()));
+	ASSERT_EQ(e_success, gbhw_load_symbols(ctx.get(), path.c_str()));
+	remove(path.c_str());
+
+	EXPECT_STREQ("Start", FindSymbol(ctx.get(), 0x0150));
+	EXPECT_STREQ("BankOne", FindSymbol(ctx.get(), 0x4000));
+	EXPECT_STREQ("wScratch", FindSymbol(ctx.get(), 0xC000));
+	EXPECT_EQ(nullptr, FindSymbol(ctx.get(), 0x0151));
+
+	gbhw::DisasmLine line;
+	uint32_t written = 0;
+	ASSERT_EQ(e_success, gbhw_disasm_lines(ctx.get(), 0x0150, &line, 1, &written));
+	ASSERT_EQ(1u, written);
+	EXPECT_STREQ("Start", line.symbol);
+}
+
+#endif
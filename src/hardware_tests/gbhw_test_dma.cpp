@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <vector>
+
+namespace
+{
+	// Steps until the first break, which must be a watch hit.
+	gbhw_break_t StepToWatch(gbhw_context_t ctx, uint16_t first, uint16_t last, gbhw_watch_type_t type)
+	{
+		uint32_t id = 0;
+		gbhw_break_t info;
+
+		gbhw_add_watchpoint(ctx, first, last, type, &id);
+		gbhw_step(ctx, step_vsync);
+		gbhw_get_break(ctx, &info);
+		gbhw_remove_watchpoint(ctx, id);
+
+		return info;
+	}
+
+	// Fills $C000-$C07F with $01, $02... and points H-Blank DMA at it, the
+	// destination is $8000. Starting the transfer is left to the caller.
+	void EmitHdmaSetup(TestRom& rom)
+	{
+		rom.Emit(
+		{
+			0xF3,				// DI
+			0x21, 0x00, 0xC0,	// LD HL, $C000
+			0x06, 0x80,			// LD B, $80
+			0x7D,				// LD A, L
+			0x3C,				// INC A
+			0x22,				// LD (HL+), A
+			0x05,				// DEC B
+			0x20, 0xFA,			// JR NZ, -6
+			0x3E, 0xC0,			// LD A, $C0
+			0xE0, 0x51,			// LDH ($51), A		HDMA1
+			0xAF,				// XOR A
+			0xE0, 0x52,			// LDH ($52), A		HDMA2
+			0x3E, 0x80,			// LD A, $80
+			0xE0, 0x53,			// LDH ($53), A		HDMA3
+			0xAF,				// XOR A
+			0xE0, 0x54			// LDH ($54), A		HDMA4
+		});
+	}
+
+	uint64_t GetHdmaBytes(gbhw_context_t ctx)
+	{
+		gbhw_perf_counters_t counters;
+		gbhw_get_perf_counters(ctx, &counters);
+		return counters.hdma_bytes;
+	}
+
+	void ExpectVram(gbhw_context_t ctx, uint32_t copied)
+	{
+		uint8_t vram[0x80];
+		gbhw_read_memory(ctx, 0x8000, vram, sizeof(vram));
+
+		for(uint32_t i = 0; i < sizeof(vram); i++)
+			EXPECT_EQ((i < copied) ? (i + 1) : 0, vram[i]) << "at $" << std::hex << (0x8000 + i);
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Watchpoints
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_DMA, OAM_DMA_WATCHPOINTS)
+{
+	// Copies $C100-$C19F to OAM.
+	TestRom rom;
+	rom.Emit(
+	{
+		0x3E, 0x5A,			// LD A, $5A
+		0xEA, 0x50, 0xC1,	// LD ($C150), A
+		0x3E, 0xC1,			// LD A, $C1
+		0xE0, 0x46,			// LDH ($46), A		DMA
+		0x00				// NOP
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	const gbhw_break_t read = StepToWatch(ctx.get(), 0xC150, 0xC150, watch_read);
+
+	EXPECT_EQ(break_read, read.reason);
+	EXPECT_EQ(0xC150, read.address);
+	EXPECT_EQ(0x5A, read.value);
+
+	ctx = rom.CreateContext();
+	const gbhw_break_t write = StepToWatch(ctx.get(), 0xFE50, 0xFE50, watch_write);
+
+	EXPECT_EQ(break_write, write.reason);
+	EXPECT_EQ(0xFE50, write.address);
+	EXPECT_EQ(0x5A, write.value);
+
+	// Pages the copy doesn't touch aren't reported.
+	ctx = rom.CreateContext();
+	uint32_t id = 0;
+	gbhw_add_watchpoint(ctx.get(), 0xC000, 0xC0FF, watch_access, &id);
+	EXPECT_TRUE(RunTo(ctx.get(), kDone));
+}
+
+TEST(HW_DMA, GDMA_WATCHPOINTS)
+{
+	// Copies $C000-$C01F to $8000 at once.
+	TestRom rom(true);
+	rom.Emit(
+	{
+		0x3E, 0x5A,			// LD A, $5A
+		0xEA, 0x15, 0xC0,	// LD ($C015), A
+		0x3E, 0xC0,			// LD A, $C0
+		0xE0, 0x51,			// LDH ($51), A		HDMA1
+		0xAF,				// XOR A
+		0xE0, 0x52,			// LDH ($52), A		HDMA2
+		0x3E, 0x80,			// LD A, $80
+		0xE0, 0x53,			// LDH ($53), A		HDMA3
+		0xAF,				// XOR A
+		0xE0, 0x54,			// LDH ($54), A		HDMA4
+		0x3E, 0x01,			// LD A, $01
+		0xE0, 0x55,			// LDH ($55), A		HDMA5 = general-purpose, 2 blocks
+		0x00				// NOP
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	const gbhw_break_t read = StepToWatch(ctx.get(), 0xC015, 0xC015, watch_read);
+
+	EXPECT_EQ(break_read, read.reason);
+	EXPECT_EQ(0xC015, read.address);
+	EXPECT_EQ(0x5A, read.value);
+
+	ctx = rom.CreateContext();
+	const gbhw_break_t write = StepToWatch(ctx.get(), 0x8010, 0x801F, watch_write);
+
+	EXPECT_EQ(break_write, write.reason);
+	EXPECT_EQ(0x8010, write.address);
+
+	ctx = rom.CreateContext();
+	uint32_t id = 0;
+	gbhw_add_watchpoint(ctx.get(), 0x8020, 0x80FF, watch_write, &id);
+	EXPECT_TRUE(RunTo(ctx.get(), kDone));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// H-Blank DMA
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_DMA, HDMA_BLOCK_PER_HBLANK)
+{
+	TestRom rom(true);
+	EmitHdmaSetup(rom);
+	rom.Emit(
+	{
+		0x3E, 0x83,			// LD A, $83
+		0xE0, 0x55			// LDH ($55), A		HDMA5 = H-Blank, 4 blocks
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	// Each block is copied as the GPU enters H-Blank on consecutive lines.
+	std::vector<uint8_t> lines;
+	uint64_t bytes = GetHdmaBytes(ctx.get());
+
+	for(uint32_t step = 0; (step < 100000) && (ReadByte(ctx.get(), 0xFF55) != 0xFF); step++)
+	{
+		ASSERT_EQ(e_success, gbhw_step(ctx.get(), step_instruction));
+
+		const uint64_t current = GetHdmaBytes(ctx.get());
+
+		if(current != bytes)
+		{
+			const uint8_t ly = ReadByte(ctx.get(), 0xFF44);
+
+			EXPECT_EQ(16u, current - bytes);
+			EXPECT_LT(ly, 144);
+
+			lines.push_back(ly);
+			bytes = current;
+		}
+	}
+
+	ASSERT_EQ(4u, lines.size());
+
+	for(uint32_t i = 1; i < lines.size(); i++)
+		EXPECT_EQ((lines[i - 1] + 1) % 144, lines[i]);
+
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF55));
+	ExpectVram(ctx.get(), 64);
+
+	// Nothing more is copied once finished.
+	gbhw_step(ctx.get(), step_vsync);
+	gbhw_step(ctx.get(), step_vsync);
+	EXPECT_EQ(64u, GetHdmaBytes(ctx.get()));
+}
+
+TEST(HW_DMA, HDMA_CANCEL)
+{
+	// Clearing bit 7 of HDMA5 once two of eight blocks are copied stops the
+	// transfer, HDMA5 then reads bit 7 set with the remaining length.
+	TestRom rom(true);
+	EmitHdmaSetup(rom);
+	rom.Emit(
+	{
+		0x3E, 0x87,			// LD A, $87
+		0xE0, 0x55,			// LDH ($55), A		HDMA5 = H-Blank, 8 blocks
+		0xF0, 0x55,			// LDH A, ($55)
+		0xFE, 0x05,			// CP $05
+		0x20, 0xFA,			// JR NZ, -6
+		0xAF,				// XOR A
+		0xE0, 0x55			// LDH ($55), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	gbhw_step(ctx.get(), step_vsync);
+	gbhw_step(ctx.get(), step_vsync);
+
+	EXPECT_EQ(32u, GetHdmaBytes(ctx.get()));
+	EXPECT_EQ(0x85, ReadByte(ctx.get(), 0xFF55));
+	ExpectVram(ctx.get(), 32);
+}
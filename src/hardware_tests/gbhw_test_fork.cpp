@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <vector>
+
+namespace
+{
+	// Flat WRAM, banked WRAM and cartridge RAM, the ways RAM is kept by a fork.
+	const uint16_t kRamAddresses[] = { 0xC000, 0xD000, 0xA000 };
+
+	// An MBC1 cartridge with 8KB of RAM. The program fills kRamAddresses with
+	// $5A and stops at the returned address. From there it stores the
+	// direction buttons to them and ends at done.
+	uint16_t EmitButtonWriter(TestRom& rom, uint16_t& done)
+	{
+		rom.Write(0x147, { 0x03 });		// MBC1 + RAM + battery
+		rom.Write(0x149, { 0x02 });		// 8KB RAM
+
+		rom.Emit(
+		{
+			0xF3,				// DI
+			0x3E, 0x0A,			// LD A, $0A
+			0xEA, 0x00, 0x00,	// LD ($0000), A	Enable cartridge RAM
+			0x3E, 0x5A,			// LD A, $5A
+			0xEA, 0x00, 0xC0,	// LD ($C000), A
+			0xEA, 0x00, 0xD0,	// LD ($D000), A
+			0xEA, 0x00, 0xA0	// LD ($A000), A
+		});
+		const uint16_t fork = rom.Emit(
+		{
+			0x3E, 0x20,			// LD A, $20
+			0xE0, 0x00,			// LDH ($00), A		P1 = directions
+			0xF0, 0x00,			// LDH A, ($00)
+			0xEA, 0x00, 0xC0,	// LD ($C000), A
+			0xEA, 0x00, 0xD0,	// LD ($D000), A
+			0xEA, 0x00, 0xA0	// LD ($A000), A
+		});
+		done = rom.Emit({ 0x18, 0xFE });	// JR done
+
+		return fork;
+	}
+
+	void ExpectRam(gbhw_context_t ctx, uint8_t value)
+	{
+		for(uint16_t address : kRamAddresses)
+			EXPECT_EQ(value, ReadByte(ctx, address)) << "at $" << std::hex << address;
+	}
+
+	std::vector<uint8_t> ReadMemory(gbhw_context_t ctx, uint16_t address, uint32_t length)
+	{
+		std::vector<uint8_t> memory(length);
+		gbhw_read_memory(ctx, address, memory.data(), length);
+		return memory;
+	}
+
+	// Runs a frame, returning every instruction it traced.
+	std::vector<gbhw_trace_record_t> TraceFrame(gbhw_context_t ctx)
+	{
+		std::vector<gbhw_trace_record_t> records;
+
+		gbhw_trace_set_callback(ctx, [](void* userdata, const gbhw_trace_record_t* record)
+		{
+			static_cast<std::vector<gbhw_trace_record_t>*>(userdata)->push_back(*record);
+		}, &records);
+
+		gbhw_step(ctx, step_vsync);
+		gbhw_trace_set_callback(ctx, nullptr, nullptr);
+
+		return records;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Fork
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_FORK, CHILD_WRITES_PRIVATE)
+{
+	// Each context reads a different button, what one writes is never seen
+	// by the others.
+	TestRom rom;
+	uint16_t done = 0;
+	const uint16_t fork = EmitButtonWriter(rom, done);
+
+	TestContext parent = rom.CreateContext();
+	ASSERT_TRUE(RunTo(parent.get(), fork));
+
+	gbhw_context_t children[2] = { nullptr, nullptr };
+	ASSERT_EQ(e_success, gbhw_fork(parent.get(), &children[0]));
+	ASSERT_EQ(e_success, gbhw_fork(parent.get(), &children[1]));
+
+	TestContext first(children[0], &gbhw_destroy);
+	TestContext second(children[1], &gbhw_destroy);
+
+	gbhw_set_button_state(first.get(), button_dpad_right, button_pressed);
+	ASSERT_TRUE(RunTo(first.get(), done));
+
+	ExpectRam(first.get(), 0x0E);
+	ExpectRam(second.get(), 0x5A);
+	ExpectRam(parent.get(), 0x5A);
+
+	gbhw_set_button_state(second.get(), button_dpad_left, button_pressed);
+	ASSERT_TRUE(RunTo(second.get(), done));
+
+	ExpectRam(first.get(), 0x0E);
+	ExpectRam(second.get(), 0x0D);
+	ExpectRam(parent.get(), 0x5A);
+
+	ASSERT_TRUE(RunTo(parent.get(), done));
+
+	ExpectRam(first.get(), 0x0E);
+	ExpectRam(second.get(), 0x0D);
+	ExpectRam(parent.get(), 0x0F);
+}
+
+TEST(HW_FORK, OUTLIVES_PARENT)
+{
+	// The child keeps the RAM it shared with its parent.
+	TestRom rom;
+	uint16_t done = 0;
+	const uint16_t fork = EmitButtonWriter(rom, done);
+
+	TestContext parent = rom.CreateContext();
+	ASSERT_TRUE(RunTo(parent.get(), fork));
+
+	gbhw_context_t child = nullptr;
+	ASSERT_EQ(e_success, gbhw_fork(parent.get(), &child));
+
+	TestContext forked(child, &gbhw_destroy);
+	parent.reset();
+
+	ExpectRam(forked.get(), 0x5A);
+
+	gbhw_set_button_state(forked.get(), button_dpad_up, button_pressed);
+	ASSERT_TRUE(RunTo(forked.get(), done));
+	ExpectRam(forked.get(), 0x0B);
+
+	for(uint32_t frame = 0; frame < 4; frame++)
+		EXPECT_EQ(e_success, gbhw_step(forked.get(), step_vsync));
+
+	ExpectRam(forked.get(), 0x0B);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Copy state
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_FORK, COPY_STATE_ROUND_TRIP)
+{
+	// Stores TIMA to ever increasing addresses of each kind of RAM, resetting
+	// the timer's counter each time. Restoring a copy puts the memory and timer
+	// back and replays the same frame, registers and cycles included.
+	TestRom rom;
+	rom.Write(0x147, { 0x03 });		// MBC1 + RAM + battery
+	rom.Write(0x149, { 0x02 });		// 8KB RAM
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x0A,			// LD A, $0A
+		0xEA, 0x00, 0x00,	// LD ($0000), A	Enable cartridge RAM
+		0x3E, 0x05,			// LD A, $05
+		0xE0, 0x07,			// LDH ($07), A		TAC = enabled, 16 cycles
+		0x21, 0x00, 0xC0,	// LD HL, $C000
+		0x11, 0x00, 0xD0,	// LD DE, $D000
+		0x01, 0x00, 0xA0,	// LD BC, $A000
+		0xF0, 0x05,			// LDH A, ($05)
+		0x22,				// LD (HL+), A
+		0x12,				// LD (DE), A
+		0x13,				// INC DE
+		0x02,				// LD (BC), A
+		0x03,				// INC BC
+		0xE0, 0x04,			// LDH ($04), A		DIV = 0
+		0x18, 0xF5			// JR -11
+	});
+
+	TestContext ctx = rom.CreateContext();
+	TestContext saved = rom.CreateContext();
+
+	gbhw_step(ctx.get(), step_vsync);
+	gbhw_step(ctx.get(), step_vsync);
+	ASSERT_EQ(e_success, gbhw_copy_state(saved.get(), ctx.get()));
+
+	std::vector<uint8_t> memory[2];
+	std::vector<gbhw_trace_record_t> frames[2];
+
+	for(uint32_t run = 0; run < 2; run++)
+	{
+		memory[run] = ReadMemory(ctx.get(), 0x8000, 0x8000);
+		frames[run] = TraceFrame(ctx.get());
+
+		ASSERT_FALSE(memory[run] == ReadMemory(ctx.get(), 0x8000, 0x8000));
+		ASSERT_EQ(e_success, gbhw_copy_state(ctx.get(), saved.get()));
+	}
+
+	EXPECT_TRUE(memory[0] == memory[1]);
+	EXPECT_TRUE(memory[0] == ReadMemory(ctx.get(), 0x8000, 0x8000));
+	ASSERT_EQ(frames[0].size(), frames[1].size());
+	ASSERT_FALSE(frames[0].empty());
+
+	for(size_t i = 0; i < frames[0].size(); i++)
+	{
+		const gbhw_trace_record_t& expected = frames[0][i];
+		const gbhw_trace_record_t& actual = frames[1][i];
+
+		ASSERT_EQ(expected.cycle, actual.cycle) << "instruction " << i;
+		ASSERT_EQ(expected.pc, actual.pc) << "instruction " << i;
+		ASSERT_EQ(expected.af, actual.af) << "instruction " << i;
+		ASSERT_EQ(expected.bc, actual.bc) << "instruction " << i;
+		ASSERT_EQ(expected.de, actual.de) << "instruction " << i;
+		ASSERT_EQ(expected.hl, actual.hl) << "instruction " << i;
+		ASSERT_EQ(expected.sp, actual.sp) << "instruction " << i;
+	}
+}
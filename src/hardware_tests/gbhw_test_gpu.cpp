@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include "gpu.h"
+#include <memory>
+#include <vector>
+
+using namespace gbhw;
+
+namespace
+{
+	// Tile RAM is only ever written, GPUs are created without the rest of
+	// the machine.
+	std::unique_ptr<GPU> CreateGPU()
+	{
+		return std::unique_ptr<GPU>(new GPU());
+	}
+
+	// Tiles and map entries newer than generation.
+	uint32_t CountChanged(const GPUTileRam* ram, uint32_t generation)
+	{
+		uint32_t changed = 0;
+
+		for(uint32_t bank = 0; bank < GPUTileRam::kTileDataBankCount; bank++)
+		{
+			for(uint32_t tile = 0; tile < GPUTileRam::kTileDataCount; tile++)
+				changed += (ram->tileGeneration[bank][tile] > generation) ? 1 : 0;
+		}
+
+		for(uint32_t map = 0; map < GPUTileRam::kTileMapCount; map++)
+		{
+			for(uint32_t entry = 0; entry < GPUTileRam::kTileMapSize; entry++)
+				changed += (ram->mapGeneration[map][entry] > generation) ? 1 : 0;
+		}
+
+		return changed;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Generations
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_GPU, BYTE_WRITE_GENERATIONS)
+{
+	// Writes of what is already there leave every generation alone, real
+	// changes mark just the tile or map entry written.
+	std::unique_ptr<GPU> gpu = CreateGPU();
+	const GPUTileRam* ram = gpu->get_tile_ram();
+
+	gpu->set_tile_ram_data(0x8000, 0x00);
+	gpu->set_tile_ram_data(0x9800, 0x00);
+	EXPECT_EQ(0u, ram->generation);
+
+	gpu->set_tile_ram_data(0x8012, 0x5A);		// Tile 1 row 1, low plane.
+	EXPECT_EQ(1u, ram->generation);
+	EXPECT_EQ(1u, ram->tileGeneration[0][1]);
+	EXPECT_EQ(1u, CountChanged(ram, 0));
+
+	gpu->set_tile_ram_data(0x8012, 0x5A);
+	gpu->set_tile_ram_data(0x8013, 0x00);		// High plane, already clear.
+	EXPECT_EQ(1u, ram->generation);
+
+	gpu->set_tile_ram_data(0x8013, 0x0F);
+	EXPECT_EQ(2u, ram->generation);
+	EXPECT_EQ(2u, ram->tileGeneration[0][1]);
+
+	gpu->set_tile_ram_data(0x9C21, 0x07);		// Map 1, entry 33.
+	EXPECT_EQ(3u, ram->generation);
+	EXPECT_EQ(3u, ram->mapGeneration[1][33]);
+
+	gpu->set_tile_ram_data(0x9C21, 0x07);
+	EXPECT_EQ(3u, ram->generation);
+
+	// VRAM bank 1 holds its own tiles and the map attributes.
+	gpu->set_tile_ram_bank(1);
+	gpu->set_tile_ram_data(0x8012, 0x00);
+	gpu->set_tile_ram_data(0x9C21, 0x00);
+	EXPECT_EQ(3u, ram->generation);
+
+	gpu->set_tile_ram_data(0x8012, 0x5A);
+	EXPECT_EQ(4u, ram->tileGeneration[1][1]);
+	EXPECT_EQ(2u, ram->tileGeneration[0][1]);
+
+	gpu->set_tile_ram_data(0x9C21, 0x08);		// Tile from bank 1.
+	EXPECT_EQ(5u, ram->mapGeneration[1][33]);
+
+	gpu->set_tile_ram_data(0x9C21, 0x08);
+	EXPECT_EQ(5u, ram->generation);
+	EXPECT_EQ(3u, CountChanged(ram, 0));
+}
+
+TEST(HW_GPU, BLOCK_WRITE_GENERATIONS)
+{
+	// DMA blocks take the row at a time path, which must only mark the tiles
+	// whose pixels changed.
+	std::unique_ptr<GPU> gpu = CreateGPU();
+	const GPUTileRam* ram = gpu->get_tile_ram();
+
+	std::vector<uint8_t> block(64, 0);
+	gpu->set_tile_ram_data(0x8000, block.data(), static_cast<uint32_t>(block.size()));
+	EXPECT_EQ(0u, ram->generation);
+
+	block[0x26] = 0x81;							// Tile 2 row 3, low plane.
+	block[0x27] = 0x42;							// High plane.
+	gpu->set_tile_ram_data(0x8000, block.data(), static_cast<uint32_t>(block.size()));
+	EXPECT_EQ(1u, ram->generation);
+	EXPECT_EQ(1u, ram->tileGeneration[0][2]);
+	EXPECT_EQ(1u, CountChanged(ram, 0));
+
+	gpu->set_tile_ram_data(0x8000, block.data(), static_cast<uint32_t>(block.size()));
+	EXPECT_EQ(1u, ram->generation);
+
+	// Blocks starting mid row fall back to bytes until aligned, and may run
+	// on into the tile map.
+	const uint8_t tail[4] = { 0xFF, 0x00, 0xFF, 0x03 };
+	gpu->set_tile_ram_data(0x97FF, tail, 4);
+	const uint32_t generation = ram->generation;
+	EXPECT_GT(generation, 1u);
+	EXPECT_EQ(3u, CountChanged(ram, 1));
+	EXPECT_GT(ram->tileGeneration[0][383], 1u);
+	EXPECT_EQ(0u, ram->mapGeneration[0][0]);
+	EXPECT_GT(ram->mapGeneration[0][1], 1u);
+	EXPECT_GT(ram->mapGeneration[0][2], 1u);
+
+	gpu->set_tile_ram_data(0x97FF, tail, 4);
+	EXPECT_EQ(generation, ram->generation);
+}
+
+TEST(HW_GPU, BLOCK_MATCHES_BYTES)
+{
+	// Both paths decode to the same pixels.
+	std::unique_ptr<GPU> bytes = CreateGPU();
+	std::unique_ptr<GPU> blocks = CreateGPU();
+
+	std::vector<uint8_t> data(0x2000);
+	uint32_t hash = 0x12345678;
+
+	for(uint8_t& value : data)
+	{
+		hash ^= hash << 13;
+		hash ^= hash >> 17;
+		hash ^= hash << 5;
+		value = static_cast<uint8_t>(hash);
+	}
+
+	for(uint32_t i = 0; i < data.size(); i++)
+		bytes->set_tile_ram_data(static_cast<Address>(0x8000 + i), data[i]);
+
+	blocks->set_tile_ram_data(0x8000, data.data(), static_cast<uint32_t>(data.size()));
+
+	const GPUTileRam* expected = bytes->get_tile_ram();
+	const GPUTileRam* actual = blocks->get_tile_ram();
+
+	EXPECT_EQ(0, memcmp(expected->tileData, actual->tileData, sizeof(expected->tileData)));
+	EXPECT_EQ(0, memcmp(expected->tileMap, actual->tileMap, sizeof(expected->tileMap)));
+	EXPECT_EQ(CountChanged(expected, 0), CountChanged(actual, 0));
+}
+
+TEST(HW_GPU, COPY_STATE_GENERATIONS)
+{
+	// Copying in older tile RAM still moves generations forward, so a viewer
+	// redraws everything it copied.
+	std::unique_ptr<GPU> gpu = CreateGPU();
+	std::unique_ptr<GPU> older = CreateGPU();
+
+	for(uint32_t i = 0; i < 32; i++)
+		gpu->set_tile_ram_data(static_cast<Address>(0x8000 + i), static_cast<Byte>(i + 1));
+
+	older->set_tile_ram_data(0x8000, 0xFF);
+
+	const uint32_t generation = gpu->get_tile_ram()->generation;
+	const uint32_t paletteGeneration = gpu->get_palette(GPUPalette::BG)->generation;
+
+	gpu->copy_state(*older);
+
+	const GPUTileRam* ram = gpu->get_tile_ram();
+	EXPECT_GT(ram->generation, generation);
+	EXPECT_EQ(GPUTileRam::kTileDataBankCount * GPUTileRam::kTileDataCount + GPUTileRam::kTileMapCount * GPUTileRam::kTileMapSize,
+			  CountChanged(ram, generation));
+	EXPECT_GT(gpu->get_palette(GPUPalette::BG)->generation, paletteGeneration);
+	EXPECT_EQ(0, memcmp(older->get_tile_ram()->tileData, ram->tileData, sizeof(ram->tileData)));
+}
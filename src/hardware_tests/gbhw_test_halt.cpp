@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// HALT
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_HALT, HALT_BUG)
+{
+	// With interrupts disabled and one pending HALT doesn't halt, and the
+	// byte after it is read twice.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x04,			// LD A, $04
+		0xE0, 0xFF,			// LDH ($FF), A		IE = timer
+		0xE0, 0x0F,			// LDH ($0F), A		IF = timer
+		0x06, 0x00,			// LD B, $00
+		0x76,				// HALT
+		0x04,				// INC B
+		0x78,				// LD A, B
+		0xE0, 0x80			// LDH ($80), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	gbhw_perf_counters_t counters;
+	gbhw_get_perf_counters(ctx.get(), &counters);
+
+	EXPECT_EQ(2, ReadByte(ctx.get(), 0xFF80));
+	EXPECT_EQ(0u, counters.halted_cycles);
+}
+
+TEST(HW_HALT, WAKE_WITHOUT_DISPATCH)
+{
+	// With interrupts disabled an interrupt still ends HALT, but its handler
+	// doesn't run and it stays requested.
+	TestRom rom;
+	rom.Write(0x50,
+	{
+		0x3E, 0xAA,			// LD A, $AA
+		0xE0, 0x81,			// LDH ($81), A
+		0xD9				// RETI
+	});
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0xAF,				// XOR A
+		0xE0, 0x80,			// LDH ($80), A
+		0xE0, 0x81,			// LDH ($81), A
+		0xE0, 0x0F,			// LDH ($0F), A		IF = none
+		0x3E, 0x04,			// LD A, $04
+		0xE0, 0xFF,			// LDH ($FF), A		IE = timer
+		0x3E, 0x05,			// LD A, $05
+		0xE0, 0x07,			// LDH ($07), A		TAC = enabled, 16 cycles
+		0x3E, 0xF0,			// LD A, $F0
+		0xE0, 0x05,			// LDH ($05), A		TIMA
+		0x76,				// HALT
+		0x3E, 0x01,			// LD A, $01
+		0xE0, 0x80			// LDH ($80), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	gbhw_perf_counters_t counters;
+	gbhw_get_perf_counters(ctx.get(), &counters);
+
+	EXPECT_EQ(0x01, ReadByte(ctx.get(), 0xFF80));
+	EXPECT_EQ(0x00, ReadByte(ctx.get(), 0xFF81));
+	EXPECT_EQ(0x04, ReadByte(ctx.get(), 0xFF0F) & 0x04);
+	EXPECT_EQ(0u, counters.interrupts[2]);
+	EXPECT_GT(counters.halted_cycles, 0u);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Halted cycle skipping
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_HALT, SKIP_ENDS_ON_TIMER)
+{
+	// The overflow is two 1024 cycle periods after DIV is reset, which spans
+	// several GPU events the skip also stops at.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x04,			// LD A, $04
+		0xE0, 0xFF,			// LDH ($FF), A		IE = timer
+		0xE0, 0x07,			// LDH ($07), A		TAC = enabled, 1024 cycles
+		0xAF,				// XOR A
+		0xE0, 0x0F			// LDH ($0F), A		IF = none
+	});
+	const uint16_t kReset = rom.Emit({ 0xE0, 0x04 });	// LDH ($04), A		DIV = 0
+	rom.Emit(
+	{
+		0x3E, 0xFE,			// LD A, $FE
+		0xE0, 0x05,			// LDH ($05), A		TIMA
+		0x76				// HALT
+	});
+	const uint16_t kWake = rom.Emit({ 0x00 });			// NOP
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	CycleRecorder recorder(ctx.get());
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	gbhw_perf_counters_t counters;
+	gbhw_get_perf_counters(ctx.get(), &counters);
+
+	EXPECT_EQ(2048u, recorder.GetCycle(kWake) - recorder.GetCycle(kReset));
+	EXPECT_GT(counters.halted_cycles, 0u);
+}
+
+TEST(HW_HALT, SKIP_ENDS_ON_VBLANK)
+{
+	// Halting until V-Blank dispatches the interrupt no later than spinning
+	// would, and less than one spin loop earlier.
+	uint64_t handlerCycles[2];
+
+	for(uint32_t bHalt = 0; bHalt < 2; bHalt++)
+	{
+		TestRom rom;
+		rom.Emit(
+		{
+			0xF3,				// DI
+			0x3E, 0x01,			// LD A, $01
+			0xE0, 0xFF,			// LDH ($FF), A		IE = V-Blank
+			0xAF,				// XOR A
+			0xE0, 0x0F,			// LDH ($0F), A		IF = none
+			0xFB				// EI
+		});
+		rom.Emit(
+		{
+			static_cast<uint8_t>(bHalt ? 0x76 : 0x00),	// HALT or NOP
+			0x18, 0xFD									// JR loop
+		});
+		const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+		rom.Write(0x40,
+		{
+			0xC3, static_cast<uint8_t>(kDone), static_cast<uint8_t>(kDone >> 8)	// JP done
+		});
+
+		TestContext ctx = rom.CreateContext();
+		CycleRecorder recorder(ctx.get());
+		ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+		handlerCycles[bHalt] = recorder.GetCycle(0x40);
+	}
+
+	// A spin loop iteration is 16 cycles.
+	EXPECT_LE(handlerCycles[1], handlerCycles[0]);
+	EXPECT_LT(handlerCycles[0] - handlerCycles[1], 16u);
+}
+
+TEST(HW_HALT, SKIP_ENDS_ON_SERIAL)
+{
+	// An unconnected internal clock transfer completes 8 bits of 512 cycles
+	// after it starts.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x08,			// LD A, $08
+		0xE0, 0xFF,			// LDH ($FF), A		IE = serial
+		0xAF,				// XOR A
+		0xE0, 0x0F,			// LDH ($0F), A		IF = none
+		0x3E, 0x81			// LD A, $81
+	});
+	const uint16_t kStart = rom.Emit({ 0xE0, 0x02 });	// LDH ($02), A		SC = start, internal clock
+	rom.Emit({ 0x76 });									// HALT
+	const uint16_t kWake = rom.Emit({ 0x00 });			// NOP
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	CycleRecorder recorder(ctx.get());
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_EQ(4096u, recorder.GetCycle(kWake) - recorder.GetCycle(kStart));
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF01));
+}
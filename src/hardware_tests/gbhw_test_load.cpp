@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <vector>
+
+namespace
+{
+	const uint32_t kBankSize = 16384;
+
+	// The ROM's bytes, resized to the given number of banks.
+	std::vector<uint8_t> GetData(const TestRom& rom, uint32_t banks)
+	{
+		const gbhw_settings_t settings = rom.GetSettings();
+
+		std::vector<uint8_t> data(settings.rom, settings.rom + settings.rom_size);
+		data.resize(banks * kBankSize, 0);
+		return data;
+	}
+
+	gbhw_errorcode_t Load(gbhw_context_t ctx, const std::vector<uint8_t>& data)
+	{
+		return gbhw_load_rom_memory(ctx, data.data(), static_cast<uint32_t>(data.size()));
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Rejected ROMs
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_LOAD, SHORT_HEADER)
+{
+	TestRom rom;
+	TestContext ctx = rom.CreateContext();
+
+	std::vector<uint8_t> data = GetData(rom, 2);
+	data.resize(0x14F);
+
+	EXPECT_EQ(e_failed, Load(ctx.get(), data));
+}
+
+TEST(HW_LOAD, TOO_MANY_BANKS)
+{
+	// MBC5 addresses 512 banks at most.
+	TestRom rom;
+	TestContext ctx = rom.CreateContext();
+
+	std::vector<uint8_t> data = GetData(rom, 512);
+	EXPECT_EQ(e_success, Load(ctx.get(), data));
+
+	data.push_back(0);
+	EXPECT_EQ(e_failed, Load(ctx.get(), data));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Bank count
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_LOAD, NON_POWER_OF_TWO_BANKS)
+{
+	// Three banks of data are padded to four with open bus, bank numbers past
+	// the last wrap around.
+	TestRom rom;
+	rom.Write(0x147, { 0x01 });		// MBC1
+	rom.Write(0x148, { 0x01 });		// 64KB
+	rom.Emit(
+	{
+		0x3E, 0x03,			// LD A, $03
+		0xEA, 0x00, 0x20,	// LD ($2000), A	ROM bank 3
+		0xFA, 0x00, 0x40,	// LD A, ($4000)
+		0xE0, 0x80,			// LDH ($80), A
+		0x3E, 0x05,			// LD A, $05
+		0xEA, 0x00, 0x20,	// LD ($2000), A	ROM bank 5
+		0xFA, 0x00, 0x40,	// LD A, ($4000)
+		0xE0, 0x81			// LDH ($81), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	std::vector<uint8_t> data = GetData(rom, 3);
+
+	for(uint32_t bank = 1; bank < 3; bank++)
+		data[bank * kBankSize] = static_cast<uint8_t>(bank);
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_EQ(e_success, Load(ctx.get(), data));
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF80));
+	EXPECT_EQ(0x01, ReadByte(ctx.get(), 0xFF81));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Reload
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_LOAD, FAILED_RELOAD_KEEPS_ROM)
+{
+	// The rejected image leaves the running ROM mapped and untouched.
+	TestRom rom;
+	rom.Emit(
+	{
+		0x3E, 0x42,			// LD A, $42
+		0xE0, 0x80			// LDH ($80), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	const std::vector<uint8_t> invalid(16, 0xAA);
+	EXPECT_EQ(e_failed, Load(ctx.get(), invalid));
+
+	for(uint32_t frame = 0; frame < 2; frame++)
+		EXPECT_EQ(e_success, gbhw_step(ctx.get(), step_vsync));
+
+	EXPECT_EQ(0x42, ReadByte(ctx.get(), 0xFF80));
+	EXPECT_EQ(0x18, ReadByte(ctx.get(), kDone));
+	EXPECT_TRUE(RunTo(ctx.get(), kDone));
+}
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <chrono>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const uint32_t kPlayers		= 2;
+	const uint32_t kInputDelay	= 1;
+	const uint32_t kMaxRollback	= 6;
+
+	// Logs the joypad once a frame to $C100 on, and to the first tile so the
+	// screen depends on it too.
+	TestRom CreateInputRom()
+	{
+		TestRom rom;
+		rom.Emit(
+		{
+			0xF3,				// DI
+			0x3E, 0x01,			// LD A, $01
+			0xE0, 0xFF,			// LDH ($FF), A		IE = V-Blank
+			0x21, 0x00, 0xC1,	// LD HL, $C100
+			0x16, 0x80			// LD D, $80
+		});
+		rom.Emit(
+		{
+			0xAF,				// XOR A
+			0xE0, 0x0F,			// LDH ($0F), A		IF = none
+			0x76,				// HALT
+			0x3E, 0x20,			// LD A, $20
+			0xE0, 0x00,			// LDH ($00), A		P1 = directions
+			0xF0, 0x00,			// LDH A, ($00)
+			0xE6, 0x0F,			// AND $0F
+			0xCB, 0x37,			// SWAP A
+			0x47,				// LD B, A
+			0x3E, 0x10,			// LD A, $10
+			0xE0, 0x00,			// LDH ($00), A		P1 = buttons
+			0xF0, 0x00,			// LDH A, ($00)
+			0xE6, 0x0F,			// AND $0F
+			0xB0,				// OR B
+			0x4F,				// LD C, A
+			0x22,				// LD (HL+), A
+			0x7D,				// LD A, L
+			0xE6, 0x0F,			// AND $0F
+			0x5F,				// LD E, A
+			0x79,				// LD A, C
+			0x12,				// LD (DE), A
+			0x18, 0xDE			// JR loop
+		});
+
+		return rom;
+	}
+
+	// Each player holds a few buttons for several frames at a time, so some
+	// predictions hold and some don't.
+	uint8_t GetScriptInput(uint32_t player, uint32_t index)
+	{
+		uint32_t hash = ((index / (5 + (player * 4))) + 1) * 2654435761u;
+		hash ^= player * 0x9E3779B9u;
+		hash ^= hash >> 15;
+		hash *= 0x2C1B3C6Du;
+		hash ^= hash >> 12;
+
+		return static_cast<uint8_t>(hash & (hash >> 8) & 0xFF);
+	}
+
+	uint64_t HashState(gbhw_context_t ctx)
+	{
+		std::vector<uint8_t> memory(0x8000);
+		gbhw_read_memory(ctx, 0x8000, memory.data(), static_cast<uint32_t>(memory.size()));
+
+		const uint8_t* screen = nullptr;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		gbhw_get_screen(ctx, &screen);
+		gbhw_get_screen_resolution(ctx, &width, &height);
+
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		for(uint8_t value : memory)
+			hash = (hash ^ value) * 0x100000001B3ull;
+
+		for(uint32_t i = 0; i < (width * height * 4); i++)
+			hash = (hash ^ screen[i]) * 0x100000001B3ull;
+
+		return hash;
+	}
+
+	struct Peer
+	{
+		TestContext				ctx;
+		gbhw_netplay_t			netplay;
+		std::vector<uint8_t>	inputs;		// Buttons given for each frame emulated, before the input delay.
+		gbhw_netplay_stats_t	stats;
+
+		Peer() : ctx(nullptr, &gbhw_destroy), netplay(nullptr) {}
+	};
+
+	class NetplaySession
+	{
+	public:
+		NetplaySession(uint32_t latencyMs, uint32_t lossPercent)
+			: m_rom(CreateInputRom())
+			, m_loopback(nullptr)
+		{
+			gbhw_loopback_create(latencyMs, lossPercent, &m_loopback);
+
+			for(uint32_t player = 0; player < kPlayers; player++)
+			{
+				Peer& peer = m_peers[player];
+				peer.ctx = m_rom.CreateContext();
+				memset(&peer.stats, 0, sizeof(peer.stats));
+
+				gbhw_netplay_settings_t settings	= {0};
+				settings.player						= player;
+				settings.input_delay				= kInputDelay;
+				settings.max_rollback				= kMaxRollback;
+				gbhw_loopback_get_transport(m_loopback, player, &settings.transport);
+
+				EXPECT_EQ(e_success, gbhw_netplay_create(peer.ctx.get(), &settings, &peer.netplay));
+			}
+		}
+
+		~NetplaySession()
+		{
+			for(Peer& peer : m_peers)
+			{
+				gbhw_netplay_destroy(peer.netplay);
+				peer.netplay = nullptr;
+			}
+
+			gbhw_loopback_destroy(m_loopback);
+		}
+
+		// Returns whether a frame was emulated.
+		bool Advance(uint32_t player, uint32_t scriptFrames)
+		{
+			Peer& peer = m_peers[player];
+			const uint32_t index = static_cast<uint32_t>(peer.inputs.size());
+			const uint8_t buttons = (index < scriptFrames) ? GetScriptInput(player, index) : 0;
+			uint32_t advanced = 0;
+
+			EXPECT_EQ(e_success, gbhw_netplay_advance(peer.netplay, buttons, &advanced));
+			gbhw_netplay_get_stats(peer.netplay, &peer.stats);
+
+			if(advanced)
+				peer.inputs.push_back(buttons);
+
+			return advanced != 0;
+		}
+
+		// Runs both peers a frame at a time until the script is over and both
+		// have confirmed every frame up to the same one, so neither can still
+		// be on a wrong prediction. Past the script a peer that is ahead waits
+		// for the other to catch up.
+		void RunScript(uint32_t scriptFrames)
+		{
+			const uint32_t settled = scriptFrames + kInputDelay + 1;
+
+			for(uint32_t tick = 0; tick < 10000; tick++)
+			{
+				for(uint32_t player = 0; player < kPlayers; player++)
+				{
+					const Peer& peer = m_peers[player];
+
+					if((peer.inputs.size() < scriptFrames) || (peer.stats.frame <= m_peers[player ^ 1].stats.frame))
+						Advance(player, scriptFrames);
+				}
+
+				if((m_peers[0].stats.frame == m_peers[1].stats.frame) &&
+					(m_peers[0].stats.confirmed_frames >= settled) && (m_peers[1].stats.confirmed_frames >= settled))
+				{
+					return;
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			ADD_FAILURE() << "Peers never settled";
+		}
+
+		// Both peers match a single context given the merged input directly.
+		void ExpectReplayed()
+		{
+			const uint32_t frames = m_peers[0].stats.frame;
+			TestContext ctx = m_rom.CreateContext();
+			uint8_t held = 0;
+
+			for(uint32_t frame = 0; frame < frames; frame++)
+			{
+				uint8_t buttons = 0;
+
+				for(const Peer& peer : m_peers)
+				{
+					if(frame >= kInputDelay)
+						buttons |= peer.inputs[frame - kInputDelay];
+				}
+
+				for(uint32_t button = button_a; button <= button_dpad_down; button++)
+				{
+					if((buttons ^ held) & (1 << button))
+						gbhw_set_button_state(ctx.get(), static_cast<gbhw_button_t>(button), (buttons & (1 << button)) ? button_pressed : button_released);
+				}
+
+				held = buttons;
+				gbhw_step(ctx.get(), step_vsync);
+			}
+
+			const uint64_t expected = HashState(ctx.get());
+
+			for(const Peer& peer : m_peers)
+				EXPECT_EQ(expected, HashState(peer.ctx.get()));
+		}
+
+		const gbhw_netplay_stats_t& GetStats(uint32_t player) const
+		{
+			return m_peers[player].stats;
+		}
+
+	private:
+		TestRom				m_rom;
+		gbhw_loopback_t		m_loopback;
+		Peer				m_peers[kPlayers];
+	};
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Rollback
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_NETPLAY, MATCHES_REPLAY)
+{
+	// Late and lost input is mispredicted and rolled back, both peers still
+	// end up where one machine given both players' input would.
+	NetplaySession session(8, 20);
+	session.RunScript(240);
+	session.ExpectReplayed();
+
+	for(uint32_t player = 0; player < kPlayers; player++)
+	{
+		const gbhw_netplay_stats_t& stats = session.GetStats(player);
+
+		EXPECT_GT(stats.rollbacks, 0u);
+		EXPECT_LE(stats.max_rollback_frames, kMaxRollback);
+	}
+}
+
+TEST(HW_NETPLAY, STALLS_WITHOUT_PEER)
+{
+	// A peer that stops sending lets the other run the rollback window ahead
+	// of the input it has, then hold.
+	NetplaySession session(0, 0);
+	uint32_t advanced = 0;
+
+	for(uint32_t i = 0; i < 20; i++)
+		advanced += session.Advance(0, 60) ? 1 : 0;
+
+	EXPECT_EQ(kInputDelay + kMaxRollback, advanced);
+	EXPECT_EQ(20 - advanced, session.GetStats(0).stalls);
+
+	// Once the peer is back both carry on and agree.
+	session.RunScript(60);
+	session.ExpectReplayed();
+}
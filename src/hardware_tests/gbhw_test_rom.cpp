@@ -0,0 +1,120 @@
+#include "gbhw_test_rom.h"
+
+namespace
+{
+	const uint32_t kRomSize			= 0x8000;
+	const uint16_t kEntryPoint		= 0x100;
+	const uint16_t kHWTypeOffset	= 0x143;
+	const uint16_t kProgramStart	= 0x150;
+}
+
+//------------------------------------------------------------------------------
+
+TestRom::TestRom(bool bColour)
+	: m_data(kRomSize, 0)
+	, m_address(kProgramStart)
+{
+	Write(kEntryPoint,
+	{
+		0x00,				// NOP
+		0xC3, 0x50, 0x01	// JP $0150
+	});
+
+	// Cartridge type, ROM and RAM sizes are left zero for a 32KB ROM only.
+	m_data[kHWTypeOffset] = bColour ? 0x80 : 0x00;
+}
+
+uint16_t TestRom::Emit(std::initializer_list<uint8_t> bytes)
+{
+	const uint16_t address = m_address;
+
+	Write(m_address, bytes);
+	m_address += static_cast<uint16_t>(bytes.size());
+	return address;
+}
+
+uint16_t TestRom::GetAddress() const
+{
+	return m_address;
+}
+
+void TestRom::Write(uint16_t address, std::initializer_list<uint8_t> bytes)
+{
+	for(uint8_t byte : bytes)
+		m_data[address++] = byte;
+}
+
+gbhw_settings_t TestRom::GetSettings() const
+{
+	gbhw_settings_t settings	= {0};
+	settings.rom				= m_data.data();
+	settings.rom_size			= static_cast<uint32_t>(m_data.size());
+	settings.log_level			= l_disabled;
+
+	return settings;
+}
+
+TestContext TestRom::CreateContext() const
+{
+	gbhw_settings_t settings = GetSettings();
+	gbhw_context_t ctx = nullptr;
+
+	gbhw_create(&settings, &ctx);
+	return TestContext(ctx, &gbhw_destroy);
+}
+
+//------------------------------------------------------------------------------
+
+const uint64_t CycleRecorder::kNotRun;
+
+CycleRecorder::CycleRecorder(gbhw_context_t ctx)
+	: m_ctx(ctx)
+	, m_cycles(0x10000, kNotRun)
+{
+	gbhw_trace_set_callback(m_ctx, &CycleRecorder::OnInstruction, this);
+}
+
+CycleRecorder::~CycleRecorder()
+{
+	gbhw_trace_set_callback(m_ctx, nullptr, nullptr);
+}
+
+uint64_t CycleRecorder::GetCycle(uint16_t address) const
+{
+	return m_cycles[address];
+}
+
+void CycleRecorder::OnInstruction(void* userdata, const gbhw_trace_record_t* record)
+{
+	static_cast<CycleRecorder*>(userdata)->m_cycles[record->pc] = record->cycle;
+}
+
+//------------------------------------------------------------------------------
+
+bool RunTo(gbhw_context_t ctx, uint16_t address, uint32_t frames)
+{
+	bool bReached = false;
+
+	gbhw_add_breakpoint(ctx, address, -1);
+
+	for(uint32_t frame = 0; (frame < frames) && !bReached; frame++)
+	{
+		gbhw_break_t info;
+
+		if(gbhw_step(ctx, step_vsync) != e_success)
+			break;
+
+		gbhw_get_break(ctx, &info);
+		bReached = (info.reason == break_execute) && (info.address == address);
+	}
+
+	gbhw_remove_breakpoint(ctx, address, -1);
+	return bReached;
+}
+
+uint8_t ReadByte(gbhw_context_t ctx, uint16_t address)
+{
+	uint8_t value = 0;
+	gbhw_read_memory(ctx, address, &value, 1);
+	return value;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <gbhw.h>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+typedef std::unique_ptr<gbhw_context, void(*)(gbhw_context_t)> TestContext;
+
+// 32KB ROM only cartridge for tests that run the whole machine. The program is
+// assembled by hand from 0x150 on, the cartridge entry point jumps straight
+// to it.
+class TestRom
+{
+public:
+	explicit TestRom(bool bColour = false);
+
+	// Appends to the program, returns the address of the first byte.
+	uint16_t Emit(std::initializer_list<uint8_t> bytes);
+	uint16_t GetAddress() const;
+
+	// Places bytes anywhere else, such as an interrupt handler.
+	void Write(uint16_t address, std::initializer_list<uint8_t> bytes);
+
+	// Settings loading the ROM, valid while the TestRom is.
+	gbhw_settings_t GetSettings() const;
+	TestContext CreateContext() const;
+
+private:
+	std::vector<uint8_t>	m_data;
+	uint16_t				m_address;
+};
+
+// Records the CPU cycle each instruction started on, by address. An address
+// run more than once keeps its latest cycle.
+class CycleRecorder
+{
+public:
+	static const uint64_t kNotRun = ~0ull;
+
+	explicit CycleRecorder(gbhw_context_t ctx);
+	~CycleRecorder();
+
+	uint64_t GetCycle(uint16_t address) const;
+
+private:
+	static void OnInstruction(void* userdata, const gbhw_trace_record_t* record);
+
+	gbhw_context_t			m_ctx;
+	std::vector<uint64_t>	m_cycles;
+};
+
+// Runs until the instruction at address is next, false if that takes longer
+// than the given number of frames.
+bool RunTo(gbhw_context_t ctx, uint16_t address, uint32_t frames = 60);
+
+uint8_t ReadByte(gbhw_context_t ctx, uint16_t address);
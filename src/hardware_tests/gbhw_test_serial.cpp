@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include <chrono>
+#include <thread>
+
+namespace
+{
+	// Sends value, stores the byte received to result. The master drives the
+	// clock after a 4096 cycle delay, long enough for the slave to be waiting.
+	void EmitTransfer(TestRom& rom, uint8_t value, bool bMaster, uint8_t result)
+	{
+		if(bMaster)
+		{
+			rom.Emit(
+			{
+				0x06, 0x00,			// LD B, $00
+				0x05,				// DEC B
+				0x20, 0xFD			// JR NZ, -3
+			});
+		}
+
+		rom.Emit(
+		{
+			0x3E, value,								// LD A, value
+			0xE0, 0x01,									// LDH ($01), A		SB
+			0x3E, static_cast<uint8_t>(bMaster ? 0x81 : 0x80),	// LD A, $81 or $80
+			0xE0, 0x02,									// LDH ($02), A		SC = start, internal or external clock
+			0xF0, 0x02,									// LDH A, ($02)
+			0xE6, 0x80,									// AND $80
+			0x20, 0xFA,									// JR NZ, -6
+			0xF0, 0x01,									// LDH A, ($01)
+			0xE0, result								// LDH (result), A
+		});
+	}
+
+	// Each side masters one transfer and is the slave for the other.
+	TestRom CreateLinkRom(bool bFirst, uint16_t& done)
+	{
+		TestRom rom;
+		rom.Emit({ 0xF3 });		// DI
+		EmitTransfer(rom, bFirst ? 0x11 : 0x22, bFirst, 0x80);
+		EmitTransfer(rom, bFirst ? 0x33 : 0x44, !bFirst, 0x81);
+		done = rom.Emit({ 0x18, 0xFE });	// JR done
+
+		return rom;
+	}
+
+	struct LinkResult
+	{
+		uint8_t		received[2][2];
+		uint64_t	doneCycle[2];
+	};
+
+	// Runs both sides to done on their own threads, one starting late.
+	LinkResult RunLinked(uint32_t lateSide)
+	{
+		uint16_t done[2];
+		const TestRom roms[2] = { CreateLinkRom(true, done[0]), CreateLinkRom(false, done[1]) };
+
+		TestContext contexts[2] = { roms[0].CreateContext(), roms[1].CreateContext() };
+		EXPECT_EQ(e_success, gbhw_serial_connect(contexts[0].get(), contexts[1].get()));
+
+		LinkResult result;
+		std::thread threads[2];
+
+		for(uint32_t side = 0; side < 2; side++)
+		{
+			threads[side] = std::thread([&, side]()
+			{
+				CycleRecorder recorder(contexts[side].get());
+
+				if(side == lateSide)
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+				EXPECT_TRUE(RunTo(contexts[side].get(), done[side]));
+				result.doneCycle[side] = recorder.GetCycle(done[side]);
+			});
+		}
+
+		for(std::thread& thread : threads)
+			thread.join();
+
+		for(uint32_t side = 0; side < 2; side++)
+		{
+			result.received[side][0] = ReadByte(contexts[side].get(), 0xFF80);
+			result.received[side][1] = ReadByte(contexts[side].get(), 0xFF81);
+		}
+
+		return result;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Unconnected
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_SERIAL, UNCONNECTED_TRANSFER)
+{
+	// Nothing answers an internal clock transfer, it receives 0xFF.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0x3E, 0x08,			// LD A, $08
+		0xE0, 0xFF,			// LDH ($FF), A		IE = serial
+		0xAF,				// XOR A
+		0xE0, 0x0F,			// LDH ($0F), A		IF = none
+		0x3E, 0x42,			// LD A, $42
+		0xE0, 0x01,			// LDH ($01), A		SB
+		0x3E, 0x81,			// LD A, $81
+		0xE0, 0x02,			// LDH ($02), A		SC = start, internal clock
+		0x76				// HALT
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF01));
+	EXPECT_EQ(0x00, ReadByte(ctx.get(), 0xFF02) & 0x80);
+	EXPECT_EQ(0x08, ReadByte(ctx.get(), 0xFF0F) & 0x08);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Link cable
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_SERIAL, EXCHANGE)
+{
+	// Bytes cross in both directions whichever side's thread gets ahead, and
+	// each side finishes on the same cycle.
+	LinkResult results[3];
+
+	for(uint32_t late = 0; late < 3; late++)
+		results[late] = RunLinked(late);
+
+	for(const LinkResult& result : results)
+	{
+		EXPECT_EQ(0x22, result.received[0][0]);
+		EXPECT_EQ(0x44, result.received[0][1]);
+		EXPECT_EQ(0x11, result.received[1][0]);
+		EXPECT_EQ(0x33, result.received[1][1]);
+
+		EXPECT_EQ(results[0].doneCycle[0], result.doneCycle[0]);
+		EXPECT_EQ(results[0].doneCycle[1], result.doneCycle[1]);
+	}
+}
+
+TEST(HW_SERIAL, DISCONNECT_RELEASES_WAIT)
+{
+	// The master waits at the end of its transfer for a side that never runs,
+	// until that side disconnects. It then completes unanswered.
+	TestRom rom;
+	rom.Emit({ 0xF3 });		// DI
+	EmitTransfer(rom, 0x11, true, 0x80);
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext master = rom.CreateContext();
+	TestContext other = rom.CreateContext();
+	ASSERT_EQ(e_success, gbhw_serial_connect(master.get(), other.get()));
+
+	bool bReached = false;
+	std::thread thread([&]()
+	{
+		bReached = RunTo(master.get(), kDone);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_EQ(e_success, gbhw_serial_disconnect(other.get()));
+	thread.join();
+
+	EXPECT_TRUE(bReached);
+	EXPECT_EQ(0xFF, ReadByte(master.get(), 0xFF80));
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+
+namespace
+{
+	const uint32_t kFrames = 4;
+
+	// Optionally switches speed, then spins. Returns the CPU cycles run per
+	// frame from then on.
+	uint64_t GetFrameCycles(bool bColour, bool bSwitch)
+	{
+		TestRom rom(bColour);
+		rom.Emit({ 0xF3 });		// DI
+
+		if(bSwitch)
+		{
+			rom.Emit(
+			{
+				0x3E, 0x01,			// LD A, $01
+				0xE0, 0x4D,			// LDH ($4D), A		KEY1 = prepare speed switch
+				0x10, 0x00			// STOP
+			});
+		}
+
+		const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+		TestContext ctx = rom.CreateContext();
+		EXPECT_TRUE(RunTo(ctx.get(), kDone));
+
+		gbhw_perf_counters_t start;
+		gbhw_perf_counters_t end;
+
+		// Finish the frame the break was in, then count whole frames.
+		gbhw_step(ctx.get(), step_vsync);
+		gbhw_get_perf_counters(ctx.get(), &start);
+
+		for(uint32_t frame = 0; frame < kFrames; frame++)
+			gbhw_step(ctx.get(), step_vsync);
+
+		gbhw_get_perf_counters(ctx.get(), &end);
+		return (end.cycles - start.cycles) / kFrames;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Speed switch
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_SPEED, DOUBLE_SPEED_ON_CGB)
+{
+	// Frames take as long, the CPU runs two cycles for every GPU cycle. A
+	// frame can end up to one spin loop iteration apart.
+	const uint64_t normal = GetFrameCycles(true, false);
+	const uint64_t doubled = GetFrameCycles(true, true);
+
+	EXPECT_NEAR(static_cast<double>(normal * 2), static_cast<double>(doubled), 12.0);
+}
+
+TEST(HW_SPEED, NO_SWITCH_ON_DMG)
+{
+	const uint64_t normal = GetFrameCycles(false, false);
+	const uint64_t switched = GetFrameCycles(false, true);
+
+	EXPECT_NEAR(static_cast<double>(normal), static_cast<double>(switched), 12.0);
+}
+
+TEST(HW_SPEED, DMG_KEY1)
+{
+	// DMG has no KEY1, it reads 0xFF whatever is written.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF0, 0x4D,			// LDH A, ($4D)
+		0xE0, 0x80,			// LDH ($80), A
+		0xAF,				// XOR A
+		0xE0, 0x4D,			// LDH ($4D), A
+		0xF0, 0x4D,			// LDH A, ($4D)
+		0xE0, 0x81			// LDH ($81), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF80));
+	EXPECT_EQ(0xFF, ReadByte(ctx.get(), 0xFF81));
+}
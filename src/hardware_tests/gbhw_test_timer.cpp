@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+
+namespace
+{
+	void EmitNops(TestRom& rom, uint32_t count)
+	{
+		for(uint32_t i = 0; i < count; i++)
+			rom.Emit({ 0x00 });		// NOP
+	}
+
+	void CheckTimaOverflow(bool bDoubleSpeed)
+	{
+		// TIMA is two 16 cycle periods from overflowing once DIV is reset. It
+		// counts CPU cycles, so the timings are the same at either speed.
+		TestRom rom(bDoubleSpeed);
+		rom.Emit({ 0xF3 });				// DI
+
+		if(bDoubleSpeed)
+		{
+			rom.Emit(
+			{
+				0x3E, 0x01,			// LD A, $01
+				0xE0, 0x4D,			// LDH ($4D), A		KEY1 = prepare speed switch
+				0x10, 0x00			// STOP
+			});
+		}
+
+		rom.Emit(
+		{
+			0x3E, 0x04,			// LD A, $04
+			0xE0, 0xFF,			// LDH ($FF), A		IE = timer
+			0x3E, 0xA0,			// LD A, $A0
+			0xE0, 0x06,			// LDH ($06), A		TMA
+			0x3E, 0x05,			// LD A, $05
+			0xE0, 0x07,			// LDH ($07), A		TAC = enabled, 16 cycles
+			0xAF,				// XOR A
+			0xE0, 0x0F,			// LDH ($0F), A		IF = none
+			0x3E, 0xFE			// LD A, $FE
+		});
+		const uint16_t kReset = rom.Emit({ 0xE0, 0x04 });	// LDH ($04), A		DIV = 0
+		rom.Emit(
+		{
+			0xE0, 0x05,			// LDH ($05), A		TIMA
+			0x76				// HALT
+		});
+		const uint16_t kWake = rom.Emit({ 0xF0, 0x05 });	// LDH A, ($05)
+		rom.Emit(
+		{
+			0xE0, 0x80,			// LDH ($80), A
+			0x00, 0x00, 0x00,	// NOP x 3
+		});
+		const uint16_t kRead = rom.Emit({ 0xF0, 0x05 });	// LDH A, ($05)
+		rom.Emit({ 0xE0, 0x81 });							// LDH ($81), A
+		const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+		TestContext ctx = rom.CreateContext();
+		CycleRecorder recorder(ctx.get());
+		ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+		if(bDoubleSpeed)
+		{
+			ASSERT_EQ(0x80, ReadByte(ctx.get(), 0xFF4D) & 0x80);
+		}
+
+		const uint64_t overflow = recorder.GetCycle(kWake);
+
+		// The overflow reloads TMA and requests the interrupt on the tick
+		// that takes TIMA past 0xFF.
+		EXPECT_EQ(32u, overflow - recorder.GetCycle(kReset));
+		EXPECT_EQ(0xA0, ReadByte(ctx.get(), 0xFF80));
+		EXPECT_EQ(0x04, ReadByte(ctx.get(), 0xFF0F) & 0x04);
+
+		// Counting carries on from TMA.
+		EXPECT_EQ(0xA0 + ((recorder.GetCycle(kRead) - overflow) / 16), ReadByte(ctx.get(), 0xFF81));
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DIV
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_TIMER, DIV_RESET_ON_WRITE)
+{
+	TestRom rom;
+	rom.Emit(
+	{
+		0x06, 0x00,			// LD B, $00
+		0x05,				// DEC B
+		0x20, 0xFD,			// JR NZ, -3
+		0xF0, 0x04,			// LDH A, ($04)
+		0xE0, 0x80			// LDH ($80), A
+	});
+
+	// Any value written resets the internal counter, the read 252 cycles
+	// later is still in the first DIV period and the one 268 cycles later
+	// isn't.
+	rom.Emit(
+	{
+		0x3E, 0xFF,			// LD A, $FF
+		0xE0, 0x04			// LDH ($04), A
+	});
+	EmitNops(rom, 60);
+	rom.Emit(
+	{
+		0xF0, 0x04,			// LDH A, ($04)
+		0x47,				// LD B, A
+		0xF0, 0x04,			// LDH A, ($04)
+		0xE0, 0x82,			// LDH ($82), A
+		0x78,				// LD A, B
+		0xE0, 0x81			// LDH ($81), A
+	});
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	EXPECT_GE(ReadByte(ctx.get(), 0xFF80), 0x10);
+	EXPECT_EQ(0x00, ReadByte(ctx.get(), 0xFF81));
+	EXPECT_EQ(0x01, ReadByte(ctx.get(), 0xFF82));
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// TIMA
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_TIMER, TAC_PERIOD_CHANGE)
+{
+	// TIMA keeps the ticks counted at 16 cycles, then counts the 64 cycle
+	// periods of the internal counter from the change on.
+	TestRom rom;
+	rom.Emit(
+	{
+		0xF3,				// DI
+		0xAF,				// XOR A
+		0xE0, 0x06,			// LDH ($06), A		TMA
+		0x3E, 0x05,			// LD A, $05
+		0xE0, 0x07,			// LDH ($07), A		TAC = enabled, 16 cycles
+		0xAF				// XOR A
+	});
+	const uint16_t kReset = rom.Emit({ 0xE0, 0x04 });	// LDH ($04), A		DIV = 0
+	rom.Emit({ 0xE0, 0x05 });							// LDH ($05), A		TIMA = 0
+	EmitNops(rom, 37);
+	rom.Emit({ 0x3E, 0x06 });							// LD A, $06
+	const uint16_t kChange = rom.Emit({ 0xE0, 0x07 });	// LDH ($07), A		TAC = enabled, 64 cycles
+	EmitNops(rom, 50);
+	const uint16_t kRead = rom.Emit({ 0xF0, 0x05 });	// LDH A, ($05)
+	rom.Emit({ 0xE0, 0x80 });							// LDH ($80), A
+	const uint16_t kDone = rom.Emit({ 0x18, 0xFE });	// JR done
+
+	TestContext ctx = rom.CreateContext();
+	CycleRecorder recorder(ctx.get());
+	ASSERT_TRUE(RunTo(ctx.get(), kDone));
+
+	const uint64_t change	= recorder.GetCycle(kChange) - recorder.GetCycle(kReset);
+	const uint64_t read		= recorder.GetCycle(kRead) - recorder.GetCycle(kReset);
+	const uint64_t expected	= (change / 16) + ((read / 64) - (change / 64));
+
+	// Had the change been ignored or applied from the start, TIMA would differ.
+	ASSERT_NE(read / 16, expected);
+	ASSERT_NE(read / 64, expected);
+	EXPECT_EQ(expected, ReadByte(ctx.get(), 0xFF80));
+}
+
+TEST(HW_TIMER, TIMA_OVERFLOW_SINGLE_SPEED)
+{
+	CheckTimaOverflow(false);
+}
+
+TEST(HW_TIMER, TIMA_OVERFLOW_DOUBLE_SPEED)
+{
+	CheckTimaOverflow(true);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include "gbhw_test_rom.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace gbhw;
+
+namespace
+{
+	const uint32_t kBankSize = 16384;
+
+	TraceRecord MakeRecord(uint64_t cycle, uint16_t pc, uint16_t bank)
+	{
+		TraceRecord record;
+		memset(&record, 0, sizeof(record));
+		record.cycle	= cycle;
+		record.pc		= pc;
+		record.bank		= bank;
+		return record;
+	}
+
+	void ExpectRecord(const TraceRecord& expected, const TraceRecord& actual, size_t index)
+	{
+		EXPECT_EQ(expected.cycle, actual.cycle) << "record " << index;
+		EXPECT_EQ(expected.pc, actual.pc) << "record " << index;
+		EXPECT_EQ(expected.bank, actual.bank) << "record " << index;
+		EXPECT_EQ(expected.af, actual.af) << "record " << index;
+		EXPECT_EQ(expected.bc, actual.bc) << "record " << index;
+		EXPECT_EQ(expected.de, actual.de) << "record " << index;
+		EXPECT_EQ(expected.hl, actual.hl) << "record " << index;
+		EXPECT_EQ(expected.sp, actual.sp) << "record " << index;
+
+		for(uint32_t i = 0; i < 4; i++)
+			EXPECT_EQ(expected.mem[i], actual.mem[i]) << "record " << index << " mem[" << i << "]";
+	}
+
+	std::vector<TraceRecord> ReadTrace(const std::string& path)
+	{
+		std::vector<TraceRecord> records;
+		TraceReader reader;
+		TraceRecord record;
+
+		EXPECT_TRUE(reader.open(path.c_str()));
+
+		while(reader.read(record))
+			records.push_back(record);
+
+		return records;
+	}
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Encoding
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_TRACE, ROUND_TRIP)
+{
+	// Every field changing alone and together, PC jumping both ways, cycle
+	// deltas from none to past 32 bits and banks past a byte.
+	std::vector<TraceRecord> records;
+	records.push_back(MakeRecord(0, 0x0100, 0));
+	records.push_back(MakeRecord(0, 0x0100, 0));
+	records.push_back(MakeRecord(4, 0x0150, 1));
+	records.push_back(MakeRecord(12, 0x4000, 300));
+	records.push_back(MakeRecord(16, 0x0038, 300));
+	records.push_back(MakeRecord(0x123456789Aull, 0xFFFE, 511));
+	records.push_back(MakeRecord(0x123456789Eull, 0x0000, 256));
+
+	records[2].af		= 0x01B0;
+	records[3].bc		= 0x0013;
+	records[3].mem[0]	= 0xC3;
+	records[3].mem[1]	= 0x00;
+	records[3].mem[2]	= 0x40;
+	records[4].de		= 0x00D8;
+	records[4].hl		= 0x014D;
+	records[5].sp		= 0xFFFE;
+	records[5].mem[0]	= 0xCB;
+	records[5].mem[3]	= 0x7F;
+	records[6].af		= 0xFFFF;
+	records[6].bc		= 0xFFFF;
+	records[6].de		= 0xFFFF;
+	records[6].hl		= 0xFFFF;
+	records[6].sp		= 0x0000;
+	records[6].mem[1]	= 0xFF;
+
+	const std::string path = ::testing::TempDir() + "gbhw_test_trace_round_trip.gbtr";
+
+	TraceWriter writer;
+	ASSERT_TRUE(writer.open(path.c_str()));
+
+	for(const TraceRecord& record : records)
+	{
+		*writer.acquire() = record;
+		writer.commit();
+	}
+
+	writer.close();
+
+	const std::vector<TraceRecord> decoded = ReadTrace(path);
+	remove(path.c_str());
+
+	ASSERT_EQ(records.size(), decoded.size());
+
+	for(size_t i = 0; i < records.size(); i++)
+		ExpectRecord(records[i], decoded[i], i);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Emulation
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+TEST(HW_TRACE, BANK_ABOVE_255)
+{
+	// An 8MB MBC5 cartridge jumps into bank 300, which the trace keeps whole.
+	TestRom rom;
+	rom.Write(0x147, { 0x19 });		// MBC5
+	rom.Write(0x148, { 0x08 });		// 8MB
+	rom.Emit(
+	{
+		0x3E, 0x2C,			// LD A, $2C
+		0xEA, 0x00, 0x20,	// LD ($2000), A	ROM bank low = $2C
+		0x3E, 0x01,			// LD A, $01
+		0xEA, 0x00, 0x30,	// LD ($3000), A	ROM bank high = 1
+		0xC3, 0x00, 0x40	// JP $4000
+	});
+
+	const gbhw_settings_t settings = rom.GetSettings();
+	std::vector<uint8_t> data(settings.rom, settings.rom + settings.rom_size);
+	data.resize(512 * kBankSize, 0);
+	data[300 * kBankSize]		= 0x18;		// JR -2
+	data[300 * kBankSize + 1]	= 0xFE;
+
+	TestContext ctx = rom.CreateContext();
+	ASSERT_EQ(e_success, gbhw_load_rom_memory(ctx.get(), data.data(), static_cast<uint32_t>(data.size())));
+
+	const std::string path = ::testing::TempDir() + "gbhw_test_trace_bank.gbtr";
+	ASSERT_EQ(e_success, gbhw_trace_start(ctx.get(), path.c_str()));
+	gbhw_step(ctx.get(), step_vsync);
+	ASSERT_EQ(e_success, gbhw_trace_stop(ctx.get()));
+
+	const std::vector<TraceRecord> records = ReadTrace(path);
+	remove(path.c_str());
+
+	uint32_t banked = 0;
+
+	for(const TraceRecord& record : records)
+	{
+		if(record.pc == 0x4000)
+		{
+			EXPECT_EQ(300, record.bank);
+			EXPECT_EQ(0x18, record.mem[0]);
+			banked++;
+		}
+	}
+
+	EXPECT_GT(banked, 0u);
+}
@@ -0,0 +1,180 @@
+#include <gbhw.h>
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	void print_usage()
+	{
+		printf("Records and decodes lossless frame captures.\n");
+		printf("\tUsage: EXE record <ROM PATH> <CAPTURE PATH> [FRAMES]\n");
+		printf("\t       EXE decode <CAPTURE PATH> [PPM PREFIX] [2x|3x|4x|scale2x]\n");
+		printf("\n");
+		printf("record runs the ROM headless for FRAMES frames (default 3600) into a capture.\n");
+		printf("decode verifies a capture and prints its statistics. With a prefix every\n");
+		printf("frame is also written as PREFIX<frame number>.ppm, optionally upscaled.\n");
+	}
+
+	bool parse_scaler(const char* name, gbhw_scaler_t& scaler)
+	{
+		static const char* kNames[] = { "2x", "3x", "4x", "scale2x" };
+
+		for(uint32_t i = 0; i < 4; i++)
+		{
+			if(strcmp(name, kNames[i]) == 0)
+			{
+				scaler = static_cast<gbhw_scaler_t>(i);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool write_ppm(const char* prefix, uint64_t number, const uint32_t* pixels, uint32_t width, uint32_t height)
+	{
+		char path[1024];
+		snprintf(path, sizeof(path), "%s%06" PRIu64 ".ppm", prefix, number);
+
+		FILE* file = fopen(path, "wb");
+
+		if(!file)
+			return false;
+
+		fprintf(file, "P6\n%u %u\n255\n", width, height);
+
+		// Screen pixels are stored x, r, g, b in memory.
+		const Byte* bytes = reinterpret_cast<const Byte*>(pixels);
+
+		for(uint32_t i = 0; i < (width * height); i++)
+			fwrite(&bytes[(i * 4) + 1], 1, 3, file);
+
+		fclose(file);
+		return true;
+	}
+
+	//--------------------------------------------------------------------------
+
+	int record(const char* romPath, const char* capturePath, uint64_t frames)
+	{
+		gbhw_context_t ctx			= nullptr;
+		gbhw_settings_t settings	= {0};
+		settings.log_level			= l_disabled;
+
+		if((gbhw_create(&settings, &ctx) != e_success) || (gbhw_load_rom_file(ctx, romPath) != e_success))
+		{
+			printf("Failed to load ROM '%s'\n", romPath);
+			gbhw_destroy(ctx);
+			return -1;
+		}
+
+		// Nothing is watching, so take as long as compression needs rather
+		// than lose frames.
+		if(gbhw_capture_start(ctx, capturePath, capture_wait) != e_success)
+		{
+			printf("Failed to open capture '%s'\n", capturePath);
+			gbhw_destroy(ctx);
+			return -1;
+		}
+
+		int result = 0;
+
+		for(uint64_t i = 0; i < frames; i++)
+		{
+			if(gbhw_step(ctx, step_vsync) != e_success)
+			{
+				printf("Hardware failed after %" PRIu64 " frames\n", i);
+				result = 1;
+				break;
+			}
+		}
+
+		uint64_t dropped = 0;
+		gbhw_capture_get_dropped(ctx, &dropped);
+		gbhw_destroy(ctx);
+
+		printf("Recorded %" PRIu64 " frames, %" PRIu64 " dropped\n", frames, dropped);
+		return result;
+	}
+
+	int decode(const char* capturePath, const char* prefix, const char* scalerName)
+	{
+		gbhw_scaler_t scaler	= scaler_nearest_2x;
+		uint32_t factor			= 1;
+
+		if(scalerName && (!parse_scaler(scalerName, scaler) || (gbhw_get_scaler_factor(scaler, &factor) != e_success)))
+		{
+			printf("Unknown scaler '%s'\n", scalerName);
+			return -1;
+		}
+
+		CaptureReader reader;
+
+		if(!reader.open(capturePath))
+		{
+			printf("Failed to open capture '%s'\n", capturePath);
+			return -1;
+		}
+
+		std::vector<uint32_t> pixels(kCapturePixels);
+		std::vector<uint32_t> scaled(kCapturePixels * factor * factor);
+		uint64_t number = 0;
+		uint64_t frames = 0;
+		uint64_t last = 0;
+		uint64_t dropped = 0;
+
+		while(reader.read(number, &pixels[0]))
+		{
+			dropped += number - last - 1;
+			last = number;
+			frames++;
+
+			const uint32_t* output = &pixels[0];
+
+			if(scalerName)
+			{
+				gbhw_scale_screen(reinterpret_cast<const uint8_t*>(&pixels[0]), kCaptureWidth, kCaptureHeight, scaler,
+								  reinterpret_cast<uint8_t*>(&scaled[0]), kCaptureWidth * factor);
+				output = &scaled[0];
+			}
+
+			if(prefix && !write_ppm(prefix, number, output, kCaptureWidth * factor, kCaptureHeight * factor))
+			{
+				printf("Failed to write frame %" PRIu64 "\n", number);
+				return -1;
+			}
+		}
+
+		FILE* file = fopen(capturePath, "rb");
+		fseek(file, 0, SEEK_END);
+		const uint64_t size = static_cast<uint64_t>(ftell(file));
+		fclose(file);
+
+		const uint64_t rawSize = frames * kCapturePixels * sizeof(uint32_t);
+
+		printf("Decoded %" PRIu64 " frames, %" PRIu64 " dropped\n", frames, dropped);
+		printf("%" PRIu64 " bytes, %.1f bytes/frame, %.1fx smaller than raw\n",
+			   size, frames ? static_cast<double>(size) / frames : 0.0, size ? static_cast<double>(rawSize) / size : 0.0);
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	if((argc >= 4) && (strcmp(args[1], "record") == 0))
+		return record(args[2], args[3], (argc >= 5) ? strtoull(args[4], nullptr, 10) : 3600);
+
+	if((argc >= 3) && (strcmp(args[1], "decode") == 0))
+		return decode(args[2], (argc >= 4) ? args[3] : nullptr, (argc >= 5) ? args[4] : nullptr);
+
+	print_usage();
+	return -1;
+}
@@ -0,0 +1,260 @@
+#include <gbhw.h>
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const uint32_t kPlayers = 2;
+
+	struct Peer
+	{
+		gbhw_context_t			ctx;
+		gbhw_netplay_t			netplay;
+		std::vector<uint8_t>	inputs;			// Buttons given for each frame emulated, before the input delay.
+		gbhw_netplay_stats_t	stats;
+		double					worstAdvance;	// Seconds.
+	};
+
+	void print_usage()
+	{
+		printf("Plays a ROM as two rollback netplay peers connected by an in-process loopback.\n");
+		printf("\tUsage: EXE <ROM PATH> [FRAMES] [LATENCY MS] [LOSS %%] [INPUT DELAY] [MAX ROLLBACK]\n");
+		printf("\n");
+		printf("Both peers run at the Game Boy frame rate on scripted input for FRAMES frames\n");
+		printf("(default 600), then carry on without input until both have caught up. Their\n");
+		printf("final state is checked against a plain replay of the same input, and rollback\n");
+		printf("and snapshot costs are reported.\n");
+	}
+
+	double elapsed_since(const Clock::time_point& start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Each player holds a few buttons for several frames at a time, so some
+	// predictions hold and some don't. Start and select are left alone, they
+	// pause most games.
+	uint8_t get_script_input(uint32_t player, uint32_t index)
+	{
+		uint32_t hash = ((index / (5 + (player * 4))) + 1) * 2654435761u;
+		hash ^= player * 0x9E3779B9u;
+		hash ^= hash >> 15;
+		hash *= 0x2C1B3C6Du;
+		hash ^= hash >> 12;
+
+		return static_cast<uint8_t>(hash & (hash >> 8) & 0xF3);
+	}
+
+	uint64_t hash_state(gbhw_context_t ctx)
+	{
+		// Video RAM onwards, which covers the banked RAM mapped in, and the screen.
+		std::vector<uint8_t> memory(0x8000);
+		gbhw_read_memory(ctx, 0x8000, memory.data(), static_cast<uint32_t>(memory.size()));
+
+		const uint8_t* screen = nullptr;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		gbhw_get_screen(ctx, &screen);
+		gbhw_get_screen_resolution(ctx, &width, &height);
+
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		for(uint8_t value : memory)
+			hash = (hash ^ value) * 0x100000001B3ull;
+
+		for(uint32_t i = 0; i < (width * height * 4); i++)
+			hash = (hash ^ screen[i]) * 0x100000001B3ull;
+
+		return hash;
+	}
+
+	// Emulates frames with the merged input directly, as a single machine
+	// with both players at it would.
+	uint64_t replay(const char* romPath, const Peer* peers, uint32_t inputDelay, uint32_t frames)
+	{
+		gbhw_context_t ctx			= nullptr;
+		gbhw_settings_t settings	= {0};
+		settings.log_level			= l_disabled;
+		settings.rom_path			= romPath;
+
+		gbhw_create(&settings, &ctx);
+
+		uint8_t held = 0;
+
+		for(uint32_t frame = 0; frame < frames; frame++)
+		{
+			uint8_t buttons = 0;
+
+			for(uint32_t player = 0; player < kPlayers; player++)
+			{
+				if(frame >= inputDelay)
+					buttons |= peers[player].inputs[frame - inputDelay];
+			}
+
+			for(uint32_t button = button_a; button <= button_dpad_down; button++)
+			{
+				if((buttons ^ held) & (1 << button))
+					gbhw_set_button_state(ctx, static_cast<gbhw_button_t>(button), (buttons & (1 << button)) ? button_pressed : button_released);
+			}
+
+			held = buttons;
+			gbhw_step(ctx, step_vsync);
+		}
+
+		const uint64_t hash = hash_state(ctx);
+		gbhw_destroy(ctx);
+		return hash;
+	}
+
+	void print_stats(uint32_t player, const Peer& peer)
+	{
+		const gbhw_netplay_stats_t& stats = peer.stats;
+
+		printf("Peer %u: %u frames, %u stalls, %u rollbacks emulating %u frames again (at most %u)\n",
+			player, stats.frame, stats.stalls, stats.rollbacks, stats.rollback_frames, stats.max_rollback_frames);
+
+		printf("\trollback %.3f ms average, %.3f ms worst. Snapshot %.2f us per frame. Advance %.3f ms worst\n",
+			stats.rollbacks ? (stats.rollback_ns / 1e6) / stats.rollbacks : 0.0,
+			stats.max_rollback_ns / 1e6,
+			stats.frame ? (stats.snapshot_ns / 1e3) / (stats.frame + stats.rollback_frames) : 0.0,
+			peer.worstAdvance * 1e3);
+	}
+
+	//--------------------------------------------------------------------------
+
+	int run(const char* romPath, uint32_t frames, uint32_t latencyMs, uint32_t lossPercent, uint32_t inputDelay, uint32_t maxRollback)
+	{
+		gbhw_loopback_t loopback = nullptr;
+		gbhw_loopback_create(latencyMs, lossPercent, &loopback);
+
+		Peer peers[kPlayers];
+		int result = 0;
+
+		for(uint32_t player = 0; player < kPlayers; player++)
+		{
+			Peer& peer = peers[player];
+			peer.ctx			= nullptr;
+			peer.netplay		= nullptr;
+			peer.worstAdvance	= 0.0;
+			memset(&peer.stats, 0, sizeof(peer.stats));
+
+			gbhw_settings_t settings	= {0};
+			settings.log_level			= l_disabled;
+
+			gbhw_netplay_settings_t netplaySettings	= {0};
+			netplaySettings.player					= player;
+			netplaySettings.input_delay				= inputDelay;
+			netplaySettings.max_rollback			= maxRollback;
+			gbhw_loopback_get_transport(loopback, player, &netplaySettings.transport);
+
+			if((gbhw_create(&settings, &peer.ctx) != e_success) || (gbhw_load_rom_file(peer.ctx, romPath) != e_success))
+			{
+				printf("Failed to load ROM '%s'\n", romPath);
+				result = -1;
+			}
+			else if(gbhw_netplay_create(peer.ctx, &netplaySettings, &peer.netplay) != e_success)
+			{
+				printf("Invalid netplay settings\n");
+				result = -1;
+			}
+		}
+
+		if(result == 0)
+		{
+			printf("Playing '%s' for %u frames, %u ms latency, %u%% loss, %u frames input delay\n", romPath, frames, latencyMs, lossPercent, inputDelay);
+
+			const std::chrono::duration<double> frameTime(70224.0 / 4194304.0);
+			const Clock::time_point start = Clock::now();
+
+			for(uint64_t tick = 1; ; tick++)
+			{
+				for(uint32_t player = 0; player < kPlayers; player++)
+				{
+					Peer& peer = peers[player];
+					const uint32_t index = static_cast<uint32_t>(peer.inputs.size());
+					const uint8_t buttons = (index < frames) ? get_script_input(player, index) : 0;
+
+					const Clock::time_point advanceStart = Clock::now();
+					uint32_t advanced = 0;
+
+					gbhw_netplay_advance(peer.netplay, buttons, &advanced);
+					peer.worstAdvance = std::max(peer.worstAdvance, elapsed_since(advanceStart));
+
+					if(advanced)
+						peer.inputs.push_back(buttons);
+
+					gbhw_netplay_get_stats(peer.netplay, &peer.stats);
+				}
+
+				// Past the script every input is released, once both peers know
+				// that no prediction can be wrong and their states must agree.
+				const uint32_t settled = frames + inputDelay + 1;
+
+				if((peers[0].stats.frame == peers[1].stats.frame) &&
+					(peers[0].stats.confirmed_frames >= settled) && (peers[1].stats.confirmed_frames >= settled))
+				{
+					break;
+				}
+
+				std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(frameTime * static_cast<double>(tick)));
+			}
+
+			for(uint32_t player = 0; player < kPlayers; player++)
+				print_stats(player, peers[player]);
+
+			const uint32_t emulated	= peers[0].stats.frame;
+			const uint64_t expected	= replay(romPath, peers, inputDelay, emulated);
+			bool bMatch				= true;
+
+			for(uint32_t player = 0; player < kPlayers; player++)
+				bMatch &= (hash_state(peers[player].ctx) == expected);
+
+			if(bMatch)
+			{
+				printf("Both peers match a replay of the same input after %u frames (%016" PRIX64 ")\n", emulated, expected);
+			}
+			else
+			{
+				printf("Peers diverged from a replay of the same input after %u frames\n", emulated);
+				result = 1;
+			}
+		}
+
+		for(Peer& peer : peers)
+		{
+			gbhw_netplay_destroy(peer.netplay);
+			gbhw_destroy(peer.ctx);
+		}
+
+		gbhw_loopback_destroy(loopback);
+		return result;
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	if(argc < 2)
+	{
+		print_usage();
+		return -1;
+	}
+
+	const uint32_t frames		= (argc >= 3) ? static_cast<uint32_t>(strtoul(args[2], nullptr, 10)) : 600;
+	const uint32_t latencyMs	= (argc >= 4) ? static_cast<uint32_t>(strtoul(args[3], nullptr, 10)) : 50;
+	const uint32_t lossPercent	= (argc >= 5) ? static_cast<uint32_t>(strtoul(args[4], nullptr, 10)) : 0;
+	const uint32_t inputDelay	= (argc >= 6) ? static_cast<uint32_t>(strtoul(args[5], nullptr, 10)) : 1;
+	const uint32_t maxRollback	= (argc >= 7) ? static_cast<uint32_t>(strtoul(args[6], nullptr, 10)) : 8;
+
+	return run(args[1], frames, latencyMs, lossPercent, inputDelay, maxRollback);
+}
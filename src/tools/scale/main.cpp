@@ -0,0 +1,145 @@
+#include <gbhw.h>
+#include "framebuffer.h"
+#include "simd.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	static const uint32_t kWidth	= 160;
+	static const uint32_t kHeight	= 144;
+
+	const char* kScalerNames[Scaler::Count]		= { "nearest 2x", "nearest 3x", "nearest 4x", "scale2x" };
+	const char* kLevelNames[]					= { "scalar", "sse2", "ssse3", "avx2" };
+
+	void print_usage()
+	{
+		printf("Benchmarks the framebuffer scalers at each supported SIMD level.\n");
+		printf("\tUsage: EXE [-n <ITERATIONS>] [ROM PATH]\n");
+		printf("\n");
+		printf("With a ROM the screen after 300 frames is scaled, otherwise a synthetic\n");
+		printf("image of flat areas and diagonal edges. Vector output is checked against\n");
+		printf("the scalar path.\n");
+	}
+
+	bool load_screen(const char* romPath, std::vector<uint32_t>& screen)
+	{
+		gbhw_context_t ctx			= nullptr;
+		gbhw_settings_t settings	= {0};
+		settings.log_level			= l_disabled;
+
+		bool bLoaded = (gbhw_create(&settings, &ctx) == e_success) && (gbhw_load_rom_file(ctx, romPath) == e_success);
+
+		for(uint32_t i = 0; bLoaded && (i < 300); i++)
+			bLoaded = gbhw_step(ctx, step_vsync) == e_success;
+
+		const uint8_t* pixels = nullptr;
+
+		if(bLoaded && (gbhw_get_screen(ctx, &pixels) == e_success))
+			memcpy(&screen[0], pixels, screen.size() * sizeof(uint32_t));
+
+		gbhw_destroy(ctx);
+		return bLoaded;
+	}
+
+	void make_screen(std::vector<uint32_t>& screen)
+	{
+		static const uint32_t kColours[4] = { 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000 };
+
+		for(uint32_t y = 0; y < kHeight; y++)
+		{
+			for(uint32_t x = 0; x < kWidth; x++)
+				screen[(y * kWidth) + x] = kColours[(((x + y) / 7) ^ ((x / 16) + (y / 12))) & 3];
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	uint32_t iterations = 2000;
+	const char* romPath = nullptr;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if((strcmp(args[i], "-n") == 0) && (i + 1 < argc))
+			iterations = static_cast<uint32_t>(strtoul(args[++i], nullptr, 10));
+		else if(!romPath && args[i][0] != '-')
+			romPath = args[i];
+		else
+		{
+			print_usage();
+			return -1;
+		}
+	}
+
+	std::vector<uint32_t> screen(kWidth * kHeight);
+
+	if(romPath)
+	{
+		if(!load_screen(romPath, screen))
+		{
+			printf("Failed to run ROM '%s'\n", romPath);
+			return -1;
+		}
+	}
+	else
+	{
+		make_screen(screen);
+	}
+
+	const simd::Level::Type supported = simd::get_level();
+	int result = 0;
+
+	printf("%-12s %-8s %12s %12s\n", "scaler", "level", "us/frame", "Mpixel/s");
+
+	for(uint32_t s = 0; s < Scaler::Count; s++)
+	{
+		const Scaler::Type scaler	= static_cast<Scaler::Type>(s);
+		const uint32_t factor		= Scaler::get_factor(scaler);
+		const uint32_t pitch		= kWidth * factor;
+		const uint32_t outputSize	= pitch * kHeight * factor;
+
+		std::vector<uint32_t> reference(outputSize);
+		std::vector<uint32_t> output(outputSize);
+
+		simd::set_level(simd::Level::Scalar);
+		scale(&screen[0], kWidth, kHeight, scaler, &reference[0], pitch);
+
+		for(uint32_t l = simd::Level::Scalar; l <= static_cast<uint32_t>(supported); l++)
+		{
+			// SSSE3 adds nothing the scalers use over SSE2.
+			if(l == simd::Level::SSSE3)
+				continue;
+
+			simd::set_level(static_cast<simd::Level::Type>(l));
+			memset(&output[0], 0, outputSize * sizeof(uint32_t));
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for(uint32_t i = 0; i < iterations; i++)
+				scale(&screen[0], kWidth, kHeight, scaler, &output[0], pitch);
+
+			const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			const bool bMatch = memcmp(&output[0], &reference[0], outputSize * sizeof(uint32_t)) == 0;
+
+			printf("%-12s %-8s %12.2f %12.1f%s\n", kScalerNames[s], kLevelNames[l],
+				   (elapsed * 1000000.0) / iterations, (static_cast<double>(outputSize) * iterations) / (elapsed * 1000000.0),
+				   bMatch ? "" : "  MISMATCH");
+
+			if(!bMatch)
+				result = 1;
+		}
+	}
+
+	simd::set_level(supported);
+	return result;
+}
@@ -0,0 +1,219 @@
+#include <gbhw.h>
+#include <chrono>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	void print_usage()
+	{
+		printf("Shares emulated frames with other processes through a POSIX shared memory frame ring.\n");
+		printf("\tUsage: EXE serve <ROM PATH> <NAME> [SLOTS] [SECONDS]\n");
+		printf("\t       EXE read <NAME> [SECONDS]\n");
+		printf("\n");
+		printf("serve runs the ROM headless as fast as possible, rendering into the ring.\n");
+		printf("read polls the newest frame and reports how many were seen, missed and torn.\n");
+		printf("NAME is a shared memory object name such as /gb_frames.\n");
+	}
+
+	double elapsed_since(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//--------------------------------------------------------------------------
+
+	int serve_frames(const char* romPath, const char* name, uint32_t count, double seconds)
+	{
+		uint32_t size = 0;
+
+		if(gbhw_get_frame_ring_size(count, &size) != e_success)
+		{
+			printf("Invalid slot count %u, at least 2 are required\n", count);
+			return -1;
+		}
+
+		const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+
+		if(fd < 0 || ftruncate(fd, size) != 0)
+		{
+			printf("Failed to create shared memory '%s'\n", name);
+
+			if(fd >= 0)
+				close(fd);
+
+			return -1;
+		}
+
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if(memory == MAP_FAILED)
+		{
+			printf("Failed to map shared memory '%s'\n", name);
+			shm_unlink(name);
+			return -1;
+		}
+
+		gbhw_context_t ctx			= nullptr;
+		gbhw_settings_t settings	= {0};
+		settings.log_level			= l_disabled;
+
+		int result = 0;
+
+		if((gbhw_create(&settings, &ctx) != e_success) || (gbhw_load_rom_file(ctx, romPath) != e_success))
+		{
+			printf("Failed to load ROM '%s'\n", romPath);
+			result = -1;
+		}
+		else if(gbhw_set_frame_ring(ctx, memory, size, count) != e_success)
+		{
+			printf("Failed to attach the frame ring\n");
+			result = -1;
+		}
+		else
+		{
+			printf("Serving '%s' as '%s' (%u slots, %u bytes)\n", romPath, name, count, size);
+
+			const auto start = std::chrono::steady_clock::now();
+			uint64_t frames = 0;
+
+			while((seconds <= 0.0) || (elapsed_since(start) < seconds))
+			{
+				if(gbhw_step(ctx, step_vsync) != e_success)
+				{
+					printf("Hardware failed after %" PRIu64 " frames\n", frames);
+					result = 1;
+					break;
+				}
+
+				frames++;
+			}
+
+			const double elapsed = elapsed_since(start);
+			printf("Served %" PRIu64 " frames in %.2f s (%.1f fps)\n", frames, elapsed, elapsed > 0.0 ? frames / elapsed : 0.0);
+
+			gbhw_set_frame_ring(ctx, nullptr, 0, 0);
+		}
+
+		gbhw_destroy(ctx);
+		munmap(memory, size);
+		shm_unlink(name);
+		return result;
+	}
+
+	//--------------------------------------------------------------------------
+
+	int read_frames(const char* name, double seconds)
+	{
+		const int fd = shm_open(name, O_RDONLY, 0);
+
+		if(fd < 0)
+		{
+			printf("Failed to open shared memory '%s'\n", name);
+			return -1;
+		}
+
+		// The header carries the slot count, map it first to size the full view.
+		void* header = mmap(nullptr, sizeof(gbhw_frame_ring_t), PROT_READ, MAP_SHARED, fd, 0);
+
+		if(header == MAP_FAILED)
+		{
+			printf("Failed to map shared memory '%s'\n", name);
+			close(fd);
+			return -1;
+		}
+
+		uint32_t size = 0;
+		const bool bValid = gbhw_get_frame_ring_size(static_cast<const gbhw_frame_ring_t*>(header)->count, &size) == e_success;
+		munmap(header, sizeof(gbhw_frame_ring_t));
+
+		void* memory = bValid ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+		close(fd);
+
+		if(memory == MAP_FAILED)
+		{
+			printf("Shared memory '%s' doesn't contain a frame ring\n", name);
+			return -1;
+		}
+
+		const gbhw_frame_ring_t* ring = static_cast<const gbhw_frame_ring_t*>(memory);
+		const uint32_t pixelCount = ring->width * ring->height;
+
+		uint64_t lastSequence	= 0;
+		uint64_t frames			= 0;
+		uint64_t missed			= 0;
+		uint64_t torn			= 0;
+		uint32_t checksum		= 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		while((seconds <= 0.0) || (elapsed_since(start) < seconds))
+		{
+			const gbhw_frame_t* frame	= nullptr;
+			const uint8_t* pixels		= nullptr;
+			uint64_t fence				= 0;
+
+			if((gbhw_frame_ring_acquire(ring, &frame, &pixels, &fence) != e_success) || (frame->sequence == lastSequence))
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(500));
+				continue;
+			}
+
+			const uint64_t sequence = frame->sequence;
+			const uint32_t* words = reinterpret_cast<const uint32_t*>(pixels);
+			uint32_t sum = 0;
+
+			for(uint32_t i = 0; i < pixelCount; i++)
+				sum = (sum * 31) + words[i];
+
+			// The writer may have lapped us while reading, discard the frame.
+			if(gbhw_frame_ring_validate(frame, fence) != e_success)
+			{
+				torn++;
+				continue;
+			}
+
+			if(lastSequence != 0 && sequence > lastSequence + 1)
+				missed += sequence - lastSequence - 1;
+
+			lastSequence = sequence;
+			checksum ^= sum;
+			frames++;
+		}
+
+		printf("Read %" PRIu64 " frames, missed %" PRIu64 ", discarded %" PRIu64 " torn (checksum %08X)\n", frames, missed, torn, checksum);
+
+		munmap(memory, size);
+		return 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	if((argc >= 4) && (strcmp(args[1], "serve") == 0))
+	{
+		const uint32_t count = (argc >= 5) ? static_cast<uint32_t>(strtoul(args[4], nullptr, 10)) : 3;
+		const double seconds = (argc >= 6) ? atof(args[5]) : 0.0;
+		return serve_frames(args[2], args[3], count, seconds);
+	}
+
+	if((argc >= 3) && (strcmp(args[1], "read") == 0))
+	{
+		const double seconds = (argc >= 4) ? atof(args[3]) : 0.0;
+		return read_frames(args[2], seconds);
+	}
+
+	print_usage();
+	return -1;
+}
@@ -0,0 +1,92 @@
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace gbhw;
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+	void print_usage()
+	{
+		printf("Converts a binary execution trace into a text log.\n");
+		printf("\tUsage: EXE [-v] <TRACE PATH> [OUTPUT PATH]\n");
+		printf("\t-v\tAppend the ROM bank and cycle count to each line.\n");
+		printf("\n");
+		printf("Lines use the format shared by other emulators for log diffing:\n");
+		printf("\tA:00 F:00 B:00 C:00 D:00 E:00 H:00 L:00 SP:0000 PC:0000 PCMEM:00,00,00,00\n");
+	}
+
+	void write_record(FILE* output, const TraceRecord& record, bool bVerbose)
+	{
+		fprintf(output, "A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X",
+				record.af >> 8, record.af & 0xFF,
+				record.bc >> 8, record.bc & 0xFF,
+				record.de >> 8, record.de & 0xFF,
+				record.hl >> 8, record.hl & 0xFF,
+				record.sp, record.pc,
+				record.mem[0], record.mem[1], record.mem[2], record.mem[3]);
+
+		if(bVerbose)
+			fprintf(output, " BANK:%03X CY:%" PRIu64, record.bank, record.cycle);
+
+		fputc('\n', output);
+	}
+}
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char* args[])
+{
+	bool bVerbose = false;
+	const char* inputPath = nullptr;
+	const char* outputPath = nullptr;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(args[i], "-v") == 0)
+			bVerbose = true;
+		else if(!inputPath)
+			inputPath = args[i];
+		else if(!outputPath)
+			outputPath = args[i];
+		else
+		{
+			print_usage();
+			return -1;
+		}
+	}
+
+	if(!inputPath)
+	{
+		print_usage();
+		return -1;
+	}
+
+	TraceReader reader;
+
+	if(!reader.open(inputPath))
+	{
+		fprintf(stderr, "Failed to open trace '%s'\n", inputPath);
+		return -1;
+	}
+
+	FILE* output = outputPath ? fopen(outputPath, "w") : stdout;
+
+	if(!output)
+	{
+		fprintf(stderr, "Failed to open output '%s'\n", outputPath);
+		return -1;
+	}
+
+	TraceRecord record;
+
+	while(reader.read(record))
+		write_record(output, record, bVerbose);
+
+	if(output != stdout)
+		fclose(output);
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+// ----------------------------------------------------------------------------
+// Headless frame rate benchmark of the web builds under Node.
+//
+//	Usage: node bench.js <ROM PATH> [FRAMES] [BUILD...]
+//
+// Builds default to libgb_hw.js and libgb_hw_mt.js next to this script,
+// whichever exist. Each is run in its own process so the builds don't share
+// a heap, the threaded one needs Node 16.4 or newer for shared wasm memory.
+// ----------------------------------------------------------------------------
+
+const child_process	= require("child_process");
+const fs			= require("fs");
+const path			= require("path");
+
+const kFrameRate	= 4194304 / 70224;
+const kWarmup		= 120;
+
+// ----------------------------------------------------------------------------
+
+function run_build(build, romPath, frames)
+{
+	let rom = fs.readFileSync(romPath);
+	let Module = require(path.resolve(build));
+
+	let run = function()
+	{
+		let romdata = Module._malloc(rom.length);
+		Module.HEAPU8.set(rom, romdata);
+
+		let handle = Module._gbhw_create_web(romdata, rom.length);
+
+		if(handle === 0)
+		{
+			process.send({ error : "Failed to load ROM" });
+			process.exit(1);
+		}
+
+		for(let i = 0; i < kWarmup; i++)
+		{
+			Module._gbhw_step(handle, 0);
+		}
+
+		let start = process.hrtime.bigint();
+
+		for(let i = 0; i < frames; i++)
+		{
+			if(Module._gbhw_step(handle, 0) != 0)
+			{
+				process.send({ error : "Stepping failed after " + i + " frames" });
+				process.exit(1);
+			}
+		}
+
+		let elapsed = Number(process.hrtime.bigint() - start) / 1e9;
+
+		Module._gbhw_destroy(handle);
+		Module._free(romdata);
+
+		process.send({ fps : frames / elapsed });
+		process.exit(0);
+	};
+
+	// asm.js builds may have finished starting up inside require.
+	if(Module.calledRun)
+	{
+		run();
+	}
+	else
+	{
+		Module.onRuntimeInitialized = run;
+	}
+}
+
+function bench(build, romPath, frames)
+{
+	return new Promise(function(resolve)
+	{
+		// Emulator logging is dropped, results come back over IPC.
+		let child = child_process.fork(__filename, ["--run", build, romPath, frames.toString()], { stdio : ["ignore", "ignore", "inherit", "ipc"] });
+		let result = { error : "Exited without a result" };
+
+		child.on("message", function(msg) { result = msg; });
+		child.on("exit", function() { resolve(result); });
+	});
+}
+
+async function main(args)
+{
+	if(args[0] === "--run")
+	{
+		run_build(args[1], args[2], parseInt(args[3]));
+		return 0;
+	}
+
+	if(args.length < 1)
+	{
+		console.log("Usage: node bench.js <ROM PATH> [FRAMES] [BUILD...]");
+		return -1;
+	}
+
+	let romPath	= args[0];
+	let frames	= (args.length >= 2) ? parseInt(args[1]) : 3600;
+	let builds	= args.slice(2);
+
+	if(builds.length === 0)
+	{
+		builds = ["libgb_hw.js", "libgb_hw_mt.js"].map(function(name) { return path.join(__dirname, name); }).filter(fs.existsSync);
+	}
+
+	if(builds.length === 0)
+	{
+		console.log("No builds found, run cmake/scripts/compile_web.py first");
+		return -1;
+	}
+
+	let baseline = 0;
+	let result = 0;
+
+	console.log("%s %s %s %s", "build".padEnd(24), "frames/s".padStart(10), "realtime".padStart(10), "speedup".padStart(10));
+
+	for(let build of builds)
+	{
+		let res = await bench(build, romPath, frames);
+
+		if(res.error !== undefined)
+		{
+			console.log("%s %s", path.basename(build).padEnd(24), res.error);
+			result = 1;
+			continue;
+		}
+
+		if(baseline === 0)
+		{
+			baseline = res.fps;
+		}
+
+		console.log("%s %s %s %s", path.basename(build).padEnd(24), res.fps.toFixed(1).padStart(10),
+					(res.fps / kFrameRate).toFixed(2).padStart(9) + "x", (res.fps / baseline).toFixed(2).padStart(9) + "x");
+	}
+
+	return result;
+}
+
+main(process.argv.slice(2)).then(function(res)
+{
+	if(process.argv[2] !== "--run")
+	{
+		process.exitCode = res;
+	}
+});
+
+// ----------------------------------------------------------------------------
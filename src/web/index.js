@@ -12,14 +12,47 @@ let step = function(timestamp)
 
 window.onload = function()
 {
-	emulator = new Emulator;
-
 	window.onkeydown	= key_down;
 	window.onkeyup		= key_up;
 	document.getElementById("romload").onclick = load_rom;
 
-	// Enter main.
-	window.requestAnimationFrame(step);
+	// The worker build needs simd128 and shared memory, which browsers only
+	// allow on cross-origin isolated pages (COOP/COEP headers).
+	if(supports_worker_build())
+	{
+		emulator = new WorkerEmulator;
+		window.requestAnimationFrame(step);
+	}
+	else
+	{
+		load_script("libgb_hw.js", function()
+		{
+			emulator = new Emulator;
+
+			// Enter main.
+			window.requestAnimationFrame(step);
+		});
+	}
+}
+
+function supports_worker_build()
+{
+	if(typeof SharedArrayBuffer === "undefined" || !self.crossOriginIsolated)
+	{
+		return false;
+	}
+
+	// Smallest module using a v128 instruction, only validates with simd128.
+	return WebAssembly.validate(new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11]));
+}
+
+function load_script(src, onload)
+{
+	var script = document.createElement("script");
+	script.type = "text/javascript";
+	script.src = src;
+	script.onload = onload;
+	document.head.appendChild(script);
 }
 
 // ----------------------------------------------------------------------------
@@ -58,7 +91,11 @@ function load_rom()
 	function loaded_rom()
 	{
 		let data = new Uint8Array(reader.result);
-		emulator.load_rom(data);
+
+		if(emulator !== null)
+		{
+			emulator.load_rom(data);
+		}
 	}
 }
 
@@ -122,13 +159,28 @@ function key_down(event)
 
 function key_up(event)
 {
-	if(event.target === document.body)
+	if(event.target === document.body && emulator !== null)
 	{
 		var k = map_key(event.code);
 		emulator.modify_button_state(k, ButtonState.released);
 	}
 }
 
+// ----------------------------------------------------------------------------
+// Drawing
+// ----------------------------------------------------------------------------
+
+function draw_image(ctx, imagedata, scaling)
+{
+	// Async load up image data into a bitmap that can be drawn scaled.
+	// @todo: This causes a decent amount of buffering.
+	createImageBitmap(imagedata).then(function(image)
+	{
+		ctx.setTransform(scaling, 0, 0, scaling, 0, 0);
+		ctx.drawImage(image, 0, 0);
+	});
+}
+
 // ----------------------------------------------------------------------------
 // Emulator class
 // ----------------------------------------------------------------------------
@@ -160,16 +212,7 @@ class Emulator
 			var screen		= new Uint8ClampedArray(Module.HEAPU8.buffer, screendata, this._screenw * this._screenh * 4);
 			var imagedata	= this._ctx.getImageData(0, 0, this._screenw, this._screenh);
 			imagedata.data.set(screen);
-
-			// Async load up image data into a bitmap that can be drawn scaled.
-			// @todo: This causes a decent amount of buffering.
-			var ctx			= this._ctx;
-			var scaling		= this._scaling;
-			createImageBitmap(imagedata).then(function(image)
-			{
-				ctx.setTransform(scaling, 0, 0, scaling, 0, 0);
-				ctx.drawImage(image, 0, 0);
-			});
+			draw_image(this._ctx, imagedata, this._scaling);
 		}
 	}
 
@@ -218,4 +261,131 @@ class Emulator
 	}
 }
 
-// ----------------------------------------------------------------------------
\ No newline at end of file
+// ----------------------------------------------------------------------------
+// Worker emulator class
+// ----------------------------------------------------------------------------
+
+// Reads the frame ring (gbhw_frame_ring_t) written by the worker in place,
+// mirroring gbhw_frame_ring_acquire/gbhw_frame_ring_validate.
+var FrameRing = Object.freeze(
+{
+	"header_size" : 64,		// Ring header, followed by the slots.
+	"frame_size" : 64,		// Slot header, followed by the pixels.
+	"count" : 2,			// uint32 offsets
+	"slot_size" : 3,
+	"latest" : 4,			// uint64 offsets
+	"fence" : 0,
+	"sequence" : 1
+});
+
+class WorkerEmulator
+{
+	constructor(options)
+	{
+		this._worker = new Worker("worker.js");
+		this._worker.onmessage = this.on_message.bind(this);
+		this._ready = false;
+		this._pending = null;
+		this._buffer = null;
+		this._ring = 0;
+		this._canvas = null;
+		this._ctx = null;
+		this._imagedata = null;
+		this._screenw = 0;
+		this._screenh = 0;
+		this._scaling = 4;
+		this._drawn = 0n;
+	}
+
+	on_message(event)
+	{
+		let msg = event.data;
+
+		switch(msg.type)
+		{
+			case "ready":
+				this._buffer = msg.buffer;
+				this._ring = msg.ring;
+				this._ready = true;
+
+				if(this._pending !== null)
+				{
+					this.load_rom(this._pending);
+					this._pending = null;
+				}
+				break;
+			case "loaded":
+				this._screenw		= msg.width;
+				this._screenh		= msg.height;
+				this._canvas		= document.getElementById("screen");
+				this._canvas.width	= this._screenw * this._scaling;
+				this._canvas.height	= this._screenh * this._scaling;
+				this._ctx			= this._canvas.getContext("2d");
+				this._imagedata		= this._ctx.createImageData(this._screenw, this._screenh);
+				this._drawn			= 0n;
+				break;
+			case "error":
+				console.log(msg.message);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Blits the newest complete frame if it hasn't been drawn yet, emulation
+	// runs on its own clock in the worker.
+	step(timestamp)
+	{
+		if(this._imagedata === null)
+		{
+			return;
+		}
+
+		let header	= new Uint32Array(this._buffer, this._ring, FrameRing.header_size / 4);
+		let latest	= Atomics.load(new BigUint64Array(this._buffer, this._ring, FrameRing.header_size / 8), FrameRing.latest);
+
+		if(latest === 0n || latest === this._drawn)
+		{
+			return;
+		}
+
+		let slot	= this._ring + FrameRing.header_size + (Number((latest - 1n) % BigInt(header[FrameRing.count])) * header[FrameRing.slot_size]);
+		let frame	= new BigUint64Array(this._buffer, slot, 2);
+		let fence	= Atomics.load(frame, FrameRing.fence);
+
+		// Odd is in flight, a different sequence means the worker lapped us.
+		if((fence & 1n) !== 0n || Atomics.load(frame, FrameRing.sequence) !== latest)
+		{
+			return;
+		}
+
+		this._imagedata.data.set(new Uint8Array(this._buffer, slot + FrameRing.frame_size, this._screenw * this._screenh * 4));
+
+		// Torn copies are dropped, the next frame is only a few ms away.
+		if(Atomics.load(frame, FrameRing.fence) !== fence)
+		{
+			return;
+		}
+
+		this._drawn = latest;
+		draw_image(this._ctx, this._imagedata, this._scaling);
+	}
+
+	modify_button_state(button, state)
+	{
+		this._worker.postMessage({ type : "button", button : button, state : state });
+	}
+
+	load_rom(data)
+	{
+		if(!this._ready)
+		{
+			this._pending = data;
+			return;
+		}
+
+		this._worker.postMessage({ type : "load", rom : data });
+	}
+}
+
+// ----------------------------------------------------------------------------
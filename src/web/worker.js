@@ -0,0 +1,143 @@
+// ----------------------------------------------------------------------------
+// Emulation worker for the simd128/threads build. Frames are written to a
+// frame ring in the module's shared memory, the page reads them from there
+// and only ever blits.
+// ----------------------------------------------------------------------------
+
+const kFrameRate	= 4194304 / 70224;
+const kRingFrames	= 3;
+const kMaxCatchUp	= 4;		// Frames run at most per tick after a stall.
+
+let handle		= 0;
+let romdata		= 0;
+let ring		= 0;
+let start		= 0;
+let frames		= 0;
+let timer		= null;
+
+self.Module =
+{
+	print : function(text) { console.log(text); },
+	printErr : function(text) { console.error(text); },
+	onRuntimeInitialized : function()
+	{
+		// Memory can't grow, so the buffer handed to the page stays valid.
+		ring = Module._malloc(get_ring_size());
+		self.postMessage({ type : "ready", buffer : Module.HEAPU8.buffer, ring : ring });
+	}
+};
+
+importScripts("libgb_hw_mt.js");
+
+// ----------------------------------------------------------------------------
+
+function get_ring_size()
+{
+	let sizeptr = Module._malloc(4);
+	Module._gbhw_get_frame_ring_size(kRingFrames, sizeptr);
+	let size = new Uint32Array(Module.HEAPU8.buffer, sizeptr, 1)[0];
+	Module._free(sizeptr);
+	return size;
+}
+
+function load_rom(data)
+{
+	stop();
+
+	if(handle !== 0)
+	{
+		Module._gbhw_destroy(handle);
+		handle = 0;
+	}
+
+	if(romdata !== 0)
+	{
+		Module._free(romdata);
+	}
+
+	romdata = Module._malloc(data.byteLength);
+	Module.HEAPU8.set(data, romdata);
+
+	handle = Module._gbhw_create_web(romdata, data.byteLength);
+
+	if(handle === 0)
+	{
+		self.postMessage({ type : "error", message : "Failed to create the emulator" });
+		return;
+	}
+
+	// The ring is reattached for each context, the page keeps reading the
+	// same memory.
+	Module._gbhw_set_frame_ring(handle, ring, get_ring_size(), kRingFrames);
+
+	self.postMessage(
+	{
+		type : "loaded",
+		width : Module._gbhw_get_screen_resolution_width(handle),
+		height : Module._gbhw_get_screen_resolution_height(handle)
+	});
+
+	start	= performance.now();
+	frames	= 0;
+	tick();
+}
+
+function stop()
+{
+	if(timer !== null)
+	{
+		clearTimeout(timer);
+		timer = null;
+	}
+}
+
+// Runs however many frames are due since the ROM was loaded, so timer jitter
+// doesn't change the emulation speed. Falling far behind resets the clock
+// rather than running a burst of frames.
+function tick()
+{
+	let due = Math.floor(((performance.now() - start) * kFrameRate) / 1000);
+
+	if((due - frames) > kMaxCatchUp)
+	{
+		frames	= due - 1;
+	}
+
+	while(frames < due)
+	{
+		if(Module._gbhw_step(handle, 0) != 0)
+		{
+			self.postMessage({ type : "error", message : "Stepping produced an error" });
+			return;
+		}
+
+		frames++;
+	}
+
+	let next = start + (((frames + 1) * 1000) / kFrameRate);
+	timer = setTimeout(tick, Math.max(0, next - performance.now()));
+}
+
+// ----------------------------------------------------------------------------
+
+self.onmessage = function(event)
+{
+	let msg = event.data;
+
+	switch(msg.type)
+	{
+		case "load":
+			load_rom(msg.rom);
+			break;
+		case "button":
+			if(handle !== 0)
+			{
+				Module._gbhw_set_button_state(handle, msg.button, msg.state);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+// ----------------------------------------------------------------------------